@@ -0,0 +1,494 @@
+/**
+ * Google Benchmark suite for the slot maps and the containers they are usually compared against.
+ * build and run it with: cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench
+ * or by hand from the repository root: c++ -std=c++23 -O2 -DNDEBUG -I. bench/slotmap_bench.cpp -lbenchmark -lpthread -o slotmap_bench
+ * plf::colony baselines are added when plf_colony.h is on the include path.
+ * every benchmark takes the item count as its argument and reports items per second, ResizeHitch additionally reports the slowest Add
+ */
+
+#include "slotmap.hpp"
+#include "pagedslotmap.hpp"
+#include "slotmapquery.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<plf_colony.h>)
+#include <plf_colony.h>
+#define SLOTMAP_BENCH_HAS_COLONY 1
+#else
+#define SLOTMAP_BENCH_HAS_COLONY 0
+#endif
+
+namespace
+{
+    //trivially copyable, 32 bytes
+    struct TrivialItem
+    {
+        float Position[4];
+        float Velocity[4];
+
+        TrivialItem() = default;
+
+        explicit TrivialItem(int64_t Seed)
+            : Position{float(Seed), 0.0f, 0.0f, 1.0f}
+            , Velocity{1.0f, 0.0f, 0.0f, 0.0f}
+        {
+        }
+
+        int64_t Value() const
+        {
+            return static_cast<int64_t>(Position[0]);
+        }
+    };
+
+    //owns heap memory so moves, copies and destruction are not free
+    struct NonTrivialItem
+    {
+        std::string Name;
+        int64_t Seed = 0;
+
+        NonTrivialItem() = default;
+
+        explicit NonTrivialItem(int64_t InSeed)
+            : Name("item name that does not fit the small string buffer")
+            , Seed(InSeed)
+        {
+        }
+
+        int64_t Value() const
+        {
+            return Seed;
+        }
+    };
+
+    struct SplitGenerationTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t IndexBits = 32;
+        static constexpr int64_t IdBits = 32;
+        static constexpr bool SplitGenerations = true;
+    };
+
+    struct CompactKeyTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t IndexBits = 22;
+        static constexpr int64_t IdBits = 10;
+        using KeyStorageT = uint32_t;
+    };
+
+    struct GeometricGrowthTraits : SlotMapDefaultTraits
+    {
+        static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Geometric;
+        static constexpr double ShrinkThreshold = 0.25;
+    };
+
+    struct IncrementalMigrationTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t MigrationBudget = 4;
+    };
+
+    //the benchmarks only talk to containers trough these adapters
+    template<typename MapT>
+    struct SlotMapAdapter
+    {
+        using ItemT = std::remove_reference_t<decltype(*std::declval<MapT&>().begin())>;
+        using HandleT = typename MapT::KeyHandle;
+
+        MapT Map;
+
+        HandleT Add(int64_t Seed)
+        {
+            return Map.Emplace(Seed);
+        }
+
+        ItemT* Find(HandleT Handle)
+        {
+            return Map[Handle];
+        }
+
+        void Remove(HandleT Handle)
+        {
+            Map.Remove(Handle);
+        }
+
+        template<typename FunctionT>
+        void ForEach(FunctionT&& Function)
+        {
+            for(ItemT& Item : Map)
+            {
+                Function(Item);
+            }
+        }
+
+        void Clear()
+        {
+            Map.Clear();
+        }
+    };
+
+    template<typename ItemT>
+    struct UnorderedMapAdapter
+    {
+        using HandleT = uint64_t;
+
+        std::unordered_map<uint64_t, ItemT> Map;
+        uint64_t NextKey = 1;
+
+        HandleT Add(int64_t Seed)
+        {
+            Map.try_emplace(NextKey, Seed);
+            return NextKey++;
+        }
+
+        ItemT* Find(HandleT Handle)
+        {
+            auto Found = Map.find(Handle);
+            return Found != Map.end() ? &Found->second : nullptr;
+        }
+
+        void Remove(HandleT Handle)
+        {
+            Map.erase(Handle);
+        }
+
+        template<typename FunctionT>
+        void ForEach(FunctionT&& Function)
+        {
+            for(auto& [Key, Item] : Map)
+            {
+                Function(Item);
+            }
+        }
+
+        void Clear()
+        {
+            Map.clear();
+        }
+    };
+
+#if SLOTMAP_BENCH_HAS_COLONY
+    //colony iterators are stable but can't be validated, so lookups of removed items are never issued by the benchmarks
+    template<typename ItemT>
+    struct ColonyAdapter
+    {
+        using HandleT = typename plf::colony<ItemT>::iterator;
+
+        plf::colony<ItemT> Map;
+
+        HandleT Add(int64_t Seed)
+        {
+            return Map.emplace(Seed);
+        }
+
+        ItemT* Find(HandleT Handle)
+        {
+            return &*Handle;
+        }
+
+        void Remove(HandleT Handle)
+        {
+            Map.erase(Handle);
+        }
+
+        template<typename FunctionT>
+        void ForEach(FunctionT&& Function)
+        {
+            for(ItemT& Item : Map)
+            {
+                Function(Item);
+            }
+        }
+
+        void Clear()
+        {
+            Map.clear();
+        }
+    };
+#endif
+
+    template<typename AdapterT>
+    std::vector<typename AdapterT::HandleT> Fill(AdapterT& Adapter, int64_t Count)
+    {
+        std::vector<typename AdapterT::HandleT> Handles;
+        Handles.reserve(Count);
+
+        for(int64_t Index = 0; Index < Count; ++Index)
+        {
+            Handles.push_back(Adapter.Add(Index));
+        }
+
+        return Handles;
+    }
+
+    //Count adds into an empty container, includes every resize on the way
+    template<typename AdapterT>
+    void SequentialAdd(benchmark::State& State)
+    {
+        const int64_t Count = State.range(0);
+
+        for(auto _ : State)
+        {
+            AdapterT Adapter;
+
+            for(int64_t Index = 0; Index < Count; ++Index)
+            {
+                benchmark::DoNotOptimize(Adapter.Add(Index));
+            }
+
+            benchmark::ClobberMemory();
+        }
+
+        State.SetItemsProcessed(State.iterations() * Count);
+    }
+
+    //lookups of every live handle in random order
+    template<typename AdapterT>
+    void RandomLookup(benchmark::State& State)
+    {
+        const int64_t Count = State.range(0);
+
+        AdapterT Adapter;
+        auto Handles = Fill(Adapter, Count);
+        std::shuffle(Handles.begin(), Handles.end(), std::mt19937_64(42));
+
+        for(auto _ : State)
+        {
+            int64_t Sum = 0;
+
+            for(const auto& Handle : Handles)
+            {
+                Sum += Adapter.Find(Handle)->Value();
+            }
+
+            benchmark::DoNotOptimize(Sum);
+        }
+
+        State.SetItemsProcessed(State.iterations() * Count);
+    }
+
+    //removes a random item and adds a new one Count times while Count items stay alive
+    template<typename AdapterT>
+    void Churn(benchmark::State& State)
+    {
+        const int64_t Count = State.range(0);
+
+        AdapterT Adapter;
+        auto Handles = Fill(Adapter, Count);
+        std::mt19937_64 Random(42);
+
+        for(auto _ : State)
+        {
+            for(int64_t Index = 0; Index < Count; ++Index)
+            {
+                auto& Handle = Handles[Random() % Count];
+                Adapter.Remove(Handle);
+                Handle = Adapter.Add(Index);
+            }
+
+            benchmark::ClobberMemory();
+        }
+
+        State.SetItemsProcessed(State.iterations() * Count);
+    }
+
+    //touches every item once, after churn so node based containers are not in allocation order
+    template<typename AdapterT>
+    void Iterate(benchmark::State& State)
+    {
+        const int64_t Count = State.range(0);
+
+        AdapterT Adapter;
+        auto Handles = Fill(Adapter, Count);
+        std::mt19937_64 Random(42);
+
+        for(int64_t Index = 0; Index < Count; ++Index)
+        {
+            auto& Handle = Handles[Random() % Count];
+            Adapter.Remove(Handle);
+            Handle = Adapter.Add(Index);
+        }
+
+        for(auto _ : State)
+        {
+            int64_t Sum = 0;
+            Adapter.ForEach([&Sum](const auto& Item)
+            {
+                Sum += Item.Value();
+            });
+
+            benchmark::DoNotOptimize(Sum);
+        }
+
+        State.SetItemsProcessed(State.iterations() * Count);
+    }
+
+    //only the Clear is timed
+    template<typename AdapterT>
+    void Clear(benchmark::State& State)
+    {
+        const int64_t Count = State.range(0);
+
+        AdapterT Adapter;
+
+        for(auto _ : State)
+        {
+            State.PauseTiming();
+            Fill(Adapter, Count);
+            State.ResumeTiming();
+
+            Adapter.Clear();
+            benchmark::ClobberMemory();
+        }
+
+        State.SetItemsProcessed(State.iterations() * Count);
+    }
+
+    //same work as SequentialAdd but every Add is timed on its own, MaxAddNs shows how long the worst resize stalls the caller
+    template<typename AdapterT>
+    void ResizeHitch(benchmark::State& State)
+    {
+        using ClockT = std::chrono::steady_clock;
+
+        const int64_t Count = State.range(0);
+        int64_t MaxAddNs = 0;
+
+        for(auto _ : State)
+        {
+            AdapterT Adapter;
+
+            for(int64_t Index = 0; Index < Count; ++Index)
+            {
+                const ClockT::time_point Start = ClockT::now();
+                benchmark::DoNotOptimize(Adapter.Add(Index));
+                const int64_t AddNs = std::chrono::duration_cast<std::chrono::nanoseconds>(ClockT::now() - Start).count();
+
+                MaxAddNs = std::max(MaxAddNs, AddNs);
+            }
+        }
+
+        State.counters["MaxAddNs"] = benchmark::Counter(static_cast<double>(MaxAddNs));
+        State.SetItemsProcessed(State.iterations() * Count);
+    }
+
+    //three component maps of the same entities, a third of the entities has no velocity and the added order is shuffled
+    struct JoinedMaps
+    {
+        struct EntityTag
+        {
+        };
+
+        SlotMap<TrivialItem, SlotMapDefaultTraits, EntityTag> Positions;
+        SlotMap<TrivialItem, SlotMapDefaultTraits, EntityTag> Velocities;
+        SlotMap<NonTrivialItem, SlotMapDefaultTraits, EntityTag> Names;
+
+        explicit JoinedMaps(int64_t Count)
+        {
+            std::vector<SlotMap<TrivialItem, SlotMapDefaultTraits, EntityTag>::KeyHandle> Handles;
+
+            for(int64_t Index = 0; Index < Count; ++Index)
+            {
+                Handles.push_back(Positions.Emplace(Index));
+                Velocities.Emplace(Index);
+                Names.Emplace(Index);
+            }
+
+            //swap removes scatter the dense order of every map differently
+            std::mt19937_64 Random(42);
+            std::shuffle(Handles.begin(), Handles.end(), Random);
+
+            for(int64_t Index = 0; Index < Count / 3; ++Index)
+            {
+                Velocities.Remove(Handles[Index]);
+            }
+
+            for(int64_t Index = Count / 3; Index < Count / 2; ++Index)
+            {
+                Names.Remove(Handles[Index]);
+                Names.Emplace(Index); //keeps the names map the largest without sharing the handle
+            }
+        }
+    };
+
+    //iterates the smallest map like the query does and looks up the other components per entity
+    void JoinLookup(benchmark::State& State)
+    {
+        JoinedMaps Maps(State.range(0));
+
+        for(auto _ : State)
+        {
+            int64_t Sum = 0;
+
+            for(auto [Handle, Velocity] : Maps.Velocities.Entries())
+            {
+                const TrivialItem* Position = Maps.Positions[Handle];
+                const NonTrivialItem* Name = Maps.Names[Handle];
+
+                if(Position && Name)
+                {
+                    Sum += Position->Value() + Velocity.Value() + Name->Value();
+                }
+            }
+
+            benchmark::DoNotOptimize(Sum);
+        }
+
+        State.SetItemsProcessed(State.iterations() * State.range(0));
+    }
+
+    void JoinQuery(benchmark::State& State)
+    {
+        JoinedMaps Maps(State.range(0));
+        SlotMapQuery Query(Maps.Positions, Maps.Velocities, Maps.Names);
+
+        for(auto _ : State)
+        {
+            int64_t Sum = 0;
+
+            Query.ForEach([&Sum](const TrivialItem& Position, const TrivialItem& Velocity, const NonTrivialItem& Name)
+            {
+                Sum += Position.Value() + Velocity.Value() + Name.Value();
+            });
+
+            benchmark::DoNotOptimize(Sum);
+        }
+
+        State.SetItemsProcessed(State.iterations() * State.range(0));
+    }
+}
+
+#define SLOTMAP_BENCH_CONTAINER(...) \
+    BENCHMARK_TEMPLATE(SequentialAdd, __VA_ARGS__)->RangeMultiplier(16)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(RandomLookup, __VA_ARGS__)->RangeMultiplier(16)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(Churn, __VA_ARGS__)->RangeMultiplier(16)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(Iterate, __VA_ARGS__)->RangeMultiplier(16)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(Clear, __VA_ARGS__)->RangeMultiplier(16)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(ResizeHitch, __VA_ARGS__)->Arg(1 << 20)->Iterations(4)
+
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<TrivialItem>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<NonTrivialItem>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<TrivialItem, SplitGenerationTraits>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<TrivialItem, CompactKeyTraits>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<TrivialItem, GeometricGrowthTraits>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<TrivialItem, IncrementalMigrationTraits>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<SlotMap<NonTrivialItem, IncrementalMigrationTraits>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<PagedSlotMap<TrivialItem>>);
+SLOTMAP_BENCH_CONTAINER(SlotMapAdapter<PagedSlotMap<NonTrivialItem>>);
+
+BENCHMARK(JoinLookup)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+BENCHMARK(JoinQuery)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+
+SLOTMAP_BENCH_CONTAINER(UnorderedMapAdapter<TrivialItem>);
+SLOTMAP_BENCH_CONTAINER(UnorderedMapAdapter<NonTrivialItem>);
+
+#if SLOTMAP_BENCH_HAS_COLONY
+SLOTMAP_BENCH_CONTAINER(ColonyAdapter<TrivialItem>);
+SLOTMAP_BENCH_CONTAINER(ColonyAdapter<NonTrivialItem>);
+#endif
+
+BENCHMARK_MAIN();
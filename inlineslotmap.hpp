@@ -0,0 +1,600 @@
+#ifndef INLINESLOTMAP_HPP
+#define INLINESLOTMAP_HPP
+
+#include "slotmap.hpp"
+
+/**
+ * @description An InlineSlotMap is a SlotMap with a capacity of N items fixed at compile time whose keys, key offsets and items are stored
+ * inside the object itself, so it never allocates and can live on the stack or inside another component.
+ * Index, ID and offset types are the narrowest ones that fit N + SpareKeys keys, a map of 200 items uses 4 byte keys and 1 byte offsets.
+ * Handles, the FIFO freelist, key retirement and swap-with-last removal work exactly like in SlotMap. Copies keep handles valid.
+ * SpareKeys are keys beyond N that stay on the freelist so a removed key is not reused by the very next add.
+ */
+template<typename ItemT, int64_t N, int64_t SpareKeys = std::clamp<int64_t>(N / 8, 1, SlotMapDefaultTraits::MinFreeKeys), typename TagT = ItemT>
+class InlineSlotMap
+{
+public:
+    static_assert(N > 0);
+    static_assert(SpareKeys >= 1, "the freelist needs at least one key to append to");
+
+    static constexpr int64_t KeyCount = N + SpareKeys;
+    static_assert(KeyCount <= (int64_t(1) << 32), "use a SlotMap for large maps");
+
+    using KeyStorageT = std::conditional_t<KeyCount <= (int64_t(1) << 16), uint32_t, uint64_t>;
+    using KeyOffsetT = std::conditional_t<KeyCount <= (int64_t(1) << 8), uint8_t, std::conditional_t<KeyCount <= (int64_t(1) << 16), uint16_t, uint32_t>>;
+
+    static constexpr int64_t IndexBits = std::max<int64_t>(std::bit_width(static_cast<uint64_t>(KeyCount - 1)), 1);
+    static constexpr int64_t IdBits = std::numeric_limits<KeyStorageT>::digits - IndexBits;
+
+    static constexpr uint64_t IndexMax = UINT64_MAX >> (64 - IndexBits);
+    static constexpr uint64_t IdMax = UINT64_MAX >> (64 - IdBits); //keys reaching this id are retired, it is never handed out
+
+    struct ItemKey
+    {
+        //when free, specifies an offset to an item, otherwise to the next free key
+        KeyStorageT Index : IndexBits = 0;
+
+        //id of the item pointed to by Index, 0 is an invalid ID in order to properly represent a null handle
+        KeyStorageT ID : IdBits = 0;
+    };
+
+    using KeyHandle = SlotMapKeyHandle<KeyStorageT, IndexBits, IdBits, TagT>;
+
+    static constexpr KeyHandle NullHandle{.Index = 0, .ID = 0};
+
+    static constexpr size_t ItemAlignment = std::max(alignof(ItemT), SlotMapDefaultTraits::ItemAlignment); //begin() is aligned like the items of a SlotMap
+
+private: //member variables
+
+    ItemKey Keys[KeyCount];
+    KeyOffsetT KeyOffsets[N]; //offset values "owned" by the corresponding item at the same index that is used the get the key of an item
+    alignas(ItemAlignment) std::byte ItemStorage[N * sizeof(ItemT)];
+
+    KeyOffsetT ItemCount;
+
+    KeyOffsetT FreelistHead; //first free key offset FIFO implementation
+    KeyOffsetT FreelistTail; //last free key offset
+
+    KeyOffsetT RetiredKeyCount; //keys whose ID reached IdMax, they are kept off the freelist until RecycleRetiredKeys
+
+public:
+
+    InlineSlotMap()
+        : ItemCount(0)
+        , FreelistHead(0)
+        , FreelistTail(KeyCount - 1)
+        , RetiredKeyCount(0)
+    {
+        for(int64_t Index = 0; Index < KeyCount; ++Index)
+        {
+            Keys[Index].Index = Index + 1;
+            Keys[Index].ID = 1;
+        }
+    }
+
+    //with trivially copyable items the whole map is trivially copyable
+    InlineSlotMap(const InlineSlotMap&) requires std::is_trivially_copyable_v<ItemT> = default;
+    InlineSlotMap& operator=(const InlineSlotMap&) requires std::is_trivially_copyable_v<ItemT> = default;
+    InlineSlotMap(InlineSlotMap&&) requires std::is_trivially_copyable_v<ItemT> = default;
+    InlineSlotMap& operator=(InlineSlotMap&&) requires std::is_trivially_copyable_v<ItemT> = default;
+
+    InlineSlotMap(const InlineSlotMap& Other)
+        : InlineSlotMap()
+    {
+        CopyFrom(Other);
+    }
+
+    InlineSlotMap(InlineSlotMap&& Other) noexcept(std::is_nothrow_move_constructible_v<ItemT>)
+        : InlineSlotMap()
+    {
+        CopyFrom(std::move(Other));
+    }
+
+    InlineSlotMap& operator=(const InlineSlotMap& Other)
+    {
+        [[likely]] if(this != &Other)
+        {
+            DestroyItems();
+            CopyFrom(Other);
+        }
+
+        return *this;
+    }
+
+    InlineSlotMap& operator=(InlineSlotMap&& Other) noexcept(std::is_nothrow_move_constructible_v<ItemT>)
+    {
+        [[likely]] if(this != &Other)
+        {
+            DestroyItems();
+            CopyFrom(std::move(Other));
+        }
+
+        return *this;
+    }
+
+    ~InlineSlotMap() requires std::is_trivially_destructible_v<ItemT> = default;
+
+    ~InlineSlotMap()
+    {
+        DestroyItems();
+    }
+
+    bool IsValidHandle(KeyHandle Handle) const
+    {
+        return Handle.ID != 0 && Handle.Index < static_cast<uint64_t>(KeyCount) && Handle.ID == Keys[Handle.Index].ID;
+    }
+
+    //constructs the item in place from Args like emplace_back: with parentheses if ItemT has a matching constructor, with braces otherwise. no intermediate copies are made
+    template<typename... Ts>
+    KeyHandle Emplace(Ts&&... Args)
+    {
+        [[unlikely]] if(!HasRoomForAdd())
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing N");
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Args)...);
+    }
+
+    //same as Emplace but returns NullHandle instead of asserting when the map is full
+    template<typename... Ts>
+    KeyHandle TryEmplace(Ts&&... Args)
+    {
+        [[unlikely]] if(!HasRoomForAdd())
+        {
+            return NullHandle;
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Args)...);
+    }
+
+    KeyHandle Add(const ItemT& Item)
+    {
+        return Emplace(Item);
+    }
+
+    KeyHandle Add(ItemT&& Item)
+    {
+        return Emplace(std::move(Item));
+    }
+
+    //constructs the item with braces like Add always did, Add(3, 5) on a std::vector<int> stores {3, 5}. Emplace constructs like emplace_back
+    template<typename... Ts>
+    KeyHandle Add(Ts&&... Args)
+    {
+        [[unlikely]] if(!HasRoomForAdd())
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing N");
+        }
+
+        return EmplaceUnchecked<true>(std::forward<Ts>(Args)...);
+    }
+
+    /**
+     * adds Count items constructed in place from Generator(Index) with Index in [0, Count), see SlotMap::AddRange.
+     * the room for all of them is checked once, if OutHandles is not empty it has to fit Count handles and receives them in order
+     */
+    template<typename GeneratorT>
+    void AddRange(int64_t Count, GeneratorT&& Generator, std::span<KeyHandle> OutHandles = {})
+    {
+        SLOTMAP_ASSERT(Count >= 0);
+        SLOTMAP_ASSERT(OutHandles.empty() || std::ssize(OutHandles) >= Count, "not enough space for the output handles");
+
+        [[unlikely]] if(!HasRoomForAdd(Count))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing N");
+        }
+
+        for(int64_t Index = 0; Index < Count; ++Index)
+        {
+            //the item is constructed directly in place when the generator returns a prvalue
+            new(ItemSlot(ItemCount)) ItemT(std::invoke(Generator, Index));
+
+            const KeyHandle Handle = BindFreeKey();
+
+            if(!OutHandles.empty())
+            {
+                OutHandles[Index] = Handle;
+            }
+        }
+    }
+
+    //copies all items in Source, see AddRange
+    void AddN(std::span<const ItemT> Source, std::span<KeyHandle> OutHandles = {})
+    {
+        AddRange(std::ssize(Source), [Source](int64_t Index) -> const ItemT& { return Source[Index]; }, OutHandles);
+    }
+
+    //returns false if the handle was invalid, true otherwise
+    bool Remove(KeyHandle Handle)
+    {
+        if(!IsValidHandle(Handle))
+        {
+            return false;
+        }
+
+        Remove(Keys + Handle.Index);
+        return true;
+    }
+
+    void Remove(uint64_t Index)
+    {
+        SLOTMAP_ASSERT(Index < static_cast<uint64_t>(ItemCount));
+        Remove(Keys + KeyOffsets[Index]);
+    }
+
+    void Remove(ItemT* Item)
+    {
+        Remove(static_cast<uint64_t>(std::distance(Data(), Item)));
+    }
+
+    /**
+     * removes the items of all valid handles, invalid (and duplicate) handles are skipped, see SlotMap::RemoveBatch.
+     * there is no allocation to shrink, so this is the same as removing the handles one by one
+     * @return the number of removed items
+     */
+    int64_t RemoveBatch(std::span<const KeyHandle> Handles)
+    {
+        int64_t RemovedCount = 0;
+
+        for(KeyHandle Handle : Handles)
+        {
+            RemovedCount += Remove(Handle);
+        }
+
+        return RemovedCount;
+    }
+
+    //removes every item in one pass like SlotMap::Clear: invalidates the handles of all items, destroys them and relinks the freelist trough all keys in index order
+    void Clear()
+    {
+        ItemT* Items = Data();
+
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            ItemKey& Key = Keys[KeyOffsets[Index]];
+            Key.ID += 1;
+            RetiredKeyCount += Key.ID == IdMax;
+
+            if constexpr(!std::is_trivially_destructible_v<ItemT>)
+            {
+                Items[Index].ItemT::~ItemT();
+            }
+        }
+
+        ItemCount = 0;
+
+        RelinkFreelist();
+    }
+
+    //number of keys taken out of use because their ID reached IdMax, each one lowers the usable capacity below N once the spare keys are used up
+    int64_t RetiredKeys() const
+    {
+        return RetiredKeyCount;
+    }
+
+    /**
+     * resets the ID of every retired key and puts it back on the freelist.
+     * @warning the caller has to guarantee that no handle to a retired key survived, otherwise old handles can match again
+     * @return the number of recycled keys
+     */
+    int64_t RecycleRetiredKeys()
+    {
+        int64_t RecycledCount = 0;
+
+        for(int64_t Index = 0; Index < KeyCount && RecycledCount < RetiredKeyCount; ++Index)
+        {
+            [[unlikely]] if(Keys[Index].ID == IdMax)
+            {
+                Keys[Index].ID = 1;
+
+                Keys[FreelistTail].Index = Index;
+                FreelistTail = Index;
+
+                RecycledCount += 1;
+            }
+        }
+
+        RetiredKeyCount = 0;
+
+        return RecycledCount;
+    }
+
+    KeyHandle GetHandle(int64_t Index) const
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
+
+        return MakeHandle(KeyOffsets[Index]);
+    }
+
+    KeyHandle GetHandle(const ItemT* Item) const
+    {
+        return GetHandle(std::distance(Data(), Item));
+    }
+
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, KeyHandle Handle)
+    {
+        if(self.IsValidHandle(Handle))
+        {
+            return self.Data() + self.Keys[Handle.Index].Index;
+        }
+
+        return (decltype(self.Data()))nullptr;
+    }
+
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, int64_t Index)
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < self.ItemCount));
+        return self.Data()[Index];
+    }
+
+    template<typename Self>
+    decltype(auto) begin(this Self&& self)
+    {
+        return self.Data();
+    }
+
+    template<typename Self>
+    decltype(auto) end(this Self&& self)
+    {
+        return self.Data() + self.ItemCount;
+    }
+
+    template<typename Self>
+    decltype(auto) AsSpan(this Self&& self)
+    {
+        return std::span(self.begin(), self.end());
+    }
+
+    //a handle and the item it refers to, yielded by Entries so it can be bound as auto [Handle, Item]
+    template<typename EntryItemT>
+    struct Entry
+    {
+        KeyHandle Handle;
+        EntryItemT& Item;
+    };
+
+    //forward iterator over the dense items that rebuilds handles from the key offsets
+    template<typename MapT>
+    class EntryIterator
+    {
+    public:
+        using value_type = Entry<std::conditional_t<std::is_const_v<MapT>, const ItemT, ItemT>>;
+        using difference_type = std::ptrdiff_t;
+
+        EntryIterator() = default;
+
+        EntryIterator(MapT* InMap, int64_t InIndex)
+            : Map(InMap)
+            , Index(InIndex)
+        {
+        }
+
+        value_type operator*() const
+        {
+            return value_type{Map->MakeHandle(Map->KeyOffsets[Index]), Map->Data()[Index]};
+        }
+
+        EntryIterator& operator++()
+        {
+            Index += 1;
+            return *this;
+        }
+
+        EntryIterator operator++(int)
+        {
+            EntryIterator Previous = *this;
+            ++*this;
+            return Previous;
+        }
+
+        bool operator==(const EntryIterator& Other) const
+        {
+            return Index == Other.Index;
+        }
+
+    private:
+        MapT* Map = nullptr;
+        int64_t Index = 0;
+    };
+
+    //the live items paired with their handles: for(auto [Handle, Item] : Map.Entries())
+    template<typename Self>
+    auto Entries(this Self&& self)
+    {
+        using MapT = std::conditional_t<std::is_const_v<std::remove_reference_t<Self>>, const InlineSlotMap, InlineSlotMap>;
+        MapT* Map = &self;
+
+        return std::ranges::subrange(EntryIterator<MapT>(Map, 0), EntryIterator<MapT>(Map, Map->ItemCount));
+    }
+
+    static constexpr int64_t Capacity()
+    {
+        return N;
+    }
+
+    static constexpr int64_t KeyCapacity()
+    {
+        return KeyCount;
+    }
+
+    int64_t Size() const
+    {
+        return ItemCount;
+    }
+
+    int64_t SizeBytes() const
+    {
+        return ItemCount * sizeof(ItemT);
+    }
+
+private:
+
+    //the items, the pointer is only laundered while the storage holds objects
+    template<typename Self>
+    auto Data(this Self&& self)
+    {
+        using PointerT = std::conditional_t<std::is_const_v<std::remove_reference_t<Self>>, const ItemT*, ItemT*>;
+        PointerT Storage = reinterpret_cast<PointerT>(self.ItemStorage);
+
+        [[likely]] if(self.ItemCount != 0)
+        {
+            return std::launder(Storage);
+        }
+
+        return Storage;
+    }
+
+    //raw storage of the item at Index for constructing it
+    void* ItemSlot(int64_t Index)
+    {
+        return ItemStorage + Index * sizeof(ItemT);
+    }
+
+    //at least one key has to stay on the freelist after the add so removed keys always have a tail to append to
+    bool HasRoomForAdd(int64_t Count = 1) const
+    {
+        return ItemCount + Count <= N && ItemCount + RetiredKeyCount + Count < KeyCount;
+    }
+
+    //handle to the key with its current ID
+    KeyHandle MakeHandle(uint64_t KeyIndex) const
+    {
+        return KeyHandle{.Index = static_cast<KeyStorageT>(KeyIndex), .ID = static_cast<KeyStorageT>(Keys[KeyIndex].ID)};
+    }
+
+    //takes the free head key for the item just constructed at ItemCount
+    KeyHandle BindFreeKey()
+    {
+        uint64_t KeyIndex = FreelistHead;
+        ItemKey& Key = Keys[KeyIndex];
+
+        FreelistHead = Key.Index;
+
+        Key.Index = ItemCount;
+        KeyOffsets[ItemCount] = KeyIndex;
+        ItemCount += 1;
+
+        return MakeHandle(KeyIndex);
+    }
+
+    //links every key that is not retired into the freelist in index order, no key may be bound to an item
+    void RelinkFreelist()
+    {
+        int64_t Tail = -1;
+
+        for(int64_t Index = 0; Index < KeyCount; ++Index)
+        {
+            [[unlikely]] if(Keys[Index].ID == IdMax)
+            {
+                continue;
+            }
+
+            if(Tail < 0)
+            {
+                FreelistHead = Index;
+            }
+            else
+            {
+                Keys[Tail].Index = Index;
+            }
+
+            Tail = Index;
+        }
+
+        FreelistTail = std::max<int64_t>(Tail, 0);
+    }
+
+    //expects HasRoomForAdd, Braced always uses braces like Add
+    template<bool Braced = false, typename... Ts>
+    KeyHandle EmplaceUnchecked(Ts&&... Args)
+    {
+        //construct before touching the freelist so a throwing constructor leaves the map unchanged
+        if constexpr(!Braced && std::is_constructible_v<ItemT, Ts&&...>)
+        {
+            new(ItemSlot(ItemCount)) ItemT(std::forward<Ts>(Args)...);
+        }
+        else //aggregates and braced initialization
+        {
+            new(ItemSlot(ItemCount)) ItemT{std::forward<Ts>(Args)...};
+        }
+
+        return BindFreeKey();
+    }
+
+    void Remove(ItemKey* Key) __attribute_nonnull__((2))
+    {
+        ItemT* Items = Data(); //while the removed item still counts
+        Key->ID += 1; //invalidate handles to this key.
+        ItemCount -= 1;
+
+        ItemKey& LastKey = Keys[KeyOffsets[ItemCount]];
+        uint64_t Hole = Key->Index;
+
+        if(Hole != LastKey.Index) //move the last item and its key offset into the hole
+        {
+            Items[Hole] = std::move(Items[ItemCount]);
+            KeyOffsets[Hole] = KeyOffsets[ItemCount];
+        }
+
+        Items[ItemCount].ItemT::~ItemT();
+        LastKey.Index = Hole;
+
+        [[unlikely]] if(Key->ID == IdMax) //used up, keep it off the freelist
+        {
+            RetiredKeyCount += 1;
+        }
+        else
+        {
+            ItemKey& TailKey = Keys[FreelistTail];
+            TailKey.Index = std::distance(Keys, Key);
+            FreelistTail = TailKey.Index;
+        }
+    }
+
+    //destroys the items without touching the keys, the caller overwrites or drops them
+    void DestroyItems()
+    {
+        if constexpr(!std::is_trivially_destructible_v<ItemT>)
+        {
+            ItemT* Items = Data();
+
+            for(int64_t Index = 0; Index < ItemCount; ++Index)
+            {
+                Items[Index].ItemT::~ItemT();
+            }
+        }
+
+        ItemCount = 0;
+    }
+
+    //expects no items, copies or moves the items of Other and takes over its keys so handles to Other stay valid for this map
+    template<typename OtherT>
+    void CopyFrom(OtherT&& Other)
+    {
+        auto* OtherItems = Other.Data();
+
+        for(; ItemCount < Other.ItemCount; ++ItemCount) //counting up keeps the destructor correct if a copy throws
+        {
+            if constexpr(std::is_rvalue_reference_v<OtherT&&>)
+            {
+                new(ItemSlot(ItemCount)) ItemT(std::move(OtherItems[ItemCount]));
+            }
+            else
+            {
+                new(ItemSlot(ItemCount)) ItemT(OtherItems[ItemCount]);
+            }
+        }
+
+        std::copy_n(Other.Keys, KeyCount, Keys);
+        std::copy_n(Other.KeyOffsets, N, KeyOffsets);
+
+        FreelistHead = Other.FreelistHead;
+        FreelistTail = Other.FreelistTail;
+        RetiredKeyCount = Other.RetiredKeyCount;
+    }
+};
+
+#endif //INLINESLOTMAP_HPP
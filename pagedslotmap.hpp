@@ -0,0 +1,605 @@
+#ifndef PAGEDSLOTMAP_HPP
+#define PAGEDSLOTMAP_HPP
+
+#include "slotmap.hpp"
+
+/**
+ * @description A PagedSlotMap is a SlotMap whose items and key offsets live in fixed size pages of Traits::AllocationSize elements
+ * which are found trough a page table. Growing only allocates one new page and never moves an item, so pointers to items stay valid
+ * until the item itself is removed or swapped into a hole, and there is no O(n) hitch when a large map grows.
+ * Keys, handles and the freelist work exactly like in SlotMap. Use ForEachPage for loops that should see contiguous memory.
+ */
+template<typename ItemT, typename Traits = SlotMapDefaultTraits, typename TagT = ItemT>
+class PagedSlotMap : public SlotMapKeyTable<Traits, TagT>
+{
+    using KeyTable = SlotMapKeyTable<Traits, TagT>;
+
+public:
+    //Traits::AllocationSize is the page size, the key table already requires it to be a power of two
+
+    using typename KeyTable::KeyOffsetT;
+    using typename KeyTable::KeyStorageT;
+    using typename KeyTable::AllocatorT;
+    using typename KeyTable::ItemKey;
+    using typename KeyTable::KeyHandle;
+    using typename KeyTable::GenerationT;
+
+    using KeyTable::IndexMax;
+    using KeyTable::IdMax;
+    using KeyTable::KeyCountMax;
+    using KeyTable::NullHandle;
+
+    static constexpr int64_t PageSize = Traits::AllocationSize;
+    static constexpr int64_t PageShift = std::countr_zero(static_cast<uint64_t>(PageSize));
+    static constexpr int64_t PageMask = PageSize - 1;
+
+    static constexpr size_t ItemAlignment = std::max(alignof(ItemT), Traits::ItemAlignment); //every page is aligned to this
+
+private: //member variables
+
+    struct Page
+    {
+        ItemT* Items;
+        KeyOffsetT* KeyOffsets;
+    };
+
+    using KeyTable::Keys;
+    using KeyTable::Generations;
+    using KeyTable::KeyCount;
+    using KeyTable::FreelistHead;
+    using KeyTable::FreelistTail;
+    using KeyTable::RetiredKeyCount;
+
+    Page* Pages;
+
+    int64_t ItemCount;
+    int64_t PageCount; //allocated pages, the item capacity is PageCount * PageSize
+    int64_t PageTableCapacity;
+
+    [[no_unique_address]] AllocatorT Allocator;
+
+public:
+
+    template<bool IsConst>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ItemT;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const ItemT*, ItemT*>;
+        using reference = std::conditional_t<IsConst, const ItemT&, ItemT&>;
+
+        Iterator() = default;
+
+        Iterator(const Page* InPages, int64_t InIndex)
+            : Pages(InPages)
+            , Index(InIndex)
+        {
+        }
+
+        reference operator*() const
+        {
+            return Pages[Index >> PageShift].Items[Index & PageMask];
+        }
+
+        pointer operator->() const
+        {
+            return &**this;
+        }
+
+        Iterator& operator++()
+        {
+            ++Index;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator Previous = *this;
+            ++Index;
+            return Previous;
+        }
+
+        bool operator==(const Iterator& Other) const
+        {
+            return Index == Other.Index;
+        }
+
+    private:
+        const Page* Pages = nullptr;
+        int64_t Index = 0;
+    };
+
+    PagedSlotMap(const PagedSlotMap&) = delete;
+    PagedSlotMap(PagedSlotMap&&) = delete;
+
+    PagedSlotMap()
+        : PagedSlotMap(AllocatorT{})
+    {
+    }
+
+    explicit PagedSlotMap(const AllocatorT& InAllocator)
+        : Pages(nullptr)
+        , ItemCount(0)
+        , PageCount(0)
+        , PageTableCapacity(0)
+        , Allocator(InAllocator)
+    {
+    }
+
+    ~PagedSlotMap()
+    {
+        if constexpr(!std::is_trivially_destructible_v<ItemT>)
+        {
+            for(int64_t Index = 0; Index < ItemCount; ++Index)
+            {
+                ItemAt(Index).ItemT::~ItemT();
+            }
+        }
+
+        while(PageCount != 0)
+        {
+            FreeLastPage();
+        }
+
+        if(Pages)
+        {
+            DeallocateArray(Pages, PageTableCapacity, alignof(Page));
+        }
+
+        if(Keys)
+        {
+            DeallocateArray(Keys, KeyCount, alignof(ItemKey));
+        }
+
+        if(Generations)
+        {
+            DeallocateArray(Generations, KeyCount, alignof(GenerationT));
+        }
+    }
+
+    bool IsValidHandle(KeyHandle Handle) const
+    {
+        return IsLiveHandle(Handle);
+    }
+
+    template<typename... Ts>
+    KeyHandle Emplace(Ts&&... Args)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Args)...);
+    }
+
+    //same as Emplace but returns NullHandle instead of asserting when IndexMax or a fixed capacity is reached
+    template<typename... Ts>
+    KeyHandle TryEmplace(Ts&&... Args)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            return NullHandle;
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Args)...);
+    }
+
+    KeyHandle Add(const ItemT& Item)
+    {
+        return Emplace(Item);
+    }
+
+    KeyHandle Add(ItemT&& Item)
+    {
+        return Emplace(std::move(Item));
+    }
+
+    //constructs the item with braces like Add always did, Add(3, 5) on a std::vector<int> stores {3, 5}. Emplace constructs like emplace_back
+    template<typename... Ts>
+    KeyHandle Add(Ts&&... Args)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        return EmplaceUnchecked<true>(std::forward<Ts>(Args)...);
+    }
+
+    /**
+     * adds Count items constructed in place from Generator(Index) with Index in [0, Count), see SlotMap::AddRange.
+     * the pages and keys are grown at most once for the whole range, if OutHandles is not empty it has to fit Count handles and receives them in order
+     */
+    template<typename GeneratorT>
+    void AddRange(int64_t Count, GeneratorT&& Generator, std::span<KeyHandle> OutHandles = {})
+    {
+        SLOTMAP_ASSERT(Count >= 0);
+        SLOTMAP_ASSERT(OutHandles.empty() || std::ssize(OutHandles) >= Count, "not enough space for the output handles");
+
+        [[unlikely]] if(!ReserveForAdd(Count))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        for(int64_t Index = 0; Index < Count; ++Index)
+        {
+            //the item is constructed directly in place when the generator returns a prvalue
+            new(&ItemAt(ItemCount)) ItemT(std::invoke(Generator, Index));
+
+            uint64_t KeyIndex = BindFreeKey(ItemCount);
+            OffsetAt(ItemCount) = KeyIndex;
+            ItemCount += 1;
+
+            if(!OutHandles.empty())
+            {
+                OutHandles[Index] = MakeHandle(KeyIndex);
+            }
+        }
+    }
+
+    //copies all items in Source, see AddRange
+    void AddN(std::span<const ItemT> Source, std::span<KeyHandle> OutHandles = {})
+    {
+        AddRange(std::ssize(Source), [Source](int64_t Index) -> const ItemT& { return Source[Index]; }, OutHandles);
+    }
+
+    //returns false if the handle was invalid, true otherwise
+    bool Remove(KeyHandle Handle)
+    {
+        if(!IsValidHandle(Handle))
+        {
+            return false;
+        }
+
+        Remove(Keys + Handle.Index);
+        return true;
+    }
+
+    void Remove(uint64_t Index)
+    {
+        SLOTMAP_ASSERT(Index < static_cast<uint64_t>(ItemCount));
+        Remove(Keys + OffsetAt(Index));
+    }
+
+    /**
+     * removes every item in one pass like SlotMap::Clear: invalidates the handles of all items, destroys them and relinks the freelist
+     * trough all keys in index order. KeepCapacity keeps every page for refilling, otherwise pages are freed like after Remove
+     */
+    void Clear(bool KeepCapacity = false)
+    {
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            RetiredKeyCount += BumpKeyID(OffsetAt(Index)) == IdMax;
+
+            if constexpr(!std::is_trivially_destructible_v<ItemT>)
+            {
+                ItemAt(Index).ItemT::~ItemT();
+            }
+        }
+
+        ItemCount = 0;
+
+        RelinkFreelist();
+
+        if(!KeepCapacity)
+        {
+            FreeSparePages();
+        }
+    }
+
+    KeyHandle GetHandle(int64_t Index) const
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
+
+        return MakeHandle(OffsetAt(Index));
+    }
+
+    //returns a pointer to the item, nullptr if the handle is invalid
+    template<typename Self>
+    auto operator[](this Self&& self, KeyHandle Handle)
+    {
+        using PointerT = std::conditional_t<std::is_const_v<std::remove_reference_t<Self>>, const ItemT*, ItemT*>;
+
+        if(self.IsValidHandle(Handle))
+        {
+            return static_cast<PointerT>(&self.ItemAt(self.Keys[Handle.Index].Index));
+        }
+
+        return static_cast<PointerT>(nullptr);
+    }
+
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, int64_t Index)
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < self.ItemCount));
+        return self.ItemAt(Index);
+    }
+
+    //calls Function with a span over the items of every page in dense order
+    template<typename Self, typename FunctionT>
+    void ForEachPage(this Self&& self, FunctionT&& Function)
+    {
+        for(int64_t First = 0; First < self.ItemCount; First += PageSize)
+        {
+            auto* Items = self.Pages[First >> PageShift].Items;
+
+            if constexpr(std::is_const_v<std::remove_reference_t<Self>>)
+            {
+                Function(std::span<const ItemT>(Items, std::min(PageSize, self.ItemCount - First)));
+            }
+            else
+            {
+                Function(std::span<ItemT>(Items, std::min(PageSize, self.ItemCount - First)));
+            }
+        }
+    }
+
+    Iterator<false> begin()
+    {
+        return Iterator<false>(Pages, 0);
+    }
+
+    Iterator<false> end()
+    {
+        return Iterator<false>(Pages, ItemCount);
+    }
+
+    Iterator<true> begin() const
+    {
+        return Iterator<true>(Pages, 0);
+    }
+
+    Iterator<true> end() const
+    {
+        return Iterator<true>(Pages, ItemCount);
+    }
+
+    //grows the allocations to fit at least ItemCapacity items and KeyCapacity keys, never shrinks
+    void Reserve(int64_t ItemCapacity, int64_t KeyCapacity)
+    {
+        SLOTMAP_ASSERT(KeyCapacity <= KeyCountMax, "reached max index. consider increasing IndexBits");
+
+        if(KeyCapacity > KeyCount)
+        {
+            ResizeKeys(KeyCapacity);
+        }
+
+        while(PageCount * PageSize < ItemCapacity)
+        {
+            AddPage();
+        }
+    }
+
+    //reserves enough keys for ItemCapacity items
+    void Reserve(int64_t ItemCapacity)
+    {
+        Reserve(ItemCapacity, std::min(RequiredKeyCount(ItemCapacity), KeyCountMax));
+    }
+
+    //frees every page past the last item, keys are kept since their IDs have to outlive any handle
+    void ShrinkToFit()
+    {
+        while(PageCount * PageSize >= ItemCount + PageSize)
+        {
+            FreeLastPage();
+        }
+    }
+
+    int64_t Capacity() const
+    {
+        return PageCount * PageSize;
+    }
+
+    int64_t Size() const
+    {
+        return ItemCount;
+    }
+
+    int64_t SizeBytes() const
+    {
+        return ItemCount * sizeof(ItemT);
+    }
+
+    const AllocatorT& GetAllocator() const
+    {
+        return Allocator;
+    }
+
+private:
+
+    using KeyTable::IsLiveHandle;
+    using KeyTable::MakeHandle;
+    using KeyTable::BumpKeyID;
+    using KeyTable::BindFreeKey;
+    using KeyTable::ReleaseKey;
+    using KeyTable::RelinkFreelist;
+    using KeyTable::LinkNewKeys;
+    using KeyTable::RequiredKeyCount;
+    using KeyTable::KeyCountForAdd;
+    using KeyTable::SparseCapacity;
+
+    template<typename Self>
+    decltype(auto) ItemAt(this Self&& self, int64_t Index)
+    {
+        return self.Pages[Index >> PageShift].Items[Index & PageMask];
+    }
+
+    template<typename Self>
+    decltype(auto) OffsetAt(this Self&& self, int64_t Index)
+    {
+        return self.Pages[Index >> PageShift].KeyOffsets[Index & PageMask];
+    }
+
+    //expects ReserveForAdd to have made room for the item, Braced always uses braces like Add
+    template<bool Braced = false, typename... Ts>
+    KeyHandle EmplaceUnchecked(Ts&&... Args)
+    {
+        ItemT* Item = &ItemAt(ItemCount);
+
+        if constexpr(!Braced && std::is_constructible_v<ItemT, Ts&&...>)
+        {
+            new(Item) ItemT(std::forward<Ts>(Args)...);
+        }
+        else
+        {
+            new(Item) ItemT{std::forward<Ts>(Args)...};
+        }
+
+        uint64_t KeyIndex = BindFreeKey(ItemCount);
+        OffsetAt(ItemCount) = KeyIndex;
+        ItemCount += 1;
+
+        return MakeHandle(KeyIndex);
+    }
+
+    void Remove(ItemKey* Key) __attribute_nonnull__((2))
+    {
+        const uint64_t KeyIndex = std::distance(Keys, Key);
+        BumpKeyID(KeyIndex); //invalidate handles to this key.
+        ItemCount -= 1;
+
+        ItemKey& LastKey = Keys[OffsetAt(ItemCount)];
+        uint64_t Hole = Key->Index;
+
+        if(Hole != LastKey.Index) //move the last item into the hole
+        {
+            ItemAt(Hole) = std::move(ItemAt(ItemCount));
+            OffsetAt(Hole) = OffsetAt(ItemCount);
+        }
+
+        ItemAt(ItemCount).ItemT::~ItemT();
+        LastKey.Index = Hole;
+
+        ReleaseKey(KeyIndex);
+
+        FreeSparePages();
+    }
+
+    //frees the pages SlotMap would shrink its items by, so the growth policy and Traits::ShrinkThreshold mean the same for both maps
+    void FreeSparePages()
+    {
+        const int64_t TargetCapacity = SparseCapacity(PageCount * PageSize, ItemCount); //a multiple of the page size
+
+        while(PageCount * PageSize > TargetCapacity)
+        {
+            FreeLastPage();
+        }
+    }
+
+    //keys grow like in SlotMap, rounded to Traits::AllocationSize which is the page size here
+    bool ReserveForAdd(int64_t Count)
+    {
+        const int64_t RequiredItems = ItemCount + Count;
+        const int64_t NewKeyCount = KeyCountForAdd(RequiredItems);
+
+        [[unlikely]] if(NewKeyCount != KeyCount)
+        {
+            if(NewKeyCount < 0)
+            {
+                return false;
+            }
+
+            ResizeKeys(NewKeyCount);
+        }
+
+        while(RequiredItems > PageCount * PageSize)
+        {
+            if(Traits::GrowthPolicy == SlotMapGrowthPolicy::Fixed)
+            {
+                return false;
+            }
+
+            AddPage();
+        }
+
+        return true;
+    }
+
+    void AddPage()
+    {
+        [[unlikely]] if(PageCount == PageTableCapacity) //only the table of page pointers is ever copied
+        {
+            int64_t NewCapacity = std::max<int64_t>(PageTableCapacity * 2, 8);
+            Page* NewPages = AllocateArray<Page>(NewCapacity, alignof(Page), 0);
+
+            if(Pages)
+            {
+                std::memcpy(NewPages, Pages, PageCount * sizeof(Page));
+                DeallocateArray(Pages, PageTableCapacity, alignof(Page));
+            }
+
+            Pages = NewPages;
+            PageTableCapacity = NewCapacity;
+        }
+
+        Pages[PageCount] = Page{
+            .Items = AllocateArray<ItemT>(PageSize, ItemAlignment, Traits::ItemPaddingBytes),
+            .KeyOffsets = AllocateArray<KeyOffsetT>(PageSize, alignof(KeyOffsetT), 0)
+        };
+
+        PageCount += 1;
+    }
+
+    void FreeLastPage()
+    {
+        PageCount -= 1;
+
+        DeallocateArray(Pages[PageCount].Items, PageSize, ItemAlignment, Traits::ItemPaddingBytes);
+        DeallocateArray(Pages[PageCount].KeyOffsets, PageSize, alignof(KeyOffsetT));
+    }
+
+    void ResizeKeys(int64_t Count)
+    {
+        SLOTMAP_ASSERT(Count >= KeyCount, "shrinking key allocation is not allowed");
+
+        if(Count != KeyCount)
+        {
+            int64_t OldKeyCount = KeyCount;
+            KeyCount = Count;
+
+            auto* NewKeys = AllocateArray<ItemKey>(KeyCount, alignof(ItemKey), 0);
+
+            if(Keys)
+            {
+                std::memcpy(NewKeys, Keys, OldKeyCount * sizeof(ItemKey));
+                DeallocateArray(Keys, OldKeyCount, alignof(ItemKey));
+            }
+
+            Keys = NewKeys;
+
+            if constexpr(Traits::SplitGenerations)
+            {
+                auto* NewGenerations = AllocateArray<GenerationT>(KeyCount, alignof(GenerationT), 0);
+
+                if(Generations)
+                {
+                    std::memcpy(NewGenerations, Generations, OldKeyCount * sizeof(GenerationT));
+                    DeallocateArray(Generations, OldKeyCount, alignof(GenerationT));
+                }
+
+                Generations = NewGenerations;
+            }
+
+            LinkNewKeys(OldKeyCount);
+        }
+    }
+
+    template<typename T>
+    T* AllocateArray(int64_t Count, size_t Alignment, size_t Padding)
+    {
+        auto* Memory = static_cast<T*>(Allocator.Allocate(Count * sizeof(T) + Padding, Alignment));
+        SLOTMAP_ASSERT(Memory != nullptr, "out of memory");
+        return Memory;
+    }
+
+    template<typename T>
+    void DeallocateArray(T* Memory, int64_t Count, size_t Alignment, size_t Padding = 0)
+    {
+        Allocator.Deallocate(Memory, Count * sizeof(T) + Padding, Alignment);
+    }
+};
+
+#endif //PAGEDSLOTMAP_HPP
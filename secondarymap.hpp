@@ -0,0 +1,778 @@
+#ifndef SECONDARYMAP_HPP
+#define SECONDARYMAP_HPP
+
+#include "slotmap.hpp"
+
+enum class SecondaryMapLayout
+{
+    Sparse, //values live in lazily allocated pages indexed by the key index, cheapest lookup
+    Dense //values are packed into one array with their own swap remove, a paged index maps key indices to it
+};
+
+template<typename ValueT, typename HandleT, SecondaryMapLayout Layout = SecondaryMapLayout::Sparse, typename Traits = SlotMapDefaultTraits>
+class SecondaryMap;
+
+/**
+ * @description A SecondaryMap attaches values to a subset of the items of a primary slot map. It is indexed by the Index of the primary
+ * map's handles and stores the ID of the handle each value was added with, so a value only matches handles with the same ID and
+ * values of removed primary items never resurface for the key's next item. No hashing is done and nothing is shared with the primary map,
+ * values of removed items linger until they are overwritten by the key's next item, removed or dropped by RemoveStale.
+ * Pages hold Traits::AllocationSize values and are only allocated for key index ranges that hold a value.
+ * Replacing a value move assigns the new one over the old one like SlotMap does with its items, so ValueT has to be move assignable.
+ */
+template<typename ValueT, typename HandleT, typename Traits>
+class SecondaryMap<ValueT, HandleT, SecondaryMapLayout::Sparse, Traits>
+{
+public:
+    static_assert(Traits::AllocationSize > 0);
+    static_assert((Traits::AllocationSize & (Traits::AllocationSize - 1)) == 0, "AllocationSize is the page size and has to be a power of two");
+    static_assert(std::is_move_assignable_v<ValueT>, "a replaced value is move assigned");
+
+    using KeyStorageT = decltype(std::declval<HandleT>().ToBits());
+    using AllocatorT = typename Traits::AllocatorT;
+
+    static constexpr int64_t PageSize = Traits::AllocationSize;
+    static constexpr int64_t PageShift = std::countr_zero(static_cast<uint64_t>(PageSize));
+    static constexpr int64_t PageMask = PageSize - 1;
+
+private: //member variables
+
+    struct Page
+    {
+        KeyStorageT IDs[PageSize]; //ID of the handle the value at the same index was added with, 0 if there is none
+        int64_t Count;
+        alignas(ValueT) std::byte Values[PageSize * sizeof(ValueT)];
+    };
+
+    Page** Pages; //nullptr for every page without values
+    int64_t PageCount;
+
+    int64_t ItemCount;
+
+    [[no_unique_address]] AllocatorT Allocator;
+
+public:
+
+    SecondaryMap(const SecondaryMap&) = delete;
+    SecondaryMap& operator=(const SecondaryMap&) = delete;
+
+    //the pages are owned trough pointers, values never move
+    SecondaryMap(SecondaryMap&& Other) noexcept
+        : SecondaryMap(Other.Allocator)
+    {
+        Swap(Other);
+    }
+
+    SecondaryMap& operator=(SecondaryMap&& Other) noexcept
+    {
+        SecondaryMap Moved(std::move(Other));
+        Swap(Moved);
+        return *this;
+    }
+
+    SecondaryMap()
+        : SecondaryMap(AllocatorT{})
+    {
+    }
+
+    explicit SecondaryMap(const AllocatorT& InAllocator)
+        : Pages(nullptr)
+        , PageCount(0)
+        , ItemCount(0)
+        , Allocator(InAllocator)
+    {
+    }
+
+    void Swap(SecondaryMap& Other) noexcept
+    {
+        using std::swap;
+        swap(Pages, Other.Pages);
+        swap(PageCount, Other.PageCount);
+        swap(ItemCount, Other.ItemCount);
+        swap(Allocator, Other.Allocator);
+    }
+
+    friend void swap(SecondaryMap& Left, SecondaryMap& Right) noexcept
+    {
+        Left.Swap(Right);
+    }
+
+    ~SecondaryMap()
+    {
+        Clear();
+
+        if(Pages)
+        {
+            Allocator.Deallocate(Pages, PageCount * sizeof(Page*), alignof(Page*));
+        }
+    }
+
+    bool Contains(HandleT Handle) const
+    {
+        return (*this)[Handle] != nullptr;
+    }
+
+    //returns a pointer to the value added for Handle, nullptr if there is none
+    template<typename Self>
+    auto operator[](this Self&& self, HandleT Handle)
+    {
+        using PointerT = std::conditional_t<std::is_const_v<std::remove_reference_t<Self>>, const ValueT*, ValueT*>;
+
+        const int64_t PageIndex = Handle.Index >> PageShift;
+        const int64_t Slot = Handle.Index & PageMask;
+
+        [[likely]] if(PageIndex < self.PageCount && self.Pages[PageIndex] != nullptr && Handle.ID != 0 && self.Pages[PageIndex]->IDs[Slot] == Handle.ID)
+        {
+            return static_cast<PointerT>(ValueAt(self.Pages[PageIndex], Slot));
+        }
+
+        return static_cast<PointerT>(nullptr);
+    }
+
+    /**
+     * constructs the value for Handle in place from Args, replacing the value of any earlier handle to the same key
+     * @return the new value
+     */
+    template<typename... Ts>
+    ValueT& Emplace(HandleT Handle, Ts&&... Args)
+    {
+        SLOTMAP_ASSERT(Handle.ID != 0, "can't add a value for the null handle");
+
+        Page* Target = FindOrAddPage(Handle.Index >> PageShift);
+        const int64_t Slot = Handle.Index & PageMask;
+
+        ValueT* Value = ValueAt(Target, Slot);
+
+        if(Target->IDs[Slot] != 0) //replace in place, a throwing constructor leaves the old value and the counts untouched
+        {
+            if constexpr(std::is_constructible_v<ValueT, Ts&&...>)
+            {
+                *Value = ValueT(std::forward<Ts>(Args)...);
+            }
+            else
+            {
+                *Value = ValueT{std::forward<Ts>(Args)...};
+            }
+
+            Target->IDs[Slot] = Handle.ID;
+
+            return *Value;
+        }
+
+        ConstructValue(Value, std::forward<Ts>(Args)...);
+        Target->IDs[Slot] = Handle.ID;
+        Target->Count += 1;
+        ItemCount += 1;
+
+        return *Value;
+    }
+
+    ValueT& Add(HandleT Handle, const ValueT& Value)
+    {
+        return Emplace(Handle, Value);
+    }
+
+    ValueT& Add(HandleT Handle, ValueT&& Value)
+    {
+        return Emplace(Handle, std::move(Value));
+    }
+
+    //returns false if there was no value for the handle
+    bool Remove(HandleT Handle)
+    {
+        const int64_t PageIndex = Handle.Index >> PageShift;
+
+        [[unlikely]] if(!Contains(Handle))
+        {
+            return false;
+        }
+
+        RemoveSlot(PageIndex, Handle.Index & PageMask);
+        return true;
+    }
+
+    //removes every value whose handle is not valid in Primary anymore, returns the number of removed values
+    template<typename MapT>
+    int64_t RemoveStale(const MapT& Primary)
+    {
+        int64_t RemovedCount = 0;
+
+        for(int64_t PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+        {
+            for(int64_t Slot = 0; Pages[PageIndex] != nullptr && Slot < PageSize; ++Slot) //the page is freed with its last value
+            {
+                const KeyStorageT ID = Pages[PageIndex]->IDs[Slot];
+
+                if(ID != 0 && !Primary.IsValidHandle(MakeHandle(PageIndex, Slot, ID)))
+                {
+                    RemoveSlot(PageIndex, Slot);
+                    RemovedCount += 1;
+                }
+            }
+        }
+
+        return RemovedCount;
+    }
+
+    //destroys every value and frees every page, the page table is kept
+    void Clear()
+    {
+        for(int64_t PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+        {
+            if(Page* Current = Pages[PageIndex])
+            {
+                if constexpr(!std::is_trivially_destructible_v<ValueT>)
+                {
+                    for(int64_t Slot = 0; Slot < PageSize; ++Slot)
+                    {
+                        if(Current->IDs[Slot] != 0)
+                        {
+                            ValueAt(Current, Slot)->ValueT::~ValueT();
+                        }
+                    }
+                }
+
+                FreePage(PageIndex);
+            }
+        }
+
+        ItemCount = 0;
+    }
+
+    //calls Function(HandleT, Value) for every value in key index order
+    template<typename Self, typename FunctionT>
+    void ForEach(this Self&& self, FunctionT&& Function)
+    {
+        for(int64_t PageIndex = 0; PageIndex < self.PageCount; ++PageIndex)
+        {
+            using PageT = std::conditional_t<std::is_const_v<std::remove_reference_t<Self>>, const Page, Page>;
+
+            if(PageT* Current = self.Pages[PageIndex])
+            {
+                for(int64_t Slot = 0; Slot < PageSize; ++Slot)
+                {
+                    if(Current->IDs[Slot] != 0)
+                    {
+                        Function(MakeHandle(PageIndex, Slot, Current->IDs[Slot]), *ValueAt(Current, Slot));
+                    }
+                }
+            }
+        }
+    }
+
+    int64_t Size() const
+    {
+        return ItemCount;
+    }
+
+    const AllocatorT& GetAllocator() const
+    {
+        return Allocator;
+    }
+
+private:
+
+    static HandleT MakeHandle(int64_t PageIndex, int64_t Slot, KeyStorageT ID)
+    {
+        return HandleT{.Index = static_cast<KeyStorageT>((PageIndex << PageShift) | Slot), .ID = ID};
+    }
+
+    static ValueT* ValueAt(Page* Current, int64_t Slot)
+    {
+        return std::launder(reinterpret_cast<ValueT*>(Current->Values) + Slot);
+    }
+
+    static const ValueT* ValueAt(const Page* Current, int64_t Slot)
+    {
+        return std::launder(reinterpret_cast<const ValueT*>(Current->Values) + Slot);
+    }
+
+    template<typename... Ts>
+    static void ConstructValue(ValueT* Memory, Ts&&... Args)
+    {
+        if constexpr(std::is_constructible_v<ValueT, Ts&&...>)
+        {
+            new(Memory) ValueT(std::forward<Ts>(Args)...);
+        }
+        else //aggregates and braced initialization
+        {
+            new(Memory) ValueT{std::forward<Ts>(Args)...};
+        }
+    }
+
+    void RemoveSlot(int64_t PageIndex, int64_t Slot)
+    {
+        Page* Current = Pages[PageIndex];
+
+        ValueAt(Current, Slot)->ValueT::~ValueT();
+        Current->IDs[Slot] = 0;
+        Current->Count -= 1;
+        ItemCount -= 1;
+
+        if(Current->Count == 0)
+        {
+            FreePage(PageIndex);
+        }
+    }
+
+    Page* FindOrAddPage(int64_t PageIndex)
+    {
+        [[unlikely]] if(PageIndex >= PageCount) //the table grows to the next power of two so sequential indices rarely copy it
+        {
+            const int64_t NewPageCount = std::max<int64_t>(std::bit_ceil(static_cast<uint64_t>(PageIndex + 1)), 8);
+            auto** NewPages = static_cast<Page**>(Allocator.Allocate(NewPageCount * sizeof(Page*), alignof(Page*)));
+            SLOTMAP_ASSERT(NewPages != nullptr, "out of memory");
+
+            std::fill_n(NewPages, NewPageCount, nullptr);
+
+            if(Pages)
+            {
+                std::copy_n(Pages, PageCount, NewPages);
+                Allocator.Deallocate(Pages, PageCount * sizeof(Page*), alignof(Page*));
+            }
+
+            Pages = NewPages;
+            PageCount = NewPageCount;
+        }
+
+        [[unlikely]] if(Pages[PageIndex] == nullptr)
+        {
+            auto* NewPage = static_cast<Page*>(Allocator.Allocate(sizeof(Page), alignof(Page)));
+            SLOTMAP_ASSERT(NewPage != nullptr, "out of memory");
+
+            std::fill_n(NewPage->IDs, PageSize, 0);
+            NewPage->Count = 0;
+
+            Pages[PageIndex] = NewPage;
+        }
+
+        return Pages[PageIndex];
+    }
+
+    void FreePage(int64_t PageIndex)
+    {
+        Allocator.Deallocate(Pages[PageIndex], sizeof(Page), alignof(Page));
+        Pages[PageIndex] = nullptr;
+    }
+};
+
+/**
+ * @description the dense layout keeps every value in one array that can be iterated like the items of a SlotMap, removing a value moves
+ * the last value into its place. Lookups go trough a paged index from key index to dense index.
+ * Like the items of a SlotMap the values are move constructed when the array grows and move assigned when a value is removed or replaced,
+ * so ValueT has to be move constructible and move assignable.
+ */
+template<typename ValueT, typename HandleT, typename Traits>
+class SecondaryMap<ValueT, HandleT, SecondaryMapLayout::Dense, Traits>
+{
+public:
+    static_assert(Traits::AllocationSize > 0);
+    static_assert((Traits::AllocationSize & (Traits::AllocationSize - 1)) == 0, "AllocationSize is the page size and has to be a power of two");
+    static_assert(Traits::GrowthFactor > 1.0);
+    static_assert(std::is_move_constructible_v<ValueT> && std::is_move_assignable_v<ValueT>, "values are moved when the array grows and on removal");
+
+    using KeyStorageT = decltype(std::declval<HandleT>().ToBits());
+    using AllocatorT = typename Traits::AllocatorT;
+
+    static constexpr int64_t PageSize = Traits::AllocationSize;
+    static constexpr int64_t PageShift = std::countr_zero(static_cast<uint64_t>(PageSize));
+    static constexpr int64_t PageMask = PageSize - 1;
+
+    static constexpr size_t ValueAlignment = std::max(alignof(ValueT), Traits::ItemAlignment); //begin() is always aligned to this
+
+private: //member variables
+
+    //dense index + 1 of the value of every key index, 0 if there is none
+    KeyStorageT** IndexPages;
+    int64_t PageCount;
+
+    HandleT* Handles; //handle of the value at the same index
+    ValueT* Values;
+
+    int64_t ItemCount;
+    int64_t AllocatedItemCount;
+
+    [[no_unique_address]] AllocatorT Allocator;
+
+public:
+
+    SecondaryMap(const SecondaryMap&) = delete;
+    SecondaryMap& operator=(const SecondaryMap&) = delete;
+
+    SecondaryMap(SecondaryMap&& Other) noexcept
+        : SecondaryMap(Other.Allocator)
+    {
+        Swap(Other);
+    }
+
+    SecondaryMap& operator=(SecondaryMap&& Other) noexcept
+    {
+        SecondaryMap Moved(std::move(Other));
+        Swap(Moved);
+        return *this;
+    }
+
+    SecondaryMap()
+        : SecondaryMap(AllocatorT{})
+    {
+    }
+
+    explicit SecondaryMap(const AllocatorT& InAllocator)
+        : IndexPages(nullptr)
+        , PageCount(0)
+        , Handles(nullptr)
+        , Values(nullptr)
+        , ItemCount(0)
+        , AllocatedItemCount(0)
+        , Allocator(InAllocator)
+    {
+    }
+
+    void Swap(SecondaryMap& Other) noexcept
+    {
+        using std::swap;
+        swap(IndexPages, Other.IndexPages);
+        swap(PageCount, Other.PageCount);
+        swap(Handles, Other.Handles);
+        swap(Values, Other.Values);
+        swap(ItemCount, Other.ItemCount);
+        swap(AllocatedItemCount, Other.AllocatedItemCount);
+        swap(Allocator, Other.Allocator);
+    }
+
+    friend void swap(SecondaryMap& Left, SecondaryMap& Right) noexcept
+    {
+        Left.Swap(Right);
+    }
+
+    ~SecondaryMap()
+    {
+        DestroyValues();
+
+        for(int64_t PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+        {
+            if(IndexPages[PageIndex])
+            {
+                Allocator.Deallocate(IndexPages[PageIndex], PageSize * sizeof(KeyStorageT), alignof(KeyStorageT));
+            }
+        }
+
+        if(IndexPages)
+        {
+            Allocator.Deallocate(IndexPages, PageCount * sizeof(KeyStorageT*), alignof(KeyStorageT*));
+        }
+
+        if(Values)
+        {
+            Allocator.Deallocate(Handles, AllocatedItemCount * sizeof(HandleT), alignof(HandleT));
+            Allocator.Deallocate(Values, AllocatedItemCount * sizeof(ValueT) + Traits::ItemPaddingBytes, ValueAlignment);
+        }
+    }
+
+    bool Contains(HandleT Handle) const
+    {
+        return IndexOf(Handle) >= 0;
+    }
+
+    //dense index of the value added for Handle, -1 if there is none
+    int64_t IndexOf(HandleT Handle) const
+    {
+        const int64_t PageIndex = Handle.Index >> PageShift;
+
+        [[likely]] if(PageIndex < PageCount && IndexPages[PageIndex] != nullptr)
+        {
+            const int64_t Index = static_cast<int64_t>(IndexPages[PageIndex][Handle.Index & PageMask]) - 1;
+
+            [[likely]] if(Index >= 0 && Handle.ID != 0 && Handles[Index].ID == Handle.ID)
+            {
+                return Index;
+            }
+        }
+
+        return -1;
+    }
+
+    //returns a pointer to the value added for Handle, nullptr if there is none
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, HandleT Handle)
+    {
+        const int64_t Index = self.IndexOf(Handle);
+
+        [[likely]] if(Index >= 0)
+        {
+            return self.Values + Index;
+        }
+
+        return (decltype(self.Values))nullptr;
+    }
+
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, int64_t Index)
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < self.ItemCount));
+        return self.Values[Index];
+    }
+
+    /**
+     * constructs the value for Handle in place from Args, replacing the value of any earlier handle to the same key
+     * @return the new value
+     */
+    template<typename... Ts>
+    ValueT& Emplace(HandleT Handle, Ts&&... Args)
+    {
+        SLOTMAP_ASSERT(Handle.ID != 0, "can't add a value for the null handle");
+
+        KeyStorageT& DenseSlot = FindOrAddIndexPage(Handle.Index >> PageShift)[Handle.Index & PageMask];
+
+        [[unlikely]] if(ItemCount == AllocatedItemCount)
+        {
+            const int64_t Grown = static_cast<int64_t>(AllocatedItemCount * Traits::GrowthFactor);
+            ResizeValues((std::max<int64_t>(Grown, ItemCount + 1) + PageMask) & ~PageMask);
+        }
+
+        //construct past the last value first so a throwing constructor leaves the map unchanged
+        ConstructValue(Values + ItemCount, std::forward<Ts>(Args)...);
+
+        if(DenseSlot != 0) //replace in place, the dense order does not change
+        {
+            const int64_t Index = DenseSlot - 1;
+
+            Values[Index] = std::move(Values[ItemCount]);
+            Values[ItemCount].ValueT::~ValueT();
+            Handles[Index] = Handle;
+
+            return Values[Index];
+        }
+
+        Handles[ItemCount] = Handle;
+        ItemCount += 1;
+
+        DenseSlot = static_cast<KeyStorageT>(ItemCount);
+
+        return Values[ItemCount - 1];
+    }
+
+    ValueT& Add(HandleT Handle, const ValueT& Value)
+    {
+        return Emplace(Handle, Value);
+    }
+
+    ValueT& Add(HandleT Handle, ValueT&& Value)
+    {
+        return Emplace(Handle, std::move(Value));
+    }
+
+    //returns false if there was no value for the handle
+    bool Remove(HandleT Handle)
+    {
+        const int64_t Index = IndexOf(Handle);
+
+        [[unlikely]] if(Index < 0)
+        {
+            return false;
+        }
+
+        RemoveAt(Index);
+        return true;
+    }
+
+    //removes every value whose handle is not valid in Primary anymore, returns the number of removed values
+    template<typename MapT>
+    int64_t RemoveStale(const MapT& Primary)
+    {
+        int64_t RemovedCount = 0;
+
+        for(int64_t Index = ItemCount - 1; Index >= 0; --Index) //going down only moves values that were already checked
+        {
+            if(!Primary.IsValidHandle(Handles[Index]))
+            {
+                RemoveAt(Index);
+                RemovedCount += 1;
+            }
+        }
+
+        return RemovedCount;
+    }
+
+    //destroys every value, allocations are kept
+    void Clear()
+    {
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            IndexSlot(Handles[Index].Index) = 0;
+        }
+
+        DestroyValues();
+    }
+
+    HandleT GetHandle(int64_t Index) const
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
+        return Handles[Index];
+    }
+
+    //calls Function(HandleT, Value) for every value in dense order
+    template<typename Self, typename FunctionT>
+    void ForEach(this Self&& self, FunctionT&& Function)
+    {
+        for(int64_t Index = 0; Index < self.ItemCount; ++Index)
+        {
+            Function(self.Handles[Index], self.Values[Index]);
+        }
+    }
+
+    template<typename Self>
+    decltype(auto) begin(this Self&& self)
+    {
+        return self.Values;
+    }
+
+    template<typename Self>
+    decltype(auto) end(this Self&& self)
+    {
+        return self.Values + self.ItemCount;
+    }
+
+    template<typename Self>
+    decltype(auto) AsSpan(this Self&& self)
+    {
+        return std::span(self.begin(), self.end());
+    }
+
+    //the handles in the same order as the values
+    std::span<const HandleT> GetHandles() const
+    {
+        return std::span<const HandleT>(Handles, ItemCount);
+    }
+
+    int64_t Capacity() const
+    {
+        return AllocatedItemCount;
+    }
+
+    int64_t Size() const
+    {
+        return ItemCount;
+    }
+
+    const AllocatorT& GetAllocator() const
+    {
+        return Allocator;
+    }
+
+private:
+
+    template<typename... Ts>
+    static void ConstructValue(ValueT* Memory, Ts&&... Args)
+    {
+        if constexpr(std::is_constructible_v<ValueT, Ts&&...>)
+        {
+            new(Memory) ValueT(std::forward<Ts>(Args)...);
+        }
+        else //aggregates and braced initialization
+        {
+            new(Memory) ValueT{std::forward<Ts>(Args)...};
+        }
+    }
+
+    //expects the index page of KeyIndex to exist
+    KeyStorageT& IndexSlot(uint64_t KeyIndex)
+    {
+        return IndexPages[KeyIndex >> PageShift][KeyIndex & PageMask];
+    }
+
+    void RemoveAt(int64_t Index)
+    {
+        ItemCount -= 1;
+        IndexSlot(Handles[Index].Index) = 0;
+
+        if(Index != ItemCount) //move the last value into the hole
+        {
+            Values[Index] = std::move(Values[ItemCount]);
+            Handles[Index] = Handles[ItemCount];
+            IndexSlot(Handles[Index].Index) = static_cast<KeyStorageT>(Index + 1);
+        }
+
+        Values[ItemCount].ValueT::~ValueT();
+    }
+
+    void DestroyValues()
+    {
+        if constexpr(!std::is_trivially_destructible_v<ValueT>)
+        {
+            for(int64_t Index = 0; Index < ItemCount; ++Index)
+            {
+                Values[Index].ValueT::~ValueT();
+            }
+        }
+
+        ItemCount = 0;
+    }
+
+    KeyStorageT* FindOrAddIndexPage(int64_t PageIndex)
+    {
+        [[unlikely]] if(PageIndex >= PageCount) //the table grows to the next power of two so sequential indices rarely copy it
+        {
+            const int64_t NewPageCount = std::max<int64_t>(std::bit_ceil(static_cast<uint64_t>(PageIndex + 1)), 8);
+            auto** NewPages = static_cast<KeyStorageT**>(Allocator.Allocate(NewPageCount * sizeof(KeyStorageT*), alignof(KeyStorageT*)));
+            SLOTMAP_ASSERT(NewPages != nullptr, "out of memory");
+
+            std::fill_n(NewPages, NewPageCount, nullptr);
+
+            if(IndexPages)
+            {
+                std::copy_n(IndexPages, PageCount, NewPages);
+                Allocator.Deallocate(IndexPages, PageCount * sizeof(KeyStorageT*), alignof(KeyStorageT*));
+            }
+
+            IndexPages = NewPages;
+            PageCount = NewPageCount;
+        }
+
+        [[unlikely]] if(IndexPages[PageIndex] == nullptr)
+        {
+            auto* NewPage = static_cast<KeyStorageT*>(Allocator.Allocate(PageSize * sizeof(KeyStorageT), alignof(KeyStorageT)));
+            SLOTMAP_ASSERT(NewPage != nullptr, "out of memory");
+
+            std::fill_n(NewPage, PageSize, 0);
+
+            IndexPages[PageIndex] = NewPage;
+        }
+
+        return IndexPages[PageIndex];
+    }
+
+    void ResizeValues(int64_t Count)
+    {
+        auto* NewHandles = static_cast<HandleT*>(Allocator.Allocate(Count * sizeof(HandleT), alignof(HandleT)));
+        auto* NewValues = static_cast<ValueT*>(Allocator.Allocate(Count * sizeof(ValueT) + Traits::ItemPaddingBytes, ValueAlignment));
+        SLOTMAP_ASSERT(NewHandles != nullptr && NewValues != nullptr, "out of memory");
+
+        if(Values)
+        {
+            std::copy_n(Handles, ItemCount, NewHandles);
+
+            if constexpr(std::is_trivially_copyable_v<ValueT>)
+            {
+                std::memcpy(NewValues, Values, ItemCount * sizeof(ValueT));
+            }
+            else
+            {
+                for(int64_t Index = 0; Index < ItemCount; ++Index)
+                {
+                    new(NewValues + Index) ValueT(std::move(Values[Index]));
+                    Values[Index].ValueT::~ValueT();
+                }
+            }
+
+            Allocator.Deallocate(Handles, AllocatedItemCount * sizeof(HandleT), alignof(HandleT));
+            Allocator.Deallocate(Values, AllocatedItemCount * sizeof(ValueT) + Traits::ItemPaddingBytes, ValueAlignment);
+        }
+
+        Handles = NewHandles;
+        Values = NewValues;
+        AllocatedItemCount = Count;
+    }
+};
+
+#endif //SECONDARYMAP_HPP
@@ -5,327 +5,3548 @@
 #include <type_traits>
 #include <utility>
 #include <iterator>
+#include <new>
+#include <span>
+#include <ranges>
+#include <functional>
+#include <algorithm>
+#include <concepts>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <memory_resource>
+#include <bit>
+#include <atomic>
+#include <limits>
+#include <compare>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define SLOTMAP_HAS_MMAP 1
+#else
+#define SLOTMAP_HAS_MMAP 0
+#endif
 
 #ifndef SLOTMAP_ASSERT
 #include <cassert>
 #define SLOTMAP_ASSERT(expr, ...) assert((expr) __VA_OPT__(&& __VA_ARGS__))
 #endif
 
+/**
+ * @description allocators provide Allocate(Size, Alignment) and Deallocate(Memory, Size, Alignment).
+ * they may additionally provide Reallocate(Memory, OldSize, NewSize, Alignment) which is used to resize trivially copyable arrays,
+ * it returns nullptr if the memory could not be resized in which case the old memory has to be left untouched
+ */
+template<typename AllocatorT>
+concept SlotMapReallocatingAllocator = requires(AllocatorT& Allocator, void* Memory, size_t Size)
+{
+    { Allocator.Reallocate(Memory, Size, Size, Size) } -> std::convertible_to<void*>;
+};
+
+struct SlotMapMallocAllocator
+{
+    void* Allocate(size_t Size, size_t Alignment)
+    {
+        if(Alignment <= alignof(std::max_align_t))
+        {
+            return malloc(Size);
+        }
+
+        return aligned_alloc(Alignment, (Size + Alignment - 1) & ~(Alignment - 1)); //size has to be a multiple of the alignment
+    }
+
+    void Deallocate(void* Memory, size_t, size_t)
+    {
+        free(Memory);
+    }
+
+    void* Reallocate(void* Memory, size_t, size_t NewSize, size_t Alignment)
+    {
+        if(Alignment <= alignof(std::max_align_t))
+        {
+            return realloc(Memory, NewSize);
+        }
+
+        return nullptr; //realloc does not keep over-alignment
+    }
+};
+
+struct SlotMapPmrAllocator
+{
+    std::pmr::memory_resource* Resource = std::pmr::get_default_resource();
+
+    void* Allocate(size_t Size, size_t Alignment)
+    {
+        return Resource->allocate(Size, Alignment);
+    }
+
+    void Deallocate(void* Memory, size_t Size, size_t Alignment)
+    {
+        Resource->deallocate(Memory, Size, Alignment);
+    }
+};
+
+//the default dispatch of SlotMap::ParallelForEach, include slotmapdispatch.hpp to use it
+struct SlotMapThreadDispatch;
+
+enum class SlotMapGrowthPolicy
+{
+    Linear, //grow and shrink in steps of Traits::AllocationSize
+    Geometric, //grow by Traits::GrowthFactor, shrink when usage drops below Traits::ShrinkThreshold if it is above 0
+    Fixed //never resize automatically, capacity is only changed trough Reserve and ShrinkToFit
+};
+
+enum class SlotMapRemovalPolicy
+{
+    SwapWithLast, //move the last item into the hole, O(1) but reorders the items
+    Shift //shift every following item down by one, O(n) but keeps insertion order
+};
+
+//kind of change reported by SlotMap::CollectChanges
+enum class SlotMapChange
+{
+    Added,
+    Removed,
+    Modified
+};
+
+enum class SlotMapResizeTarget
+{
+    Items, //items, key offsets and cached IDs
+    Keys //keys and split generations
+};
+
+struct SlotMapResizeEvent
+{
+    SlotMapResizeTarget Target;
+    int64_t OldCapacity;
+    int64_t NewCapacity;
+    int64_t BytesMoved; //bytes of live data copied or moved to the new allocation, an upper bound when realloc grows in place
+};
+
+/**
+ * statistics policy of Traits::StatsT, every hook is an empty inline function so a map without statistics compiles to the same code.
+ * custom policies have to provide the same hooks, they are called on the thread that mutates the map.
+ * single lookups report trough OnHandleCheck, batched ones like Resolve once per chunk trough OnHandleChecks
+ */
+struct SlotMapNoStats
+{
+    void OnResize(const SlotMapResizeEvent&) {}
+    void OnItemCount(int64_t) {}
+    void OnIdIssued(uint64_t) {}
+    void OnHandleCheck(bool) {}
+    void OnHandleChecks(int64_t, int64_t) {}
+};
+
+//counts resizes, peaks and handle misses, ResizeCallback is called after every resize if it is set
+struct SlotMapCountingStats
+{
+    int64_t ItemResizes = 0;
+    int64_t KeyResizes = 0;
+    int64_t BytesMoved = 0;
+    int64_t PeakItemCount = 0;
+    uint64_t MaxId = 0; //highest ID a key has reached, compare against IdMax to see how close keys are to retiring
+    int64_t HandleChecks = 0;
+    int64_t HandleMisses = 0;
+
+    std::function<void(const SlotMapResizeEvent&)> ResizeCallback;
+
+    void OnResize(const SlotMapResizeEvent& Event)
+    {
+        (Event.Target == SlotMapResizeTarget::Items ? ItemResizes : KeyResizes) += 1;
+        BytesMoved += Event.BytesMoved;
+
+        if(ResizeCallback)
+        {
+            ResizeCallback(Event);
+        }
+    }
+
+    void OnItemCount(int64_t ItemCount)
+    {
+        PeakItemCount = std::max(PeakItemCount, ItemCount);
+    }
+
+    void OnIdIssued(uint64_t ID)
+    {
+        MaxId = std::max(MaxId, ID);
+    }
+
+    void OnHandleCheck(bool Valid)
+    {
+        HandleChecks += 1;
+        HandleMisses += !Valid;
+    }
+
+    void OnHandleChecks(int64_t Checks, int64_t Misses)
+    {
+        HandleChecks += Checks;
+        HandleMisses += Misses;
+    }
+
+    double HandleMissRate() const
+    {
+        return HandleChecks != 0 ? static_cast<double>(HandleMisses) / HandleChecks : 0.0;
+    }
+
+    //clears the counters, the callback is kept
+    void Reset()
+    {
+        *this = SlotMapCountingStats{.ResizeCallback = std::move(ResizeCallback)};
+    }
+};
+
+//custom traits should derive from this and only override what they need
 struct SlotMapDefaultTraits
 {
     static constexpr int64_t IndexBits = 40;
     static constexpr int64_t IdBits = 64 - IndexBits;
+    using KeyStorageT = uint64_t; //storage of keys and handles, uint32_t halves them when IndexBits + IdBits <= 32
     static constexpr int64_t MinFreeKeys = 32;
-    static constexpr int64_t AllocationSize = 512; //how many items will fit in a memory allocation
+    static constexpr int64_t AllocationSize = 512; //allocations are rounded to a multiple of this many items, has to be a power of two
+    static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Linear; //Geometric avoids the O(n^2) copying of filling a large map in AllocationSize steps
+    static constexpr double GrowthFactor = 1.5; //only used by Geometric
+    static constexpr double ShrinkThreshold = 0.0; //Geometric only: fraction of the item capacity in use below which items are shrunk, 0 never shrinks. 0.25 is a good start
+    using AllocatorT = SlotMapMallocAllocator; //used for keys, key offsets and items, see SlotMapReallocatingAllocator
+    static constexpr size_t ItemAlignment = 64; //minimum alignment of the items array, alignof(ItemT) is used if it is larger
+    static constexpr size_t ItemPaddingBytes = 64; //readable bytes allocated past the last item so vector loads may overrun end()
+    static constexpr int64_t PrefetchDistance = 16; //how many handles ahead ForEachHandle prefetches keys, items are prefetched half as far ahead. 0 disables prefetching
+    static constexpr bool ConcurrentReads = false; //allow ConcurrentRead from any thread while a single thread mutates the map, requires trivially copyable items
+    static constexpr int64_t ParallelGrain = 4096; //default number of items per task in ParallelForEach
+    static constexpr SlotMapRemovalPolicy RemovalPolicy = SlotMapRemovalPolicy::SwapWithLast;
+    static constexpr bool TrackChanges = false; //record added, removed and MarkDirty'd keys for CollectChanges
+    static constexpr bool SplitGenerations = false; //keep key IDs in their own dense uint16_t/uint32_t array so validating a handle only loads its ID, requires IdBits <= 32
+    static constexpr bool CacheGenerations = false; //keep a copy of every item's ID next to KeyOffsets so GetHandle and Entries never load a key
+    using StatsT = SlotMapNoStats; //SlotMapCountingStats or a custom policy with the same hooks, see GetStats
+    static constexpr int64_t MigrationBudget = 0; //items moved to a resized item allocation per Add and Remove instead of all during the resize, 0 moves them at once. see StepMigration
 };
 
 /**
- * @description A SlotMap is used to store items without clear ownership.
- * Accessing an item is done trough a handle which stores an index to a key and an expected identifier
- * if the identifiers differ the handle is considered to be invalid, otherwise the address of the item is retrieved trough the key.
- * When an item is removed its corresponding key updates its ID - thus invalidating all existing handles to that key.
- * @warning given enough time an ID will reach its maximum and wrap around which could create false positives when accessing that item
- * currently this is caught by SLOTMAP_ASSERT
+ * handle to an item of a slot map, Index in the low bits and ID above. every map with the same key layout and TagT shares this type,
+ * maps default TagT to their item type so different item types never mix, pass a distinct tag to keep handles of two maps of the same item type apart.
+ * converts to and from its raw bits for storage and serialization, compares and hashes by those bits
+ */
+template<typename KeyStorageT, int64_t IndexBits, int64_t IdBits, typename TagT>
+struct SlotMapKeyHandle
+{
+    using TagType = TagT;
+
+    //offset to an ItemKey
+    KeyStorageT Index : IndexBits = 0;
+
+    //id of the item in ItemKey
+    KeyStorageT ID : IdBits = 0;
+
+    constexpr KeyStorageT ToBits() const
+    {
+        return static_cast<KeyStorageT>(Index) | (static_cast<KeyStorageT>(ID) << IndexBits);
+    }
+
+    //bits above IndexBits + IdBits are dropped
+    static constexpr SlotMapKeyHandle FromBits(KeyStorageT Bits)
+    {
+        return SlotMapKeyHandle{.Index = static_cast<KeyStorageT>(Bits), .ID = static_cast<KeyStorageT>(Bits >> IndexBits)};
+    }
+
+    friend constexpr bool operator==(SlotMapKeyHandle Left, SlotMapKeyHandle Right)
+    {
+        return Left.ToBits() == Right.ToBits();
+    }
+
+    //orders by ID first, then by Index
+    friend constexpr std::strong_ordering operator<=>(SlotMapKeyHandle Left, SlotMapKeyHandle Right)
+    {
+        return Left.ToBits() <=> Right.ToBits();
+    }
+};
+
+//the bits are already unique per live item, so they are hashed the same as KeyStorageT
+template<typename KeyStorageT, int64_t IndexBits, int64_t IdBits, typename TagT>
+struct std::hash<SlotMapKeyHandle<KeyStorageT, IndexBits, IdBits, TagT>>
+{
+    size_t operator()(SlotMapKeyHandle<KeyStorageT, IndexBits, IdBits, TagT> Handle) const noexcept
+    {
+        return std::hash<KeyStorageT>{}(Handle.ToBits());
+    }
+};
+
+/**
+ * @description the key half shared by SlotMap, SoASlotMap and PagedSlotMap: the keys with the FIFO freelist linked trough the free ones,
+ * retirement of keys whose ID is used up and the arithmetic of the growth policy. the maps allocate the keys and own everything about the items,
+ * this only manages what is stored in the keys. SplitIds keeps the IDs in their own Generations array, see Traits::SplitGenerations
  */
-template<typename ItemT, typename Traits = SlotMapDefaultTraits>
-class SlotMap
+template<typename Traits, typename TagT, bool SplitIds = Traits::SplitGenerations>
+class SlotMapKeyTable
 {
 public:
     static_assert(Traits::IndexBits > 0);
     static_assert(Traits::IdBits > 0);
-    static_assert(Traits::MinFreeKeys >= 0);
+    static_assert(Traits::MinFreeKeys >= 1, "the freelist needs at least one key to append to");
     static_assert(Traits::AllocationSize > 0);
-    static_assert(Traits::IndexBits + Traits::IdBits <= 64);
+    static_assert((Traits::AllocationSize & (Traits::AllocationSize - 1)) == 0, "AllocationSize has to be a power of two");
+    static_assert(Traits::GrowthFactor > 1.0);
+    static_assert(Traits::ShrinkThreshold >= 0.0 && Traits::ShrinkThreshold * Traits::GrowthFactor < 1.0, "shrinking has to leave slack below the next growth");
+    static_assert(std::is_same_v<typename Traits::KeyStorageT, uint32_t> || std::is_same_v<typename Traits::KeyStorageT, uint64_t>);
+    static_assert(Traits::IndexBits + Traits::IdBits <= std::numeric_limits<typename Traits::KeyStorageT>::digits, "IndexBits and IdBits have to fit in KeyStorageT");
+    static_assert((Traits::ItemAlignment & (Traits::ItemAlignment - 1)) == 0, "ItemAlignment has to be a power of two");
+    static_assert(!SplitIds || Traits::IdBits <= 32, "split generations are stored as uint16_t or uint32_t");
+
+    using KeyOffsetT = std::conditional_t<Traits::IndexBits <= 32, uint32_t, uint64_t>;
+    using KeyStorageT = typename Traits::KeyStorageT;
+    using AllocatorT = typename Traits::AllocatorT;
+
+    static constexpr uint64_t IndexMax = UINT64_MAX >> (64 - Traits::IndexBits);
+    static constexpr uint64_t IdMax = UINT64_MAX >> (64 - Traits::IdBits); //keys reaching this id are retired, it is never handed out
+    static constexpr KeyOffsetT TombstoneOffset = std::numeric_limits<KeyOffsetT>::max(); //key offset of an item marked by SlotMap::MarkRemoved
+    static constexpr int64_t KeyCountMax = std::min<uint64_t>(IndexMax + 1, TombstoneOffset); //every key index has to fit in Traits::IndexBits and differ from TombstoneOffset
+
+    struct PackedItemKey
+    {
+        //when free, specifies an offset to an item, otherwise to the next free key
+        KeyStorageT Index : Traits::IndexBits = 0;
+
+        //id of the item pointed to by Index, 0 is an invalid ID in order to properly represent a null handle
+        KeyStorageT ID : Traits::IdBits = 0;
+    };
+
+    //with SplitIds the ID of key i lives in Generations[i] instead
+    struct SplitItemKey
+    {
+        KeyStorageT Index : Traits::IndexBits = 0;
+    };
+
+    using ItemKey = std::conditional_t<SplitIds, SplitItemKey, PackedItemKey>;
+    using GenerationT = std::conditional_t<Traits::IdBits <= 16, uint16_t, std::conditional_t<Traits::IdBits <= 32, uint32_t, uint64_t>>;
+
+    using KeyHandle = SlotMapKeyHandle<KeyStorageT, Traits::IndexBits, Traits::IdBits, TagT>;
+
+    static constexpr KeyHandle NullHandle{.Index = 0, .ID = 0};
+
+    int64_t KeyCapacity() const
+    {
+        return KeyCount;
+    }
+
+    //number of keys taken out of use because their ID reached IdMax
+    int64_t RetiredKeys() const
+    {
+        return RetiredKeyCount;
+    }
+
+    /**
+     * resets the ID of every retired key and puts it back on the freelist.
+     * @warning the caller has to guarantee that no handle to a retired key survived, e.g. after dropping all stored handles or reloading a level, otherwise old handles can match again
+     * @return the number of recycled keys
+     */
+    int64_t RecycleRetiredKeys()
+    {
+        int64_t RecycledCount = 0;
+
+        for(int64_t Index = 0; Index < KeyCount && RecycledCount < RetiredKeyCount; ++Index)
+        {
+            [[unlikely]] if(KeyID(Index) == IdMax)
+            {
+                SetKeyID(Index, 1);
+
+                Keys[FreelistTail].Index = Index;
+                FreelistTail = Index;
+
+                RecycledCount += 1;
+            }
+        }
+
+        RetiredKeyCount = 0;
+
+        return RecycledCount;
+    }
+
+protected:
+
+    ItemKey* Keys = nullptr;
+    GenerationT* Generations = nullptr; //one ID per key with SplitIds, nullptr otherwise
+
+    int64_t KeyCount = 0; //number of keys including free keys, is the same as the number of allocated keys
+
+    uint64_t FreelistHead = 0; //first free key offset FIFO implementation
+    uint64_t FreelistTail = 0; //last free key offset
+
+    int64_t RetiredKeyCount = 0; //keys whose ID reached IdMax, they are kept off the freelist until RecycleRetiredKeys
+
+    void SwapKeys(SlotMapKeyTable& Other) noexcept
+    {
+        using std::swap;
+        swap(Keys, Other.Keys);
+        swap(Generations, Other.Generations);
+        swap(KeyCount, Other.KeyCount);
+        swap(FreelistHead, Other.FreelistHead);
+        swap(FreelistTail, Other.FreelistTail);
+        swap(RetiredKeyCount, Other.RetiredKeyCount);
+    }
+
+    uint64_t KeyID(uint64_t KeyIndex) const
+    {
+        if constexpr(SplitIds)
+        {
+            return Generations[KeyIndex];
+        }
+        else
+        {
+            return Keys[KeyIndex].ID;
+        }
+    }
+
+    void SetKeyID(uint64_t KeyIndex, uint64_t ID)
+    {
+        if constexpr(SplitIds)
+        {
+            Generations[KeyIndex] = static_cast<GenerationT>(ID);
+        }
+        else
+        {
+            Keys[KeyIndex].ID = ID;
+        }
+    }
+
+    //invalidates every handle to the key, returns the new ID
+    uint64_t BumpKeyID(uint64_t KeyIndex)
+    {
+        uint64_t ID = KeyID(KeyIndex) + 1;
+        SetKeyID(KeyIndex, ID);
+        return ID;
+    }
+
+    //a handle check that is not reported to a stats policy, for checks that are not lookups of their own
+    bool IsLiveHandle(KeyHandle Handle) const
+    {
+        return Handle.ID != 0 && Handle.Index < static_cast<uint64_t>(KeyCount) && Handle.ID == KeyID(Handle.Index);
+    }
+
+    //handle to the key with its current ID
+    KeyHandle MakeHandle(uint64_t KeyIndex) const
+    {
+        return KeyHandle{.Index = static_cast<KeyStorageT>(KeyIndex), .ID = static_cast<KeyStorageT>(KeyID(KeyIndex))};
+    }
+
+    //takes the free head key and points it at the dense Slot, the freelist always has a key left since MinFreeKeys >= 1
+    uint64_t BindFreeKey(uint64_t Slot)
+    {
+        uint64_t KeyIndex = FreelistHead;
+        ItemKey& Key = Keys[KeyIndex];
+
+        FreelistHead = Key.Index;
+        Key.Index = Slot;
+
+        return KeyIndex;
+    }
+
+    //appends a key whose ID was just bumped to the freelist, or retires it for good if the ID is used up
+    void ReleaseKey(uint64_t KeyIndex)
+    {
+        [[unlikely]] if(KeyID(KeyIndex) == IdMax)
+        {
+            RetiredKeyCount += 1;
+            return;
+        }
+
+        ItemKey& TailKey = Keys[FreelistTail]; //set old tail to point to the new tail (this key)
+        TailKey.Index = KeyIndex;
+        FreelistTail = KeyIndex;
+    }
+
+    //links every key that is not retired into the freelist in index order, no key may be bound to an item
+    void RelinkFreelist()
+    {
+        int64_t Tail = -1;
+
+        for(int64_t Index = 0; Index < KeyCount; ++Index)
+        {
+            [[unlikely]] if(KeyID(Index) == IdMax)
+            {
+                continue;
+            }
+
+            if(Tail < 0)
+            {
+                FreelistHead = Index;
+            }
+            else
+            {
+                Keys[Tail].Index = Index;
+            }
+
+            Tail = Index;
+        }
+
+        FreelistTail = std::max<int64_t>(Tail, 0);
+    }
+
+    //initializes the keys [OldKeyCount, KeyCount) that a grown allocation added and appends them to the freelist
+    void LinkNewKeys(int64_t OldKeyCount)
+    {
+        for(int64_t idx = OldKeyCount; idx < KeyCount; ++idx) //initialize new keys
+        {
+            Keys[idx].Index = idx + 1; //points one off the end but that's ok because we update it before we get to that point
+            SetKeyID(idx, 1);
+        }
+
+        if(OldKeyCount != 0)
+        {
+            Keys[FreelistTail].Index = OldKeyCount; //set old tail to point to the first new key
+        }
+
+        FreelistTail = KeyCount - 1; //new tail is the last added key
+    }
+
+    //keys needed for ItemCapacity items with the retired keys and the freelist slack on top
+    int64_t RequiredKeyCount(int64_t ItemCapacity) const
+    {
+        return ItemCapacity + RetiredKeyCount + Traits::MinFreeKeys; //item count will always be <= key count
+    }
+
+    //the key count to grow to so RequiredItems items fit, KeyCount if they already do and -1 if the growth policy or Traits::IndexBits don't allow it
+    int64_t KeyCountForAdd(int64_t RequiredItems) const
+    {
+        const int64_t RequiredKeys = RequiredKeyCount(RequiredItems);
+
+        [[likely]] if(RequiredKeys <= KeyCount)
+        {
+            return KeyCount;
+        }
+
+        if(Traits::GrowthPolicy == SlotMapGrowthPolicy::Fixed || RequiredKeys > KeyCountMax)
+        {
+            return -1;
+        }
+
+        return std::min(GrowCapacity(KeyCount, RequiredKeys), KeyCountMax);
+    }
+
+    static constexpr int64_t RoundToAllocationSize(int64_t Count)
+    {
+        return (Count + Traits::AllocationSize - 1) & ~(Traits::AllocationSize - 1);
+    }
+
+    //returns the capacity to grow to when Required elements do not fit in Current
+    static constexpr int64_t GrowCapacity(int64_t Current, int64_t Required)
+    {
+        if constexpr(Traits::GrowthPolicy == SlotMapGrowthPolicy::Geometric)
+        {
+            return RoundToAllocationSize(std::max(Required, static_cast<int64_t>(Current * Traits::GrowthFactor)));
+        }
+        else
+        {
+            return RoundToAllocationSize(Required);
+        }
+    }
+
+    //the capacity an item allocation of Allocated elements holding ItemCount items should shrink to, Allocated if it is not worth it
+    static constexpr int64_t SparseCapacity(int64_t Allocated, int64_t ItemCount)
+    {
+        if constexpr(Traits::GrowthPolicy == SlotMapGrowthPolicy::Linear)
+        {
+            [[unlikely]] if(Allocated >= (ItemCount + Traits::AllocationSize * 2)) //test if its worth to shrink items
+            {
+                return RoundToAllocationSize(ItemCount);
+            }
+        }
+        else if constexpr(Traits::GrowthPolicy == SlotMapGrowthPolicy::Geometric && Traits::ShrinkThreshold > 0.0)
+        {
+            //shrinking to one growth step above the item count leaves room on both sides so an oscillating count does not thrash
+            [[unlikely]] if(Allocated > Traits::AllocationSize && ItemCount < static_cast<int64_t>(Allocated * Traits::ShrinkThreshold))
+            {
+                return RoundToAllocationSize(static_cast<int64_t>(ItemCount * Traits::GrowthFactor));
+            }
+        }
+
+        return Allocated;
+    }
+};
+
+/**
+ * @description A SlotMap is used to store items without clear ownership.
+ * Accessing an item is done trough a handle which stores an index to a key and an expected identifier
+ * if the identifiers differ the handle is considered to be invalid, otherwise the address of the item is retrieved trough the key.
+ * When an item is removed its corresponding key updates its ID - thus invalidating all existing handles to that key.
+ * A key whose ID reaches IdMax is retired instead of wrapping around, see RetiredKeys and RecycleRetiredKeys.
+ * TagT only selects the handle type, see SlotMapKeyHandle.
+ */
+template<typename ItemT, typename Traits = SlotMapDefaultTraits, typename TagT = ItemT>
+class SlotMap : public SlotMapKeyTable<Traits, TagT>
+{
+    using KeyTable = SlotMapKeyTable<Traits, TagT>;
+
+public:
+    static_assert(Traits::PrefetchDistance >= 0);
+    static_assert(Traits::ParallelGrain > 0);
+    static_assert(!Traits::ConcurrentReads || std::is_trivially_copyable_v<ItemT>, "concurrent readers copy items while they may be written, which requires trivially copyable items");
+    static_assert(Traits::MigrationBudget >= 0);
+    static_assert(Traits::MigrationBudget == 0 || !Traits::ConcurrentReads, "concurrent readers expect every item in one array");
+    static_assert(Traits::MigrationBudget == 0 || !Traits::CacheGenerations, "cached IDs are not migrated incrementally");
+
+    using typename KeyTable::KeyOffsetT;
+    using typename KeyTable::KeyStorageT;
+    using typename KeyTable::AllocatorT;
+    using typename KeyTable::ItemKey;
+    using typename KeyTable::GenerationT;
+    using typename KeyTable::KeyHandle;
+
+    using KeyTable::IndexMax;
+    using KeyTable::IdMax;
+    using KeyTable::TombstoneOffset;
+    using KeyTable::KeyCountMax;
+    using KeyTable::NullHandle;
+
+    static constexpr size_t ItemAlignment = std::max(alignof(ItemT), Traits::ItemAlignment); //begin() is always aligned to this
+    static constexpr size_t ItemPaddingBytes = Traits::ItemPaddingBytes;
+
+    //ItemKey and KeyHandle share the same 64 bit layout with Index in the low bits, which lets handles be validated with vector compares. 32 bit keys use the scalar path
+    static constexpr bool HasPackedKeys = !Traits::SplitGenerations && sizeof(ItemKey) == sizeof(uint64_t) && sizeof(KeyHandle) == sizeof(uint64_t);
+    static constexpr uint64_t IndexBitMask = IndexMax;
+    static constexpr uint64_t IdBitMask = IdMax << Traits::IndexBits;
+
+private: //member variables
+
+    //what a concurrent reader needs to resolve a handle, published as a whole so the pointers and their bounds always match
+    struct ReaderSnapshot
+    {
+        const ItemKey* Keys;
+        const GenerationT* Generations;
+        int64_t KeyCount;
+        const ItemT* Items;
+        int64_t ItemCapacity;
+    };
+
+    struct RetiredMemory
+    {
+        void* Memory;
+        size_t Size;
+        size_t Alignment;
+        uint64_t Epoch; //epoch in which the memory was retired
+    };
+
+    /**
+     * readers run a seqlock on WriteSequence, which is odd while the writer changes keys or items that a reader could consider valid.
+     * memory replaced by a resize is retired instead of freed, readers announce themselves in ActiveReaders[Epoch % 2] and memory retired
+     * in an epoch gets freed once every reader that could have seen it has left
+     */
+    struct ConcurrentReadState
+    {
+        alignas(64) std::atomic<uint64_t> WriteSequence{0};
+        std::atomic<const ReaderSnapshot*> Snapshot{nullptr};
+        std::atomic<uint64_t> Epoch{1};
+
+        alignas(64) std::atomic<int64_t> ActiveReaders[2]{};
+
+        alignas(64) RetiredMemory* Retired = nullptr; //only touched by the writer
+        int64_t RetiredCount = 0;
+        int64_t RetiredCapacity = 0;
+    };
+
+    struct NoConcurrentReadState
+    {
+    };
+
+    struct CloneTag
+    {
+    };
+
+    //per key bits instead of per dense slot so swap-moves and Flush don't have to update them
+    struct ChangeTrackingState
+    {
+        std::vector<uint64_t> ListedBits; //key is in ChangedKeys
+        std::vector<uint64_t> AddedBits; //key was bound to an item since the last CollectChanges
+        std::vector<uint64_t> ChangedKeys;
+        std::vector<KeyHandle> RemovedHandles; //handles of keys that were alive when the epoch started
+    };
+
+    struct NoChangeTrackingState
+    {
+    };
+
+    //an item resize in progress with Traits::MigrationBudget, dense indices in [Migrated, End) still live in the old arrays and the rest in Items/KeyOffsets.
+    //End only shrinks as items are removed from the back and new items are always appended past it
+    struct MigrationState
+    {
+        ItemT* Items = nullptr;
+        KeyOffsetT* KeyOffsets = nullptr;
+        int64_t Capacity = 0; //of the old arrays, 0 when no migration is in progress
+        int64_t Migrated = 0;
+        int64_t End = 0;
+        int64_t Pace = 0; //at most Pace items per free slot of the new arrays are left to move, so the migration is done before they fill up
+        int64_t QueuedCapacity = 0; //resize requested by Reserve or ShrinkToFit during the migration, started by the first add or remove after it is done
+    };
+
+    struct NoMigrationState
+    {
+    };
+
+    static constexpr bool IncrementalMigration = Traits::MigrationBudget > 0;
+
+    static constexpr uint64_t SerializedMagic = 0x50414D544F4C53; //"SLOTMAP"
+    static constexpr uint32_t SerializedVersion = 1;
+
+    //the arrays follow the header at the offsets stored in it, each aligned so a mapped file can be used in place
+    struct SerializedHeader
+    {
+        uint64_t Magic;
+        uint32_t Version;
+        uint32_t ItemSize;
+        uint32_t ItemAlignment;
+        uint32_t IndexBits;
+        uint32_t IdBits;
+        uint32_t KeyOffsetSize;
+        uint32_t KeySize;
+        uint32_t GenerationSize; //0 unless Traits::SplitGenerations
+
+        int64_t KeyCount;
+        int64_t ItemCount;
+        uint64_t FreelistHead;
+        uint64_t FreelistTail;
+        int64_t PendingRemovalCount;
+        int64_t FirstTombstone;
+        int64_t RetiredKeyCount;
+
+        uint64_t KeysOffset = 0;
+        uint64_t GenerationsOffset = 0;
+        uint64_t KeyOffsetsOffset = 0;
+        uint64_t ItemsOffset = 0;
+        uint64_t TotalSize = 0; //includes Traits::ItemPaddingBytes past the last item
+    };
+
+    static constexpr uint32_t SerializedGenerationSize = Traits::SplitGenerations ? sizeof(GenerationT) : 0;
+
+    using KeyTable::Keys;
+    using KeyTable::Generations;
+    using KeyTable::KeyCount;
+    using KeyTable::FreelistHead;
+    using KeyTable::FreelistTail;
+    using KeyTable::RetiredKeyCount;
+
+    KeyOffsetT* KeyOffsets; //offset values "owned" by the corresponding item at the same index that is used the get the key of an item
+    GenerationT* ItemGenerations; //ID of the key of the item at the same index with Traits::CacheGenerations, nullptr otherwise
+    ItemT* Items;
+
+    int64_t ItemCount;
+    int64_t AllocatedItemCount;
+
+    //dense slots [ItemCount, ItemCount + ConcurrentAddLimit) and their keys are handed out to producer threads between BeginConcurrentAdd and EndConcurrentAdd
+    int64_t ConcurrentAddLimit;
+    int64_t ConcurrentAddCursor; //number of claimed slots, only accessed atomically during a concurrent add
+    uint64_t* ConcurrentAddDropped; //one bit per slot of the concurrent add, set for claimed slots whose block was destroyed before an item was constructed in them
+
+    int64_t PendingRemovalCount; //items marked by MarkRemoved that Flush has not compacted yet
+    int64_t FirstTombstone; //lowest index of a marked item, Flush starts compacting from here
+
+    //set while the arrays point into a file mapped by MapFromFile, the first resize copies them out and unmaps the file
+    void* MappedMemory;
+    size_t MappedSize;
+
+    [[no_unique_address]] AllocatorT Allocator;
+
+    [[no_unique_address]] mutable std::conditional_t<Traits::ConcurrentReads, ConcurrentReadState, NoConcurrentReadState> Concurrent;
+
+    [[no_unique_address]] std::conditional_t<Traits::TrackChanges, ChangeTrackingState, NoChangeTrackingState> Changes;
+
+    [[no_unique_address]] mutable typename Traits::StatsT Stats; //mutable so IsValidHandle can count misses
+
+    [[no_unique_address]] std::conditional_t<IncrementalMigration, MigrationState, NoMigrationState> Migration;
+
+public:
+
+    SlotMap(const SlotMap&) = delete; //copies have to be explicit, see Clone
+    SlotMap& operator=(const SlotMap&) = delete;
+
+    //concurrent readers keep referring to the map they read from, so maps with Traits::ConcurrentReads are pinned
+    SlotMap(SlotMap&& Other) noexcept requires(!Traits::ConcurrentReads)
+        : SlotMap(Other.Allocator)
+    {
+        Swap(Other); //a running migration moves along with both of its arrays
+    }
+
+    SlotMap& operator=(SlotMap&& Other) noexcept requires(!Traits::ConcurrentReads)
+    {
+        SlotMap Moved(std::move(Other));
+        Swap(Moved);
+        return *this;
+    }
+
+    SlotMap()
+        : SlotMap(AllocatorT{})
+    {
+    }
+
+    explicit SlotMap(const AllocatorT& InAllocator)
+        : KeyOffsets(nullptr)
+        , ItemGenerations(nullptr)
+        , Items(nullptr)
+        , ItemCount(0)
+        , AllocatedItemCount(0)
+        , ConcurrentAddLimit(0)
+        , ConcurrentAddCursor(0)
+        , ConcurrentAddDropped(nullptr)
+        , PendingRemovalCount(0)
+        , FirstTombstone(0)
+        , MappedMemory(nullptr)
+        , MappedSize(0)
+        , Allocator(InAllocator)
+    {
+    }
+
+    void Swap(SlotMap& Other) noexcept requires(!Traits::ConcurrentReads)
+    {
+        SLOTMAP_ASSERT(ConcurrentAddLimit == 0 && Other.ConcurrentAddLimit == 0, "can't swap during a concurrent add");
+
+        KeyTable::SwapKeys(Other);
+
+        using std::swap;
+        swap(KeyOffsets, Other.KeyOffsets);
+        swap(ItemGenerations, Other.ItemGenerations);
+        swap(Items, Other.Items);
+        swap(ItemCount, Other.ItemCount);
+        swap(AllocatedItemCount, Other.AllocatedItemCount);
+        swap(PendingRemovalCount, Other.PendingRemovalCount);
+        swap(FirstTombstone, Other.FirstTombstone);
+        swap(MappedMemory, Other.MappedMemory);
+        swap(MappedSize, Other.MappedSize);
+        swap(Allocator, Other.Allocator);
+        swap(Changes, Other.Changes);
+        swap(Stats, Other.Stats);
+        swap(Migration, Other.Migration);
+    }
+
+    friend void swap(SlotMap& Left, SlotMap& Right) noexcept requires(!Traits::ConcurrentReads)
+    {
+        Left.Swap(Right);
+    }
+
+    /**
+     * creates an independent copy using the same allocator: keys and key offsets are copied with memcpy, items with memcpy if they are trivially copyable.
+     * every handle into this map is valid in the copy as well
+     */
+    SlotMap Clone() const
+    {
+        static_assert(std::is_copy_constructible_v<ItemT>, "cloning copies every item");
+
+        return SlotMap(*this, CloneTag{});
+    }
+
+    /**
+     * writes a versioned header followed by the raw keys, key offsets and items trough Writer(const void* Data, size_t Size).
+     * Deserialize or MapFromFile restore the exact state so every handle stays valid
+     */
+    template<typename WriterT>
+    void Serialize(WriterT&& Writer) const
+    {
+        static_assert(std::is_trivially_copyable_v<ItemT>, "items are written as raw bytes");
+
+        SerializedHeader Header = MakeSerializedHeader();
+        uint64_t Written = 0;
+
+        auto Write = [&Writer, &Written](uint64_t Offset, const void* Data, size_t Size)
+        {
+            static constexpr char Zeros[64] = {};
+
+            for(; Written < Offset; Written += std::min<uint64_t>(Offset - Written, sizeof(Zeros)))
+            {
+                Writer(static_cast<const void*>(Zeros), static_cast<size_t>(std::min<uint64_t>(Offset - Written, sizeof(Zeros))));
+            }
+
+            if(Size != 0)
+            {
+                Writer(Data, Size);
+                Written += Size;
+            }
+        };
+
+        Write(0, &Header, sizeof(Header));
+        Write(Header.KeysOffset, Keys, Header.KeyCount * sizeof(ItemKey));
+        Write(Header.GenerationsOffset, Generations, Header.KeyCount * SerializedGenerationSize);
+
+        //a running migration splits the items over two arrays, the runs are written in index order so the file does not show it
+        ForEachItemRun([&Write, &Header](int64_t First, int64_t Last, const ItemT*, const KeyOffsetT* RunKeyOffsets)
+        {
+            Write(Header.KeyOffsetsOffset + First * sizeof(KeyOffsetT), RunKeyOffsets, (Last - First) * sizeof(KeyOffsetT));
+        });
+
+        ForEachItemRun([&Write, &Header](int64_t First, int64_t Last, const ItemT* RunItems, const KeyOffsetT*)
+        {
+            Write(Header.ItemsOffset + First * sizeof(ItemT), RunItems, (Last - First) * sizeof(ItemT));
+        });
+
+        Write(Header.ItemsOffset, nullptr, 0);
+        Write(Header.TotalSize, nullptr, 0);
+    }
+
+    /**
+     * replaces the contents with a map written by Serialize, reading trough Reader(void* Data, size_t Size) which returns false on failure.
+     * exactly the bytes Serialize wrote are read, padding included, so several maps can follow each other in one stream.
+     * the keys and key offsets are checked in O(KeyCount + ItemCount) so a truncated or corrupt file can't make later operations index out of
+     * bounds, the items themselves are taken as raw bytes though, so only data from trusted sources should be loaded
+     * @return false if reading failed or the data does not match this map type, the map is left unchanged in that case
+     */
+    template<typename ReaderT>
+    bool Deserialize(ReaderT&& Reader)
+    {
+        static_assert(std::is_trivially_copyable_v<ItemT>, "items are read as raw bytes");
+
+        SerializedHeader Header;
+        uint64_t ReadBytes = 0;
+
+        auto Read = [&Reader, &ReadBytes](uint64_t Offset, void* Data, size_t Size)
+        {
+            char Skipped[64];
+
+            for(; ReadBytes < Offset; ReadBytes += std::min<uint64_t>(Offset - ReadBytes, sizeof(Skipped)))
+            {
+                [[unlikely]] if(!Reader(static_cast<void*>(Skipped), static_cast<size_t>(std::min<uint64_t>(Offset - ReadBytes, sizeof(Skipped)))))
+                {
+                    return false;
+                }
+            }
+
+            ReadBytes += Size;
+            return Size == 0 || static_cast<bool>(Reader(Data, Size));
+        };
+
+        [[unlikely]] if(!Read(0, &Header, sizeof(Header)) || !IsValidSerializedHeader(Header))
+        {
+            return false;
+        }
+
+        const int64_t ItemCapacity = RoundToAllocationSize(Header.ItemCount);
+
+        ItemKey* NewKeys = Header.KeyCount != 0 ? AllocateArray<ItemKey>(Header.KeyCount) : nullptr;
+        GenerationT* NewGenerations = Traits::SplitGenerations && Header.KeyCount != 0 ? AllocateArray<GenerationT>(Header.KeyCount) : nullptr;
+        KeyOffsetT* NewKeyOffsets = ItemCapacity != 0 ? AllocateArray<KeyOffsetT>(ItemCapacity) : nullptr;
+        ItemT* NewItems = ItemCapacity != 0 ? AllocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(ItemCapacity) : nullptr;
+
+        const bool Success = Read(Header.KeysOffset, NewKeys, Header.KeyCount * sizeof(ItemKey))
+            && Read(Header.GenerationsOffset, NewGenerations, Header.KeyCount * SerializedGenerationSize)
+            && Read(Header.KeyOffsetsOffset, NewKeyOffsets, Header.ItemCount * sizeof(KeyOffsetT))
+            && Read(Header.ItemsOffset, NewItems, Header.ItemCount * sizeof(ItemT))
+            && Read(Header.TotalSize, nullptr, 0) //the padding Serialize wrote past the last item, so the next data starts where the reader is
+            && IsValidSerializedStorage(Header, NewKeys, NewGenerations, NewKeyOffsets);
+
+        [[unlikely]] if(!Success)
+        {
+            if(NewKeys)
+            {
+                DeallocateArray(NewKeys, Header.KeyCount);
+            }
+
+            if(NewGenerations)
+            {
+                DeallocateArray(NewGenerations, Header.KeyCount);
+            }
+
+            if(NewItems)
+            {
+                DeallocateArray(NewKeyOffsets, ItemCapacity);
+                DeallocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(NewItems, ItemCapacity);
+            }
+
+            return false;
+        }
+
+        ReplaceStorage(Header, NewKeys, NewGenerations, NewKeyOffsets, NewItems, ItemCapacity);
+
+        return true;
+    }
+
+#if SLOTMAP_HAS_MMAP
+    /**
+     * replaces the contents with a file written by Serialize without copying: the arrays point into a private mapping of the file.
+     * writes stay in memory, the first resize copies the arrays into allocated memory and unmaps the file. the file is checked like in Deserialize,
+     * which reads every key and key offset once, and has to come from a trusted source as well
+     * @return false if the file could not be mapped or does not match this map type, the map is left unchanged in that case
+     */
+    bool MapFromFile(const char* Path)
+    {
+        static_assert(std::is_trivially_copyable_v<ItemT>, "items are mapped as raw bytes");
+        static_assert(!Traits::ConcurrentReads, "concurrent readers could still access the mapping when it is unmapped");
+
+        int File = open(Path, O_RDONLY | O_CLOEXEC);
+        [[unlikely]] if(File < 0)
+        {
+            return false;
+        }
+
+        struct stat FileStat;
+        void* Memory = MAP_FAILED;
+
+        if(fstat(File, &FileStat) == 0 && static_cast<size_t>(FileStat.st_size) >= sizeof(SerializedHeader))
+        {
+            Memory = mmap(nullptr, FileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, File, 0);
+        }
+
+        close(File); //the mapping keeps the file alive
+
+        [[unlikely]] if(Memory == MAP_FAILED)
+        {
+            return false;
+        }
+
+        const SerializedHeader& Header = *static_cast<const SerializedHeader*>(Memory);
+
+        [[unlikely]] if(!IsValidSerializedHeader(Header) || Header.TotalSize > static_cast<uint64_t>(FileStat.st_size) || ItemAlignment > static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+        {
+            munmap(Memory, FileStat.st_size);
+            return false;
+        }
+
+        std::byte* Base = static_cast<std::byte*>(Memory);
+        const SerializedHeader MappedHeader = Header;
+
+        ItemKey* MappedKeys = MappedHeader.KeyCount != 0 ? reinterpret_cast<ItemKey*>(Base + MappedHeader.KeysOffset) : nullptr;
+        GenerationT* MappedGenerations = Traits::SplitGenerations && MappedHeader.KeyCount != 0 ? reinterpret_cast<GenerationT*>(Base + MappedHeader.GenerationsOffset) : nullptr;
+        KeyOffsetT* MappedKeyOffsets = MappedHeader.ItemCount != 0 ? reinterpret_cast<KeyOffsetT*>(Base + MappedHeader.KeyOffsetsOffset) : nullptr;
+
+        [[unlikely]] if(!IsValidSerializedStorage(MappedHeader, MappedKeys, MappedGenerations, MappedKeyOffsets))
+        {
+            munmap(Memory, FileStat.st_size);
+            return false;
+        }
+
+        ReplaceStorage(MappedHeader, MappedKeys, MappedGenerations, MappedKeyOffsets,
+            MappedHeader.ItemCount != 0 ? reinterpret_cast<ItemT*>(Base + MappedHeader.ItemsOffset) : nullptr,
+            MappedHeader.ItemCount);
+
+        MappedMemory = Memory;
+        MappedSize = FileStat.st_size;
+
+        return true;
+    }
+#endif
+
+    //true while the arrays still point into a file mapped by MapFromFile
+    bool IsMapped() const
+    {
+        return MappedMemory != nullptr;
+    }
+
+    //reports the item as Modified in the next CollectChanges, returns false if the handle was invalid
+    bool MarkDirty(KeyHandle Handle)
+    {
+        static_assert(Traits::TrackChanges, "MarkDirty requires Traits::TrackChanges");
+
+        [[unlikely]] if(GetKey(Handle) == nullptr)
+        {
+            return false;
+        }
+
+        ListChangedKey(Handle.Index);
+        return true;
+    }
+
+    /**
+     * calls Visitor(SlotMapChange, KeyHandle, const ItemT*) for every change since the last call and starts a new epoch.
+     * removed handles are reported first and without an item, keys that were added and removed in between are not reported at all.
+     * costs O(changes), not O(items)
+     */
+    template<typename VisitorT>
+    void CollectChanges(VisitorT&& Visitor)
+    {
+        static_assert(Traits::TrackChanges, "CollectChanges requires Traits::TrackChanges");
+
+        for(KeyHandle Handle : Changes.RemovedHandles)
+        {
+            Visitor(SlotMapChange::Removed, Handle, static_cast<const ItemT*>(nullptr));
+        }
+
+        for(uint64_t KeyIndex : Changes.ChangedKeys)
+        {
+            const uint64_t Word = KeyIndex / 64;
+            const uint64_t Bit = uint64_t(1) << (KeyIndex % 64);
+
+            const ItemKey& Key = Keys[KeyIndex];
+
+            //free keys point to the next free key, which never maps back to them trough KeyOffsets
+            if(Key.Index < static_cast<uint64_t>(ItemCount) && *KeyOffsetPointer(Key.Index) == KeyIndex)
+            {
+                const SlotMapChange Change = (Changes.AddedBits[Word] & Bit) ? SlotMapChange::Added : SlotMapChange::Modified;
+                Visitor(Change, MakeHandle(KeyIndex), static_cast<const ItemT*>(ItemPointer(Key.Index)));
+            }
+
+            Changes.ListedBits[Word] &= ~Bit;
+            Changes.AddedBits[Word] &= ~Bit;
+        }
+
+        Changes.ChangedKeys.clear();
+        Changes.RemovedHandles.clear();
+    }
+
+    ~SlotMap()
+    {
+        if constexpr(!std::is_trivially_destructible_v<ItemT>)
+        {
+            while(ItemCount != 0)
+            {
+                --ItemCount;
+                ItemPointer(ItemCount)->ItemT::~ItemT();
+            }
+        }
+
+        FreeMigratedArrays();
+
+        if(MappedMemory)
+        {
+            UnmapFile();
+        }
+        else
+        {
+            if(Keys)
+            {
+                DeallocateArray(Keys, KeyCount);
+            }
+
+            if(Generations)
+            {
+                DeallocateArray(Generations, KeyCount);
+            }
+
+            if(Items)
+            {
+                DeallocateArray(KeyOffsets, AllocatedItemCount);
+                DeallocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Items, AllocatedItemCount);
+            }
+        }
+
+        if(ItemGenerations) //never mapped
+        {
+            DeallocateArray(ItemGenerations, AllocatedItemCount);
+        }
+
+        if constexpr(Traits::ConcurrentReads) //no reader may be active anymore
+        {
+            if(const ReaderSnapshot* Snapshot = Concurrent.Snapshot.load(std::memory_order_relaxed))
+            {
+                DeallocateArray(const_cast<ReaderSnapshot*>(Snapshot), 1);
+            }
+
+            FreeRetired(UINT64_MAX);
+
+            if(Concurrent.Retired)
+            {
+                DeallocateArray(Concurrent.Retired, Concurrent.RetiredCapacity);
+            }
+        }
+    }
+
+    bool IsValidHandle(KeyHandle Handle) const
+    {
+        const bool Valid = IsLiveHandle(Handle);
+        Stats.OnHandleCheck(Valid);
+        return Valid;
+    }
+
+    //constructs the item in place from Args like emplace_back: with parentheses if ItemT has a matching constructor, with braces otherwise. no intermediate copies are made
+    template<typename... Ts>
+    KeyHandle Emplace(Ts&&... Args)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Args)...);
+    }
+
+    //same as Emplace but returns NullHandle instead of asserting when IndexMax or a fixed capacity is reached
+    template<typename... Ts>
+    KeyHandle TryEmplace(Ts&&... Args)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            return NullHandle;
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Args)...);
+    }
+
+    KeyHandle Add(const ItemT& Item)
+    {
+        return Emplace(Item);
+    }
+
+    KeyHandle Add(ItemT&& Item)
+    {
+        return Emplace(std::move(Item));
+    }
+
+    //constructs the item with braces like Add always did, Add(3, 5) on a std::vector<int> stores {3, 5}. Emplace constructs like emplace_back
+    template<typename... Ts>
+    KeyHandle Add(Ts&&... Args)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        return EmplaceUnchecked<true>(std::forward<Ts>(Args)...);
+    }
+
+    /**
+     * adds Count items constructed in place from Generator(Index) with Index in [0, Count)
+     * keys and items are grown at most once for the whole range.
+     * if OutHandles is not empty it has to fit Count handles and receives them in order.
+     * if the generator throws, the items it made before are kept and their handles are in OutHandles
+     */
+    template<typename GeneratorT>
+    void AddRange(int64_t Count, GeneratorT&& Generator, std::span<KeyHandle> OutHandles = {})
+    {
+        SLOTMAP_ASSERT(Count >= 0);
+        SLOTMAP_ASSERT(OutHandles.empty() || std::ssize(OutHandles) >= Count, "not enough space for the output handles");
+
+        [[unlikely]] if(!ReserveForAdd(Count))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        //reports the items that were added and steps the migration for them, also when the generator throws
+        struct AddedItems
+        {
+            SlotMap& Map;
+            int64_t Count = 0;
+
+            ~AddedItems() noexcept(false)
+            {
+                Map.Stats.OnItemCount(Map.ItemCount);
+                Map.AdvanceMigration(Count);
+            }
+        } Added{*this};
+
+        for(int64_t Index = 0; Index < Count; ++Index)
+        {
+            //the item is constructed directly in place when the generator returns a prvalue
+            new(Items + ItemCount) ItemT(std::invoke(Generator, Index));
+
+            uint64_t KeyIndex = BindFreeKey(ItemCount);
+            BindSlot(ItemCount, KeyIndex);
+            ItemCount += 1;
+            Added.Count += 1;
+
+            RecordAdded(KeyIndex);
+
+            if(!OutHandles.empty())
+            {
+                OutHandles[Index] = MakeHandle(KeyIndex);
+            }
+        }
+    }
+
+    //copies all items in Source, see AddRange
+    void AddN(std::span<const ItemT> Source, std::span<KeyHandle> OutHandles = {})
+    {
+        AddRange(std::ssize(Source), [Source](int64_t Index) -> const ItemT& { return Source[Index]; }, OutHandles);
+    }
+
+    /**
+     * removes the items of all valid handles, invalid (and duplicate) handles are skipped.
+     * with Shift the items are marked and the gaps closed in one Flush pass. with SwapWithLast every item is still swap-removed on its own,
+     * which moves at most one item per handle, where a compaction pass would have to read every item past the first removed one.
+     * the freed keys are chained together and spliced onto the freelist once, and the shrink heuristic only runs once.
+     * @return the number of removed items
+     */
+    int64_t RemoveBatch(std::span<const KeyHandle> Handles)
+    {
+        if constexpr(Traits::RemovalPolicy == SlotMapRemovalPolicy::Shift) //one compaction pass instead of a shift per handle
+        {
+            int64_t RemovedCount = 0;
+
+            for(KeyHandle Handle : Handles)
+            {
+                RemovedCount += MarkRemoved(Handle);
+            }
+
+            Flush();
+
+            return RemovedCount;
+        }
+
+        int64_t RemovedCount = 0;
+        int64_t ChainLength = 0;
+        uint64_t ChainHead = 0;
+        uint64_t ChainTail = 0;
+
+        for(KeyHandle Handle : Handles)
+        {
+            ItemKey* Key = GetKey(Handle);
+            if(Key == nullptr)
+            {
+                continue;
+            }
+
+            EraseItem(Key);
+
+            uint64_t KeyIndex = std::distance(Keys, Key);
+            RemovedCount += 1;
+
+            [[unlikely]] if(KeyID(KeyIndex) == IdMax)
+            {
+                RetiredKeyCount += 1;
+                continue;
+            }
+
+            if(ChainLength == 0)
+            {
+                ChainHead = KeyIndex;
+            }
+            else
+            {
+                Keys[ChainTail].Index = KeyIndex;
+            }
+
+            ChainTail = KeyIndex;
+            ChainLength += 1;
+        }
+
+        if(ChainLength != 0)
+        {
+            Keys[FreelistTail].Index = ChainHead;
+            FreelistTail = ChainTail;
+        }
+
+        if(RemovedCount != 0)
+        {
+            ShrinkItemsIfSparse();
+        }
+
+        return RemovedCount;
+    }
+
+    /**
+     * resolves every handle to its item, invalid handles resolve to nullptr.
+     * uses AVX-512 or AVX2 gathers on the keys when available
+     * @return the number of valid handles
+     */
+    int64_t Resolve(std::span<const KeyHandle> Handles, std::span<ItemT*> OutItems)
+    {
+        return ResolveInto(Handles, OutItems);
+    }
+
+    int64_t Resolve(std::span<const KeyHandle> Handles, std::span<const ItemT*> OutItems) const
+    {
+        return ResolveInto(Handles, OutItems);
+    }
+
+    /**
+     * sets bit (Index % 64) of OutMask[Index / 64] for every valid handle and clears it for every invalid one
+     * @return the number of valid handles
+     */
+    int64_t ValidateMask(std::span<const KeyHandle> Handles, std::span<uint64_t> OutMask) const
+    {
+        SLOTMAP_ASSERT(std::ssize(OutMask) * 64 >= std::ssize(Handles), "not enough space for the output mask");
+
+        int64_t ValidCount = 0;
+        uint64_t ItemIndices[64];
+
+        for(int64_t First = 0; First < std::ssize(Handles); First += 64)
+        {
+            int64_t Count = std::min<int64_t>(64, std::ssize(Handles) - First);
+            uint64_t Mask = ValidateChunk(Handles.data() + First, Count, ItemIndices);
+
+            OutMask[First / 64] = Mask;
+            ValidCount += std::popcount(Mask);
+        }
+
+        return ValidCount;
+    }
+
+    /**
+     * calls Function(Item) or Function(Item, Handle) for the item of every valid handle, in order. invalid handles are skipped.
+     * the key of the handle Traits::PrefetchDistance steps ahead is prefetched, and once that key had time to arrive the item it points to
+     * is prefetched as well, so the two dependent cache misses of each lookup overlap with the work on earlier handles
+     */
+    template<typename Self, typename FunctionT>
+    void ForEachHandle(this Self&& self, std::span<const KeyHandle> Handles, FunctionT&& Function)
+    {
+        constexpr int64_t KeyDistance = Traits::PrefetchDistance;
+        constexpr int64_t ItemDistance = Traits::PrefetchDistance / 2;
+
+        const int64_t Count = std::ssize(Handles);
+
+        for(int64_t Index = 0; Index < Count; ++Index)
+        {
+            if constexpr(KeyDistance > 0)
+            {
+                if(Index + KeyDistance < Count)
+                {
+                    KeyHandle Ahead = Handles[Index + KeyDistance];
+                    if(Ahead.Index < static_cast<uint64_t>(self.KeyCount))
+                    {
+                        __builtin_prefetch(self.Keys + Ahead.Index);
+
+                        if constexpr(Traits::SplitGenerations)
+                        {
+                            __builtin_prefetch(self.Generations + Ahead.Index);
+                        }
+                    }
+                }
+
+                if(Index + ItemDistance < Count)
+                {
+                    KeyHandle Ahead = Handles[Index + ItemDistance];
+                    if(self.IsLiveHandle(Ahead)) //the handle is checked again once it is reached, only that check counts
+                    {
+                        __builtin_prefetch(self.ItemPointer(self.Keys[Ahead.Index].Index));
+                    }
+                }
+            }
+
+            KeyHandle Handle = Handles[Index];
+            if(self.IsValidHandle(Handle))
+            {
+                auto& Item = *self.ItemPointer(self.Keys[Handle.Index].Index);
+
+                if constexpr(std::is_invocable_v<FunctionT&, decltype(Item), KeyHandle>)
+                {
+                    Function(Item, Handle);
+                }
+                else
+                {
+                    Function(Item);
+                }
+            }
+        }
+    }
+
+    /**
+     * copies the item of Handle into OutItem, returns false if the handle was invalid.
+     * may be called from any thread while a single writer thread keeps mutating the map, requires Traits::ConcurrentReads.
+     * only the writes of the map itself are fenced for readers: an item written in place trough operator[], the iterators or Entries can be
+     * copied half written, the writer has to change items that readers may see trough Modify
+     */
+    bool ConcurrentRead(KeyHandle Handle, ItemT& OutItem) const
+    {
+        static_assert(Traits::ConcurrentReads, "ConcurrentRead requires Traits::ConcurrentReads");
+        return ConcurrentAccess(Handle, &OutItem);
+    }
+
+    /**
+     * calls Function(Item) for the item of Handle, returns false if the handle was invalid. with Traits::ConcurrentReads the call is a write
+     * section, so ConcurrentRead never returns an item Function only partially wrote. with Traits::TrackChanges the item is reported as Modified like after MarkDirty
+     */
+    template<typename FunctionT>
+    bool Modify(KeyHandle Handle, FunctionT&& Function)
+    {
+        ItemKey* Key = GetKey(Handle);
+
+        [[unlikely]] if(!Key)
+        {
+            return false;
+        }
+
+        WriteScope Scope(*this);
+        Function(*ItemPointer(Key->Index));
+
+        if constexpr(Traits::TrackChanges)
+        {
+            ListChangedKey(Handle.Index);
+        }
+
+        return true;
+    }
+
+    //IsValidHandle for threads other than the writer, requires Traits::ConcurrentReads
+    bool ConcurrentIsValidHandle(KeyHandle Handle) const
+    {
+        static_assert(Traits::ConcurrentReads, "ConcurrentIsValidHandle requires Traits::ConcurrentReads");
+        return ConcurrentAccess(Handle, nullptr);
+    }
+
+    //frees memory retired by earlier resizes that no concurrent reader can see anymore, writer only. resizes call this on their own
+    void Reclaim()
+    {
+        static_assert(Traits::ConcurrentReads, "Reclaim requires Traits::ConcurrentReads");
+
+        uint64_t Epoch = Concurrent.Epoch.load(std::memory_order_relaxed);
+
+        //the next epoch reuses the reader count of the previous one, so it can only start once those readers left
+        if(Concurrent.ActiveReaders[(Epoch + 1) & 1].load(std::memory_order_seq_cst) == 0)
+        {
+            FreeRetired(Epoch - 1);
+            Concurrent.Epoch.store(Epoch + 1, std::memory_order_seq_cst);
+        }
+    }
+
+    /**
+     * a run of dense slots claimed by one producer thread during a concurrent add, filled trough Emplace.
+     * slots left empty when the block is destroyed, because a constructor threw or the producer stopped early, are never published:
+     * EndConcurrentAdd closes the gaps and returns their keys to the freelist
+     */
+    class ConcurrentAddBlock
+    {
+        friend SlotMap;
+
+        SlotMap* Map;
+        int64_t First; //first claimed dense slot
+        int64_t Count;
+        int64_t Used;
+
+        ConcurrentAddBlock(SlotMap* InMap, int64_t InFirst, int64_t InCount)
+            : Map(InMap)
+            , First(InFirst)
+            , Count(InCount)
+            , Used(0)
+        {
+        }
+
+    public:
+
+        ConcurrentAddBlock(const ConcurrentAddBlock&) = delete;
+
+        ~ConcurrentAddBlock()
+        {
+            [[unlikely]] if(Used != Count)
+            {
+                Map->DropConcurrentSlots(First + Used, First + Count);
+            }
+        }
+
+        template<typename... Ts>
+        KeyHandle Emplace(Ts&&... Args)
+        {
+            SLOTMAP_ASSERT(Used < Count, "the block is full");
+
+            int64_t Slot = First + Used;
+            Map->ConstructItem(Map->Items + Slot, std::forward<Ts>(Args)...);
+            Used += 1;
+
+            return Map->SlotHandle(Slot);
+        }
+
+        int64_t Size() const
+        {
+            return Count;
+        }
+
+        int64_t Remaining() const
+        {
+            return Count - Used;
+        }
+    };
+
+    /**
+     * prepares up to MaxCount items to be added from any number of threads trough ClaimConcurrentBlock and ConcurrentEmplace.
+     * the map grows once and MaxCount keys are popped off the freelist and bound to the dense slots past the last item,
+     * so producer threads only have to bump a shared cursor. no other member may be used until EndConcurrentAdd
+     */
+    void BeginConcurrentAdd(int64_t MaxCount)
+    {
+        SLOTMAP_ASSERT(ConcurrentAddLimit == 0, "a concurrent add is already in progress");
+
+        [[unlikely]] if(!ReserveForAdd(MaxCount))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        for(int64_t Slot = ItemCount; Slot < ItemCount + MaxCount; ++Slot)
+        {
+            BindSlot(Slot, BindFreeKey(Slot));
+        }
+
+        const int64_t DroppedWords = (MaxCount + 63) / 64;
+
+        [[likely]] if(DroppedWords != 0)
+        {
+            ConcurrentAddDropped = AllocateArray<uint64_t>(DroppedWords);
+            std::memset(ConcurrentAddDropped, 0, DroppedWords * sizeof(uint64_t));
+        }
+
+        ConcurrentAddLimit = MaxCount;
+        ConcurrentAddCursor = 0;
+    }
+
+    //thread safe, claims Count slots for the calling thread. the block is smaller than requested once MaxCount slots have been claimed
+    ConcurrentAddBlock ClaimConcurrentBlock(int64_t Count)
+    {
+        int64_t First = std::atomic_ref(ConcurrentAddCursor).fetch_add(Count, std::memory_order_relaxed);
+        int64_t Claimed = std::clamp<int64_t>(ConcurrentAddLimit - First, 0, Count);
+
+        return ConcurrentAddBlock(this, ItemCount + First, Claimed);
+    }
+
+    //thread safe, returns NullHandle once MaxCount items have been added
+    template<typename... Ts>
+    KeyHandle ConcurrentEmplace(Ts&&... Args)
+    {
+        ConcurrentAddBlock Block = ClaimConcurrentBlock(1);
+        if(Block.Size() == 0)
+        {
+            return NullHandle;
+        }
+
+        return Block.Emplace(std::forward<Ts>(Args)...);
+    }
+
+    /**
+     * publishes all items added since BeginConcurrentAdd and returns the keys of unclaimed and unfilled slots to the freelist, all producers have to be done.
+     * items past a slot that a block left empty are moved down to close the gap, so their handles stay valid but the items may move
+     */
+    void EndConcurrentAdd()
+    {
+        const int64_t Claimed = std::min(ConcurrentAddCursor, ConcurrentAddLimit);
+        const int64_t Filled = Claimed - CompactConcurrentSlots(Claimed);
+
+        //unused keys were the first keys on the freelist, put them back in the same order
+        for(int64_t Slot = ItemCount + ConcurrentAddLimit - 1; Slot >= ItemCount + Filled; --Slot)
+        {
+            uint64_t KeyIndex = KeyOffsets[Slot];
+            Keys[KeyIndex].Index = FreelistHead;
+            FreelistHead = KeyIndex;
+        }
+
+        if constexpr(Traits::TrackChanges)
+        {
+            for(int64_t Slot = ItemCount; Slot < ItemCount + Filled; ++Slot)
+            {
+                RecordAdded(KeyOffsets[Slot]);
+            }
+        }
+
+        [[likely]] if(ConcurrentAddDropped)
+        {
+            DeallocateArray(ConcurrentAddDropped, (ConcurrentAddLimit + 63) / 64);
+            ConcurrentAddDropped = nullptr;
+        }
+
+        ItemCount += Filled;
+        ConcurrentAddLimit = 0;
+        ConcurrentAddCursor = 0;
+
+        Stats.OnItemCount(ItemCount);
+        AdvanceMigration(Filled);
+    }
+
+    //returns false if the handle was invalid, true otherwise
+    bool Remove(KeyHandle Handle)
+    {
+        ItemKey* Key = GetKey(Handle);
+        if(Key == nullptr)
+        {
+            return false;
+        }
+
+        Remove(Key);
+        return true;
+    }
+
+    void Remove(uint64_t Index)
+    {
+        Remove(GetKey(Index));
+    }
+
+    void Remove(ItemT* Item)
+    {
+        Remove(GetKey(Item));
+    }
+
+    /**
+     * invalidates the handle right away but leaves its item in place until Flush, so the dense order does not change while iterating.
+     * the item stays in begin()..end() and counts towards Size() until then, IsMarkedRemoved tells which items are pending.
+     * @return false if the handle was invalid
+     */
+    bool MarkRemoved(KeyHandle Handle)
+    {
+        ItemKey* Key = GetKey(Handle);
+        if(Key == nullptr)
+        {
+            return false;
+        }
+
+        WriteScope Scope(*this);
+
+        RecordRemoved(std::distance(Keys, Key));
+        BumpKeyID(std::distance(Keys, Key));
+
+        int64_t ItemIndex = Key->Index;
+        *KeyOffsetPointer(ItemIndex) = TombstoneOffset;
+
+        FirstTombstone = PendingRemovalCount == 0 ? ItemIndex : std::min(FirstTombstone, ItemIndex);
+        PendingRemovalCount += 1;
+
+        //the key is free from now on, only the item waits for Flush
+        ReleaseKey(std::distance(Keys, Key));
+
+        return true;
+    }
+
+    bool IsMarkedRemoved(int64_t Index) const
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
+        return *KeyOffsetPointer(Index) == TombstoneOffset;
+    }
+
+    int64_t PendingRemovals() const
+    {
+        return PendingRemovalCount;
+    }
+
+    using KeyTable::RetiredKeys;
+    using KeyTable::KeyCapacity;
+
+    //number of keys on the freelist, items can be added without growing the keys until fewer than Traits::MinFreeKeys are left
+    int64_t FreeKeys() const
+    {
+        return KeyCount - (ItemCount - PendingRemovalCount) - RetiredKeyCount - ConcurrentAddLimit;
+    }
+
+    //the Traits::StatsT policy, non-const access is used to reset counters or set callbacks
+    template<typename Self>
+    decltype(auto) GetStats(this Self&& self)
+    {
+        return (self.Stats);
+    }
+
+    /**
+     * resets the ID of every retired key and puts it back on the freelist.
+     * @warning the caller has to guarantee that no handle to a retired key survived, e.g. after dropping all stored handles or reloading a level, otherwise old handles can match again
+     * @return the number of recycled keys
+     */
+    int64_t RecycleRetiredKeys()
+    {
+        SLOTMAP_ASSERT(ConcurrentAddLimit == 0, "can't recycle keys during a concurrent add");
+
+        return KeyTable::RecycleRetiredKeys();
+    }
+
+    //destroys all items marked by MarkRemoved and closes the gaps in one linear pass, keeping the order of the remaining items
+    void Flush()
+    {
+        if(PendingRemovalCount == 0)
+        {
+            return;
+        }
+
+        WriteScope Scope(*this);
+
+        MigrateTail(FirstTombstone); //only the compacted range has to be in one array
+
+        int64_t WriteIndex = FirstTombstone;
+
+        for(int64_t ReadIndex = FirstTombstone; ReadIndex < ItemCount; ++ReadIndex)
+        {
+            if(KeyOffsets[ReadIndex] == TombstoneOffset)
+            {
+                Items[ReadIndex].ItemT::~ItemT();
+                continue;
+            }
+
+            new(Items + WriteIndex) ItemT(std::move(Items[ReadIndex]));
+            Items[ReadIndex].ItemT::~ItemT();
+
+            MoveSlot(WriteIndex, ReadIndex);
+            Keys[KeyOffsets[WriteIndex]].Index = WriteIndex;
+
+            WriteIndex += 1;
+        }
+
+        ItemCount = WriteIndex;
+        PendingRemovalCount = 0;
+
+        ShrinkItemsIfSparse();
+    }
+
+    /**
+     * moves the item at Order[Index] to Index for every dense index, Order must be a permutation of [0, Size()) which debug builds assert.
+     * handles stay valid, pending removals are flushed first so Order has to be built after that
+     */
+    void ReorderBy(std::span<const int64_t> Order)
+    {
+        static_assert(std::is_swappable_v<ItemT>, "reordering swaps items in place");
+
+        SLOTMAP_ASSERT(PendingRemovalCount == 0, "flush before building the order");
+        SLOTMAP_ASSERT(std::ssize(Order) == ItemCount, "the order has to cover every item");
+
+        WriteScope Scope(*this);
+
+        CompleteMigration();
+
+#ifndef NDEBUG
+        //an index listed twice leaves another key pointing at a stale index and the cycles below may never close
+        std::vector<bool> Taken(ItemCount);
+#endif
+
+        //point every key at the index its item moves to
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            SLOTMAP_ASSERT((Order[Index] >= 0) & (Order[Index] < ItemCount));
+
+#ifndef NDEBUG
+            SLOTMAP_ASSERT(!Taken[Order[Index]], "Order has to be a permutation, an index appears twice");
+            Taken[Order[Index]] = true;
+#endif
+
+            Keys[KeyOffsets[Order[Index]]].Index = Index;
+        }
+
+        //follow the cycles, every swap puts one item at its final index
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            for(uint64_t Target = Keys[KeyOffsets[Index]].Index; Target != static_cast<uint64_t>(Index); Target = Keys[KeyOffsets[Index]].Index)
+            {
+                using std::swap;
+                swap(Items[Index], Items[Target]);
+                swap(KeyOffsets[Index], KeyOffsets[Target]);
+
+                if constexpr(Traits::CacheGenerations)
+                {
+                    swap(ItemGenerations[Index], ItemGenerations[Target]);
+                }
+            }
+        }
+    }
+
+    //sorts the dense items by Compare(const ItemT&, const ItemT&) without invalidating any handle
+    template<typename CompareT = std::less<>>
+    void Sort(CompareT&& Compare = CompareT())
+    {
+        Flush();
+        CompleteMigration();
+
+        std::vector<int64_t> Order(ItemCount);
+
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            Order[Index] = Index;
+        }
+
+        std::sort(Order.begin(), Order.end(), [this, &Compare](int64_t Left, int64_t Right)
+        {
+            return Compare(std::as_const(Items[Left]), std::as_const(Items[Right]));
+        });
+
+        ReorderBy(Order);
+    }
+
+    /**
+     * removes every item in one pass: destroys the items, invalidates the handles of all live keys and relinks the freelist trough all keys in index order.
+     * KeepCapacity keeps the item allocation for refilling, otherwise it is shrunk according to Traits::GrowthPolicy
+     */
+    void Clear(bool KeepCapacity = false)
+    {
+        SLOTMAP_ASSERT(ConcurrentAddLimit == 0, "can't clear during a concurrent add");
+
+        {
+            WriteScope Scope(*this);
+
+            for(int64_t Index = 0; Index < ItemCount; ++Index)
+            {
+                const uint64_t KeyIndex = *KeyOffsetPointer(Index);
+
+                //marked items already gave up their key
+                [[likely]] if(KeyIndex != TombstoneOffset)
+                {
+                    RecordRemoved(KeyIndex);
+                    RetiredKeyCount += BumpKeyID(KeyIndex) == IdMax;
+                }
+
+                if constexpr(!std::is_trivially_destructible_v<ItemT>)
+                {
+                    ItemPointer(Index)->ItemT::~ItemT();
+                }
+            }
+
+            FreeMigratedArrays(); //nothing is left to move
+
+            RelinkFreelist();
+
+            ItemCount = 0;
+            PendingRemovalCount = 0;
+        }
+
+        StartQueuedResize();
+
+        if(!KeepCapacity)
+        {
+            ShrinkItemsIfSparse();
+        }
+    }
+
+    KeyHandle GetHandle(int64_t Index) const
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
+        SLOTMAP_ASSERT(*KeyOffsetPointer(Index) != TombstoneOffset, "the item was marked removed");
+
+        return SlotHandle(Index);
+    }
+
+    KeyHandle GetHandle(ItemT* Item) const
+    {
+        return GetHandle(IndexOfItem(Item));
+    }
+
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, KeyHandle Handle)
+    {
+        if(auto* Key = self.GetKey(Handle))
+        {
+            return self.ItemPointer(Key->Index);
+        }
+
+        return (decltype(self.Items))nullptr;
+    }
+
+    template<typename Self>
+    decltype(auto) operator[](this Self&& self, int64_t Index)
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < self.ItemCount));
+        return *self.ItemPointer(Index);
+    }
+
+    /**
+     * the dense items are only contiguous once a migration is complete, so iterating finishes it first. a const map can't do that without
+     * writing behind the back of other readers, so with Traits::MigrationBudget it has no contiguous range, Entries works on both arrays instead
+     */
+    template<typename Self> requires(!IncrementalMigration || !std::is_const_v<std::remove_reference_t<Self>>)
+    decltype(auto) begin(this Self&& self)
+    {
+        if constexpr(!std::is_const_v<std::remove_reference_t<Self>>)
+        {
+            self.CompleteMigration();
+        }
+
+        return self.Items;
+    }
+
+    template<typename Self> requires(!IncrementalMigration || !std::is_const_v<std::remove_reference_t<Self>>)
+    decltype(auto) end(this Self&& self)
+    {
+        if constexpr(!std::is_const_v<std::remove_reference_t<Self>>)
+        {
+            self.CompleteMigration();
+        }
+
+        return self.Items + self.ItemCount;
+    }
+
+    //the dense items as a contiguous, random access and sized range that parallel algorithms and schedulers can split
+    template<typename Self> requires(!IncrementalMigration || !std::is_const_v<std::remove_reference_t<Self>>)
+    decltype(auto) AsSpan(this Self&& self)
+    {
+        return std::span(self.begin(), self.end());
+    }
+
+    //a handle and the item it refers to, yielded by Entries so it can be bound as auto [Handle, Item]
+    template<typename EntryItemT>
+    struct Entry
+    {
+        KeyHandle Handle;
+        EntryItemT& Item;
+    };
+
+    //forward iterator over the dense items that skips items marked removed and rebuilds handles from the streamed key offsets
+    template<typename MapT>
+    class EntryIterator
+    {
+    public:
+        using value_type = Entry<std::conditional_t<std::is_const_v<MapT>, const ItemT, ItemT>>;
+        using difference_type = std::ptrdiff_t;
+
+        EntryIterator() = default;
+
+        EntryIterator(MapT* InMap, int64_t InIndex)
+            : Map(InMap)
+            , Index(InIndex)
+        {
+            SkipTombstones();
+        }
+
+        value_type operator*() const
+        {
+            return value_type{Map->SlotHandle(Index), *Map->ItemPointer(Index)};
+        }
+
+        EntryIterator& operator++()
+        {
+            Index += 1;
+            SkipTombstones();
+            return *this;
+        }
+
+        EntryIterator operator++(int)
+        {
+            EntryIterator Previous = *this;
+            ++*this;
+            return Previous;
+        }
+
+        bool operator==(const EntryIterator& Other) const
+        {
+            return Index == Other.Index;
+        }
+
+    private:
+        void SkipTombstones()
+        {
+            [[unlikely]] if(Map->PendingRemovalCount != 0)
+            {
+                while(Index < Map->ItemCount && *Map->KeyOffsetPointer(Index) == TombstoneOffset)
+                {
+                    Index += 1;
+                }
+            }
+        }
+
+        MapT* Map = nullptr;
+        int64_t Index = 0;
+    };
+
+    /**
+     * the live items paired with their handles: for(auto [Handle, Item] : Map.Entries()).
+     * KeyOffsets is read sequentially, the ID of each handle comes from its key unless Traits::CacheGenerations keeps a copy next to the offset.
+     * during a migration the items are read from whichever array holds them, nothing is moved
+     */
+    template<typename Self>
+    auto Entries(this Self&& self)
+    {
+        using MapT = std::conditional_t<std::is_const_v<std::remove_reference_t<Self>>, const SlotMap, SlotMap>;
+        MapT* Map = &self;
+
+        return std::ranges::subrange(EntryIterator<MapT>(Map, 0), EntryIterator<MapT>(Map, Map->ItemCount));
+    }
+
+    /**
+     * splits the dense items into tasks of Grain items and runs them trough Dispatch(TaskCount, Task), which calls Task(Index) for every
+     * task index, possibly in parallel. Function(Item) or Function(Item, Handle) is called for every item that is not marked removed.
+     * the default SlotMapThreadDispatch from slotmapdispatch.hpp starts threads on every call and rethrows the first exception of a task,
+     * pass the parallel-for of a thread pool to avoid the thread starts
+     */
+    template<typename Self, typename FunctionT, typename DispatchT = SlotMapThreadDispatch>
+    void ParallelForEach(this Self&& self, FunctionT&& Function, int64_t Grain = Traits::ParallelGrain, DispatchT&& Dispatch = DispatchT())
+    {
+        SLOTMAP_ASSERT(Grain > 0);
+
+        const int64_t Count = self.ItemCount;
+        const int64_t TaskCount = (Count + Grain - 1) / Grain;
+
+        auto Task = [&self, &Function, Grain, Count](int64_t TaskIndex)
+        {
+            const int64_t Last = std::min(Count, (TaskIndex + 1) * Grain);
+            const bool HasTombstones = self.PendingRemovalCount != 0;
+
+            for(int64_t Index = TaskIndex * Grain; Index < Last; ++Index)
+            {
+                uint64_t KeyIndex = *self.KeyOffsetPointer(Index);
+
+                [[unlikely]] if(HasTombstones && KeyIndex == TombstoneOffset)
+                {
+                    continue;
+                }
+
+                auto& Item = *self.ItemPointer(Index);
+
+                if constexpr(std::is_invocable_v<FunctionT&, decltype(Item), KeyHandle>)
+                {
+                    Function(Item, self.SlotHandle(Index));
+                }
+                else
+                {
+                    Function(Item);
+                }
+            }
+        };
+
+        if(TaskCount == 1) //not worth dispatching
+        {
+            Task(0);
+        }
+        else if(TaskCount > 1)
+        {
+            Dispatch(TaskCount, Task);
+        }
+    }
+
+    //grows the allocations to fit at least ItemCapacity items and KeyCapacity keys, never shrinks. during a migration the item growth starts once it is done
+    void Reserve(int64_t ItemCapacity, int64_t KeyCapacity)
+    {
+        SLOTMAP_ASSERT(KeyCapacity <= KeyCountMax, "reached max index. consider increasing IndexBits");
+
+        if(KeyCapacity > KeyCount)
+        {
+            ResizeKeys(KeyCapacity);
+        }
+
+        if(ItemCapacity > AllocatedItemCount)
+        {
+            ResizeItems(ItemCapacity);
+        }
+    }
+
+    //reserves enough keys for ItemCapacity items
+    void Reserve(int64_t ItemCapacity)
+    {
+        Reserve(ItemCapacity, std::min(ItemCapacity + RetiredKeyCount + Traits::MinFreeKeys, KeyCountMax));
+    }
+
+    //releases unused item memory, keys are kept since their IDs have to outlive any handle. with Traits::MigrationBudget the old memory is released once the migration is done
+    void ShrinkToFit()
+    {
+        ResizeItems(ItemCount);
+    }
+
+    /**
+     * with Traits::MigrationBudget an item resize only allocates the new arrays, every Add and Remove then moves that many items over
+     * and lookups find the rest in the old arrays until they arrived. Flush, Sort and iterating a mutable map complete the migration first, Entries, Clone and Serialize read from both arrays
+     */
+    bool IsMigrating() const
+    {
+        if constexpr(IncrementalMigration)
+        {
+            return Migration.Capacity != 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    //moves up to Budget more items during idle time, returns true while items are left
+    bool StepMigration(int64_t Budget)
+    {
+        SLOTMAP_ASSERT(Budget >= 0);
+
+        if constexpr(IncrementalMigration)
+        {
+            if(Migration.Capacity != 0)
+            {
+                MigrateItems(Budget);
+            }
+
+            StartQueuedResize();
+        }
+
+        return IsMigrating();
+    }
+
+    //moves all remaining items at once, a resize queued during the migration starts with the next add, remove or StepMigration
+    void CompleteMigration()
+    {
+        if constexpr(IncrementalMigration)
+        {
+            [[unlikely]] if(Migration.Capacity != 0)
+            {
+                MigrateItems(INT64_MAX);
+            }
+        }
+    }
+
+    //number of items that fit without reallocating
+    int64_t Capacity() const
+    {
+        return AllocatedItemCount;
+    }
+
+    int64_t Size() const
+    {
+        return ItemCount;
+    }
+
+    int64_t SizeBytes() const
+    {
+        return ItemCount * sizeof(ItemT);
+    }
+
+    const AllocatorT& GetAllocator() const
+    {
+        return Allocator;
+    }
+
+private:
+
+    //Braced always uses braces like Add, otherwise parentheses are preferred like in Emplace
+    template<bool Braced = false, typename... Ts>
+    static void ConstructItem(ItemT* Memory, Ts&&... Args)
+    {
+        if constexpr(!Braced && std::is_constructible_v<ItemT, Ts&&...>)
+        {
+            new(Memory) ItemT(std::forward<Ts>(Args)...);
+        }
+        else //aggregates and braced initialization
+        {
+            new(Memory) ItemT{std::forward<Ts>(Args)...};
+        }
+    }
+
+    //thread safe, marks the claimed slots [FirstSlot, EndSlot) of a concurrent add as left empty by their block
+    void DropConcurrentSlots(int64_t FirstSlot, int64_t EndSlot)
+    {
+        for(int64_t Slot = FirstSlot - ItemCount; Slot < EndSlot - ItemCount; ++Slot)
+        {
+            std::atomic_ref(ConcurrentAddDropped[Slot / 64]).fetch_or(uint64_t(1) << (Slot % 64), std::memory_order_relaxed);
+        }
+    }
+
+    bool IsConcurrentSlotDropped(int64_t Slot) const
+    {
+        return (ConcurrentAddDropped[Slot / 64] >> (Slot % 64)) & 1;
+    }
+
+    /**
+     * moves the last filled items of the Claimed slots into the ones left empty, so the filled items are dense again, and binds the keys
+     * of the empty slots to the end of the claimed range where EndConcurrentAdd finds them. returns the number of empty slots
+     */
+    int64_t CompactConcurrentSlots(int64_t Claimed)
+    {
+        int64_t DroppedCount = 0;
+
+        for(int64_t Word = 0; Word < (Claimed + 63) / 64; ++Word)
+        {
+            DroppedCount += std::popcount(ConcurrentAddDropped[Word]);
+        }
+
+        [[likely]] if(DroppedCount == 0)
+        {
+            return 0;
+        }
+
+        int64_t Last = Claimed;
+
+        for(int64_t Slot = 0; Slot < Claimed - DroppedCount; ++Slot)
+        {
+            if(!IsConcurrentSlotDropped(Slot))
+            {
+                continue;
+            }
+
+            do
+            {
+                Last -= 1;
+            } while(IsConcurrentSlotDropped(Last));
+
+            const int64_t Hole = ItemCount + Slot;
+            const int64_t Moved = ItemCount + Last;
+            const uint64_t EmptyKey = KeyOffsets[Hole];
+            const uint64_t MovedKey = KeyOffsets[Moved];
+
+            new(Items + Hole) ItemT(std::move(Items[Moved]));
+            Items[Moved].ItemT::~ItemT();
+
+            Keys[MovedKey].Index = Hole;
+            BindSlot(Hole, MovedKey);
+
+            Keys[EmptyKey].Index = Moved;
+            BindSlot(Moved, EmptyKey);
+        }
+
+        return DroppedCount;
+    }
+
+    //expects ReserveForAdd to have made room for the item, see ConstructItem for Braced
+    template<bool Braced = false, typename... Ts>
+    KeyHandle EmplaceUnchecked(Ts&&... Args)
+    {
+        //construct before touching the freelist so a throwing constructor leaves the map unchanged
+        ConstructItem<Braced>(Items + ItemCount, std::forward<Ts>(Args)...);
+
+        uint64_t KeyIndex = BindFreeKey(ItemCount);
+        BindSlot(ItemCount, KeyIndex);
+
+        ItemCount += 1;
+
+        RecordAdded(KeyIndex);
+        Stats.OnItemCount(ItemCount);
+
+        AdvanceMigration(1);
+
+        return MakeHandle(KeyIndex);
+    }
+
+    //key has to be a pointer to a key in Keys, no copies
+    void Remove(ItemKey* Key) __attribute_nonnull__((2))
+    {
+        EraseItem(Key);
+        ReleaseKey(std::distance(Keys, Key));
+
+        ShrinkItemsIfSparse();
+    }
+
+    void ListChangedKey(uint64_t KeyIndex)
+    {
+        const uint64_t Word = KeyIndex / 64;
+        const uint64_t Bit = uint64_t(1) << (KeyIndex % 64);
+
+        [[unlikely]] if(Word >= Changes.ListedBits.size())
+        {
+            Changes.ListedBits.resize((KeyCount + 63) / 64);
+            Changes.AddedBits.resize((KeyCount + 63) / 64);
+        }
+
+        if(!(Changes.ListedBits[Word] & Bit))
+        {
+            Changes.ListedBits[Word] |= Bit;
+            Changes.ChangedKeys.push_back(KeyIndex);
+        }
+    }
+
+    void RecordAdded(uint64_t KeyIndex)
+    {
+        if constexpr(Traits::TrackChanges)
+        {
+            ListChangedKey(KeyIndex);
+            Changes.AddedBits[KeyIndex / 64] |= uint64_t(1) << (KeyIndex % 64);
+        }
+    }
+
+    //has to be called before the ID of the key is bumped
+    void RecordRemoved(uint64_t KeyIndex)
+    {
+        if constexpr(Traits::TrackChanges)
+        {
+            const uint64_t Word = KeyIndex / 64;
+            const uint64_t Bit = uint64_t(1) << (KeyIndex % 64);
+
+            if(Word < Changes.AddedBits.size() && (Changes.AddedBits[Word] & Bit)) //nobody has seen it yet
+            {
+                Changes.AddedBits[Word] &= ~Bit;
+            }
+            else
+            {
+                Changes.RemovedHandles.push_back(MakeHandle(KeyIndex));
+            }
+        }
+    }
+
+    //invalidates the key and swap-removes its item, the key is left for the caller to put on the freelist
+    void EraseItem(ItemKey* Key) __attribute_nonnull__((2))
+    {
+        WriteScope Scope(*this);
+
+        [[unlikely]] if(PendingRemovalCount != 0)
+        {
+            TrimTombstones();
+        }
+
+        RecordRemoved(std::distance(Keys, Key));
+        BumpKeyID(std::distance(Keys, Key)); //invalidate handles to this key.
+        ItemCount -= 1;
+
+        if constexpr(Traits::RemovalPolicy == SlotMapRemovalPolicy::Shift)
+        {
+            ShiftItemsDown(Key->Index);
+            return;
+        }
+
+        ItemKey& LastKey = Keys[*KeyOffsetPointer(ItemCount)];
+
+        [[unlikely]] if(Key->Index == LastKey.Index) //prevent self assignment
+        {
+            ItemPointer(Key->Index)->ItemT::~ItemT();
+        }
+        else //move last item and its key offset to the removed item
+        {
+            MoveSlot(Key->Index, ItemCount);
+            *ItemPointer(Key->Index) = std::move(*ItemPointer(ItemCount));
+            ItemPointer(ItemCount)->ItemT::~ItemT();
+        }
+
+        LastKey.Index = Key->Index;
+
+        DropMigratedTail();
+        AdvanceMigration(1);
+    }
+
+    //destroys the item at Hole and moves every item after it one index down, ItemCount has to be decremented already
+    void ShiftItemsDown(uint64_t Hole)
+    {
+        MigrateTail(Hole); //the shift touches every item after Hole anyway
+
+        const int64_t ShiftCount = ItemCount - Hole;
+
+        Items[Hole].ItemT::~ItemT();
+
+        if constexpr(std::is_trivially_copyable_v<ItemT>)
+        {
+            std::memmove(Items + Hole, Items + Hole + 1, ShiftCount * sizeof(ItemT));
+        }
+        else
+        {
+            for(int64_t Index = Hole; Index < ItemCount; ++Index)
+            {
+                new(Items + Index) ItemT(std::move(Items[Index + 1]));
+                Items[Index + 1].ItemT::~ItemT();
+            }
+        }
+
+        std::memmove(KeyOffsets + Hole, KeyOffsets + Hole + 1, ShiftCount * sizeof(KeyOffsetT));
+
+        if constexpr(Traits::CacheGenerations)
+        {
+            std::memmove(ItemGenerations + Hole, ItemGenerations + Hole + 1, ShiftCount * sizeof(GenerationT));
+        }
+
+        for(int64_t Index = Hole; Index < ItemCount; ++Index)
+        {
+            [[likely]] if(KeyOffsets[Index] != TombstoneOffset)
+            {
+                Keys[KeyOffsets[Index]].Index = Index;
+            }
+        }
+
+        if(PendingRemovalCount != 0 && FirstTombstone > static_cast<int64_t>(Hole))
+        {
+            FirstTombstone -= 1;
+        }
+    }
+
+    //destroys marked items at the end so the last item is alive and can be swapped into a hole
+    void TrimTombstones()
+    {
+        while(PendingRemovalCount != 0 && *KeyOffsetPointer(ItemCount - 1) == TombstoneOffset)
+        {
+            ItemCount -= 1;
+            PendingRemovalCount -= 1;
+            ItemPointer(ItemCount)->ItemT::~ItemT();
+
+            DropMigratedTail();
+        }
+    }
+
+    void ShrinkItemsIfSparse()
+    {
+        if(IsMigrating()) //the next resize waits until the current one is done
+        {
+            return;
+        }
+
+        const int64_t NewCapacity = SparseCapacity(AllocatedItemCount, ItemCount);
+
+        [[unlikely]] if(NewCapacity != AllocatedItemCount)
+        {
+            ResizeItems(NewCapacity);
+        }
+    }
+
+    //grows keys and items once so that Count items can be added without further checks
+    //returns false if the growth policy or Traits::IndexBits do not allow for Count more items
+    bool ReserveForAdd(int64_t Count)
+    {
+        const int64_t RequiredItems = ItemCount + Count;
+        const int64_t NewKeyCount = KeyCountForAdd(RequiredItems);
+
+        [[unlikely]] if(NewKeyCount != KeyCount)
+        {
+            if(NewKeyCount < 0)
+            {
+                return false;
+            }
+
+            ResizeKeys(NewKeyCount);
+        }
+
+        [[unlikely]] if(RequiredItems > AllocatedItemCount)
+        {
+            if(Traits::GrowthPolicy == SlotMapGrowthPolicy::Fixed)
+            {
+                return false;
+            }
+
+            int64_t NewCapacity = GrowCapacity(AllocatedItemCount, RequiredItems);
+
+            if constexpr(IncrementalMigration)
+            {
+                //the room has to exist right away. at most Pace items are left per free slot, so this moves at most Pace * Count items
+                NewCapacity = std::max(NewCapacity, Migration.QueuedCapacity);
+                Migration.QueuedCapacity = 0;
+
+                CompleteMigration();
+            }
+
+            ResizeItems(NewCapacity);
+        }
+
+        return true;
+    }
+
+    void ResizeItems(int64_t Count)
+    {
+        SLOTMAP_ASSERT(Count >= ItemCount, "shrinking allocation below alive items is not allowed");
+
+        if constexpr(IncrementalMigration)
+        {
+            [[unlikely]] if(Migration.Capacity != 0) //a resize never completes a migration at once, it waits for it
+            {
+                Migration.QueuedCapacity = Count;
+                return;
+            }
+
+            Migration.QueuedCapacity = 0; //replaced by this resize
+        }
+
+        [[unlikely]] if(Count == AllocatedItemCount) //no resize event for a resize that does nothing
+        {
+            return;
+        }
+
+        if constexpr(std::is_trivially_copyable_v<ItemT>) //only trivially copyable items can be mapped
+        {
+            [[unlikely]] if(MappedMemory)
+            {
+                DetachMappedFile();
+            }
+        }
+
+        if constexpr(IncrementalMigration)
+        {
+            [[likely]] if(ItemCount != 0) //without items there is nothing to spread out
+            {
+                StartMigration(Count);
+                return;
+            }
+        }
+
+        [[unlikely]] if(Count == 0)
+        {
+            ReleaseArray(KeyOffsets, AllocatedItemCount);
+            ReleaseArray<ItemT, ItemAlignment, ItemPaddingBytes>(Items, AllocatedItemCount);
+
+            if constexpr(Traits::CacheGenerations)
+            {
+                DeallocateArray(ItemGenerations, AllocatedItemCount); //readers never see cached IDs
+                ItemGenerations = nullptr;
+            }
+
+            KeyOffsets = nullptr;
+            Items = nullptr;
+
+            const int64_t OldCapacity = AllocatedItemCount;
+            AllocatedItemCount = 0;
+
+            Stats.OnResize(SlotMapResizeEvent{SlotMapResizeTarget::Items, OldCapacity, 0, 0});
+
+            PublishSnapshot();
+        }
+        else if(Count != AllocatedItemCount)
+        {
+            const int64_t OldCapacity = AllocatedItemCount;
+
+            KeyOffsets = ReallocateArray(KeyOffsets, AllocatedItemCount, Count, ItemCount);
+
+            if constexpr(Traits::CacheGenerations)
+            {
+                ItemGenerations = ReallocateArray(ItemGenerations, AllocatedItemCount, Count, ItemCount);
+            }
+
+            if constexpr(std::is_trivially_copyable_v<ItemT>)
+            {
+                Items = ReallocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Items, AllocatedItemCount, Count, ItemCount);
+            }
+            else
+            {
+                ItemT* NewItems = AllocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Count);
+
+                for(int64_t Index = 0; Index < ItemCount; ++Index)
+                {
+                    new(NewItems + Index) ItemT(std::move(Items[Index]));
+                    Items[Index].ItemT::~ItemT();
+                }
+
+                if(Items != nullptr)
+                {
+                    DeallocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Items, AllocatedItemCount);
+                }
+
+                Items = NewItems;
+            }
+
+            AllocatedItemCount = Count;
+
+            const int64_t BytesMoved = ItemCount * static_cast<int64_t>(sizeof(ItemT) + sizeof(KeyOffsetT) + (Traits::CacheGenerations ? sizeof(GenerationT) : 0));
+            Stats.OnResize(SlotMapResizeEvent{SlotMapResizeTarget::Items, OldCapacity, Count, BytesMoved});
+
+            PublishSnapshot();
+        }
+    }
+
+    void ResizeKeys(int64_t Count)
+    {
+        SLOTMAP_ASSERT(Count >= KeyCount, "shrinking key allocation is not allowed");
+
+        if constexpr(std::is_trivially_copyable_v<ItemT>) //only trivially copyable items can be mapped
+        {
+            [[unlikely]] if(MappedMemory)
+            {
+                DetachMappedFile();
+            }
+        }
+
+        if(Count != KeyCount)
+        {
+            int64_t OldKeyCount = KeyCount;
+            KeyCount = Count;
+
+            Keys = ReallocateArray(Keys, OldKeyCount, KeyCount, OldKeyCount);
+
+            if constexpr(Traits::SplitGenerations)
+            {
+                Generations = ReallocateArray(Generations, OldKeyCount, KeyCount, OldKeyCount);
+            }
+
+            LinkNewKeys(OldKeyCount);
+
+            Stats.OnResize(SlotMapResizeEvent{SlotMapResizeTarget::Keys, OldKeyCount, KeyCount, OldKeyCount * static_cast<int64_t>(sizeof(ItemKey) + SerializedGenerationSize)});
+
+            PublishSnapshot();
+        }
+    }
+
+    template<typename PointerT>
+    int64_t ResolveInto(std::span<const KeyHandle> Handles, std::span<PointerT> OutItems) const
+    {
+        SLOTMAP_ASSERT(std::ssize(OutItems) >= std::ssize(Handles), "not enough space for the output items");
+
+        int64_t ValidCount = 0;
+        uint64_t ItemIndices[64];
+
+        for(int64_t First = 0; First < std::ssize(Handles); First += 64)
+        {
+            int64_t Count = std::min<int64_t>(64, std::ssize(Handles) - First);
+            uint64_t Mask = ValidateChunk(Handles.data() + First, Count, ItemIndices);
+
+            for(int64_t Lane = 0; Lane < Count; ++Lane)
+            {
+                OutItems[First + Lane] = (Mask >> Lane) & 1 ? ItemPointer(ItemIndices[Lane]) : nullptr;
+            }
+
+            ValidCount += std::popcount(Mask);
+        }
+
+        return ValidCount;
+    }
+
+    //validates up to 64 handles, returns one bit per handle and writes the item index of every valid handle to OutItemIndices.
+    //the chunk is reported to the stats policy once, whichever path validated its lanes
+    uint64_t ValidateChunk(const KeyHandle* Handles, int64_t Count, uint64_t* OutItemIndices) const
+    {
+        SLOTMAP_ASSERT(Count <= 64);
+
+        uint64_t Mask = 0;
+        int64_t Lane = 0;
+
+        if constexpr(HasPackedKeys)
+        {
+            const auto* HandleBits = reinterpret_cast<const long long*>(Handles);
+            const auto* KeyBits = reinterpret_cast<const long long*>(Keys);
+
+#if defined(__AVX512F__)
+            const __m512i IndexMaskV = _mm512_set1_epi64(IndexBitMask);
+            const __m512i IdMaskV = _mm512_set1_epi64(IdBitMask);
+            const __m512i KeyCountV = _mm512_set1_epi64(KeyCount);
+
+            for(; Lane + 8 <= Count; Lane += 8)
+            {
+                __m512i HandleV = _mm512_loadu_si512(HandleBits + Lane);
+                __m512i IndexV = _mm512_and_si512(HandleV, IndexMaskV);
+
+                __mmask8 InRange = _mm512_cmplt_epu64_mask(IndexV, KeyCountV);
+                __m512i KeyV = _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), InRange, IndexV, KeyBits, 8);
+
+                //the id has to match and not be 0, out of range lanes gathered 0 so they can never match a non null id
+                __mmask8 IdMatch = _mm512_mask_cmpeq_epi64_mask(_mm512_test_epi64_mask(HandleV, IdMaskV), _mm512_and_si512(HandleV, IdMaskV), _mm512_and_si512(KeyV, IdMaskV));
+
+                _mm512_storeu_si512(OutItemIndices + Lane, _mm512_and_si512(KeyV, IndexMaskV));
+                Mask |= static_cast<uint64_t>(IdMatch) << Lane;
+            }
+#elif defined(__AVX2__)
+            const __m256i IndexMaskV = _mm256_set1_epi64x(IndexBitMask);
+            const __m256i IdMaskV = _mm256_set1_epi64x(IdBitMask);
+            const __m256i KeyCountV = _mm256_set1_epi64x(KeyCount);
+
+            for(; Lane + 4 <= Count; Lane += 4)
+            {
+                __m256i HandleV = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(HandleBits + Lane));
+                __m256i IndexV = _mm256_and_si256(HandleV, IndexMaskV);
+
+                __m256i InRange = _mm256_cmpgt_epi64(KeyCountV, IndexV); //signed compare is fine since IndexBits < 64
+                __m256i KeyV = _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), KeyBits, IndexV, InRange, 8);
+
+                __m256i HandleId = _mm256_and_si256(HandleV, IdMaskV);
+                __m256i IdMatch = _mm256_cmpeq_epi64(HandleId, _mm256_and_si256(KeyV, IdMaskV));
+                __m256i IdNull = _mm256_cmpeq_epi64(HandleId, _mm256_setzero_si256());
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(OutItemIndices + Lane), _mm256_and_si256(KeyV, IndexMaskV));
+                Mask |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_andnot_si256(IdNull, IdMatch)))) << Lane;
+            }
+#else
+            (void)HandleBits;
+            (void)KeyBits;
+#endif
+        }
+
+        for(; Lane < Count; ++Lane) //scalar fallback and remainder
+        {
+            if(IsLiveHandle(Handles[Lane]))
+            {
+                OutItemIndices[Lane] = Keys[Handles[Lane].Index].Index;
+                Mask |= uint64_t{1} << Lane;
+            }
+        }
+
+        Stats.OnHandleChecks(Count, Count - std::popcount(Mask));
+
+        return Mask;
+    }
+
+    //marks a section in which concurrent readers have to retry, does nothing without Traits::ConcurrentReads
+    struct WriteScope
+    {
+        const SlotMap& Map;
+
+        explicit WriteScope(const SlotMap& InMap)
+            : Map(InMap)
+        {
+            if constexpr(Traits::ConcurrentReads)
+            {
+                Map.Concurrent.WriteSequence.store(Map.Concurrent.WriteSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+        }
+
+        ~WriteScope()
+        {
+            if constexpr(Traits::ConcurrentReads)
+            {
+                Map.Concurrent.WriteSequence.store(Map.Concurrent.WriteSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+        }
+    };
+
+    //keeps memory retired during the scope alive
+    struct ReadScope
+    {
+        const SlotMap& Map;
+        uint64_t Epoch;
+
+        explicit ReadScope(const SlotMap& InMap)
+            : Map(InMap)
+        {
+            while(true)
+            {
+                Epoch = Map.Concurrent.Epoch.load(std::memory_order_seq_cst);
+                Map.Concurrent.ActiveReaders[Epoch & 1].fetch_add(1, std::memory_order_seq_cst);
+
+                [[likely]] if(Map.Concurrent.Epoch.load(std::memory_order_seq_cst) == Epoch)
+                {
+                    break;
+                }
+
+                Map.Concurrent.ActiveReaders[Epoch & 1].fetch_sub(1, std::memory_order_release); //the writer advanced since, announce in the new epoch
+            }
+        }
+
+        ~ReadScope()
+        {
+            Map.Concurrent.ActiveReaders[Epoch & 1].fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    static void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    bool ConcurrentAccess(KeyHandle Handle, ItemT* OutItem) const
+    {
+        ReadScope Scope(*this);
+
+        while(true)
+        {
+            uint64_t Sequence = Concurrent.WriteSequence.load(std::memory_order_acquire);
+
+            [[likely]] if((Sequence & 1) == 0)
+            {
+                bool Valid = false;
+                alignas(ItemT) std::byte ItemCopy[sizeof(ItemT)];
+
+                //everything read here may be torn by the writer, which is caught by the sequence check and retried
+                if(const ReaderSnapshot* Snapshot = Concurrent.Snapshot.load(std::memory_order_acquire))
+                {
+                    if(Handle.ID != 0 && Handle.Index < static_cast<uint64_t>(Snapshot->KeyCount))
+                    {
+                        ItemKey Key = Snapshot->Keys[Handle.Index];
+
+                        uint64_t KeyID;
+
+                        if constexpr(Traits::SplitGenerations)
+                        {
+                            KeyID = Snapshot->Generations[Handle.Index];
+                        }
+                        else
+                        {
+                            KeyID = Key.ID;
+                        }
+
+                        if(KeyID == Handle.ID && Key.Index < static_cast<uint64_t>(Snapshot->ItemCapacity))
+                        {
+                            if(OutItem != nullptr)
+                            {
+                                std::memcpy(ItemCopy, Snapshot->Items + Key.Index, sizeof(ItemT));
+                            }
+
+                            Valid = true;
+                        }
+                    }
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if(Concurrent.WriteSequence.load(std::memory_order_relaxed) == Sequence)
+                {
+                    if(Valid && OutItem != nullptr)
+                    {
+                        std::memcpy(static_cast<void*>(OutItem), ItemCopy, sizeof(ItemT));
+                    }
+
+                    return Valid;
+                }
+            }
+
+            CpuRelax();
+        }
+    }
+
+    //publishes the current arrays to concurrent readers, called after every resize
+    void PublishSnapshot()
+    {
+        if constexpr(Traits::ConcurrentReads)
+        {
+            auto* Snapshot = AllocateArray<ReaderSnapshot>(1);
+            *Snapshot = ReaderSnapshot{.Keys = Keys, .Generations = Generations, .KeyCount = KeyCount, .Items = Items, .ItemCapacity = AllocatedItemCount};
+
+            if(const ReaderSnapshot* OldSnapshot = Concurrent.Snapshot.exchange(Snapshot, std::memory_order_release))
+            {
+                Retire(const_cast<ReaderSnapshot*>(OldSnapshot), sizeof(ReaderSnapshot), alignof(ReaderSnapshot));
+            }
+
+            Reclaim();
+        }
+    }
+
+    //defers freeing memory until no concurrent reader can access it
+    void Retire(void* Memory, size_t Size, size_t Alignment)
+    {
+        if(Concurrent.RetiredCount == Concurrent.RetiredCapacity)
+        {
+            int64_t NewCapacity = std::max<int64_t>(16, Concurrent.RetiredCapacity * 2);
+            auto* NewRetired = AllocateArray<RetiredMemory>(NewCapacity);
+
+            if(Concurrent.Retired)
+            {
+                std::memcpy(NewRetired, Concurrent.Retired, Concurrent.RetiredCount * sizeof(RetiredMemory));
+                DeallocateArray(Concurrent.Retired, Concurrent.RetiredCapacity);
+            }
+
+            Concurrent.Retired = NewRetired;
+            Concurrent.RetiredCapacity = NewCapacity;
+        }
+
+        Concurrent.Retired[Concurrent.RetiredCount++] = RetiredMemory{.Memory = Memory, .Size = Size, .Alignment = Alignment, .Epoch = Concurrent.Epoch.load(std::memory_order_relaxed)};
+    }
+
+    //frees all memory retired in or before Epoch, the retired list is ordered by epoch
+    void FreeRetired(uint64_t Epoch)
+    {
+        int64_t FreedCount = 0;
+
+        while(FreedCount < Concurrent.RetiredCount && Concurrent.Retired[FreedCount].Epoch <= Epoch)
+        {
+            const RetiredMemory& Retired = Concurrent.Retired[FreedCount];
+            Allocator.Deallocate(Retired.Memory, Retired.Size, Retired.Alignment);
+            FreedCount += 1;
+        }
+
+        if(FreedCount != 0)
+        {
+            Concurrent.RetiredCount -= FreedCount;
+            std::memmove(Concurrent.Retired, Concurrent.Retired + FreedCount, Concurrent.RetiredCount * sizeof(RetiredMemory));
+        }
+    }
+
+    //frees memory the map replaced, unless concurrent readers may still use it
+    template<typename T, size_t Alignment = alignof(T), size_t Padding = 0>
+    void ReleaseArray(T* Memory, int64_t Count)
+    {
+        if constexpr(Traits::ConcurrentReads)
+        {
+            Retire(Memory, Count * sizeof(T) + Padding, Alignment);
+        }
+        else
+        {
+            DeallocateArray<T, Alignment, Padding>(Memory, Count);
+        }
+    }
+
+    SlotMap(const SlotMap& Other, CloneTag)
+        : SlotMap(Other.Allocator)
+    {
+        SLOTMAP_ASSERT(Other.ConcurrentAddLimit == 0, "can't clone during a concurrent add");
+
+        if(Other.Keys)
+        {
+            Keys = AllocateArray<ItemKey>(Other.KeyCount);
+            std::memcpy(Keys, Other.Keys, Other.KeyCount * sizeof(ItemKey));
+
+            if constexpr(Traits::SplitGenerations)
+            {
+                Generations = AllocateArray<GenerationT>(Other.KeyCount);
+                std::memcpy(Generations, Other.Generations, Other.KeyCount * sizeof(GenerationT));
+            }
+            KeyCount = Other.KeyCount;
+        }
+
+        if(Other.Items)
+        {
+            KeyOffsets = AllocateArray<KeyOffsetT>(Other.AllocatedItemCount);
+            Items = AllocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Other.AllocatedItemCount);
+            AllocatedItemCount = Other.AllocatedItemCount;
+
+            if constexpr(Traits::CacheGenerations)
+            {
+                ItemGenerations = AllocateArray<GenerationT>(Other.AllocatedItemCount);
+                std::memcpy(ItemGenerations, Other.ItemGenerations, Other.ItemCount * sizeof(GenerationT));
+            }
+
+            //the clone gets every item in one array even if Other is migrating, marked items are still alive until Flush so they are copied as well
+            Other.ForEachItemRun([this](int64_t First, int64_t Last, const ItemT* RunItems, const KeyOffsetT* RunKeyOffsets)
+            {
+                std::memcpy(KeyOffsets + First, RunKeyOffsets, (Last - First) * sizeof(KeyOffsetT));
+
+                if constexpr(std::is_trivially_copyable_v<ItemT>)
+                {
+                    std::memcpy(Items + First, RunItems, (Last - First) * sizeof(ItemT));
+                    ItemCount = Last;
+                }
+                else
+                {
+                    for(; ItemCount < Last; ++ItemCount) //counting up keeps the destructor correct if a copy throws
+                    {
+                        new(Items + ItemCount) ItemT(RunItems[ItemCount - First]);
+                    }
+                }
+            });
+        }
 
-    using KeyOffsetT = std::conditional_t<Traits::IndexBits <= 32, uint32_t, uint64_t>;
+        FreelistHead = Other.FreelistHead;
+        FreelistTail = Other.FreelistTail;
+        PendingRemovalCount = Other.PendingRemovalCount;
+        FirstTombstone = Other.FirstTombstone;
+        RetiredKeyCount = Other.RetiredKeyCount;
 
-    static constexpr uint64_t IndexMax = UINT64_MAX >> (64 - Traits::IndexBits);
-    static constexpr uint64_t IdMax = UINT64_MAX >> (64 - Traits::IdBits); //in the worst case: we will have to remove the same item (IdMax - 1) * Traits::MinFreeKeys times to get an id reset
+        PublishSnapshot();
+    }
 
-    struct ItemKey
+    static constexpr uint64_t AlignSerializedOffset(uint64_t Offset, uint64_t Alignment)
     {
-        //when free, specifies an offset to an item, otherwise to the next free key
-        uint64_t Index : Traits::IndexBits = 0;
-
-        //id of the item pointed to by Index, 0 is an invalid ID in order to properly represent a null handle
-        uint64_t ID : Traits::IdBits = 0;
-    };
+        return (Offset + Alignment - 1) & ~(Alignment - 1);
+    }
 
-    struct KeyHandle
+    //fills in the offsets of every array for the counts in Header
+    static void LayoutSerializedHeader(SerializedHeader& Header)
     {
-        //offset to an ItemKey
-        uint64_t Index : Traits::IndexBits = 0;
+        Header.KeysOffset = AlignSerializedOffset(sizeof(SerializedHeader), 64);
+        Header.GenerationsOffset = AlignSerializedOffset(Header.KeysOffset + Header.KeyCount * sizeof(ItemKey), 64);
+        Header.KeyOffsetsOffset = AlignSerializedOffset(Header.GenerationsOffset + Header.KeyCount * SerializedGenerationSize, 64);
+        Header.ItemsOffset = AlignSerializedOffset(Header.KeyOffsetsOffset + Header.ItemCount * sizeof(KeyOffsetT), ItemAlignment);
+        Header.TotalSize = Header.ItemsOffset + Header.ItemCount * sizeof(ItemT) + ItemPaddingBytes;
+    }
 
-        //id of the item in ItemKey
-        uint64_t ID : Traits::IdBits = 0;
-    };
+    SerializedHeader MakeSerializedHeader() const
+    {
+        SerializedHeader Header{
+            .Magic = SerializedMagic,
+            .Version = SerializedVersion,
+            .ItemSize = sizeof(ItemT),
+            .ItemAlignment = ItemAlignment,
+            .IndexBits = Traits::IndexBits,
+            .IdBits = Traits::IdBits,
+            .KeyOffsetSize = sizeof(KeyOffsetT),
+            .KeySize = sizeof(ItemKey),
+            .GenerationSize = SerializedGenerationSize,
+            .KeyCount = KeyCount,
+            .ItemCount = ItemCount,
+            .FreelistHead = FreelistHead,
+            .FreelistTail = FreelistTail,
+            .PendingRemovalCount = PendingRemovalCount,
+            .FirstTombstone = FirstTombstone,
+            .RetiredKeyCount = RetiredKeyCount
+        };
+
+        LayoutSerializedHeader(Header);
+
+        return Header;
+    }
 
-    static constexpr KeyHandle NullHandle{.Index = 0, .ID = 0};
+    //checks the header matches this map type and describes a consistent state, offsets are checked against the layout Serialize writes
+    static bool IsValidSerializedHeader(const SerializedHeader& Header)
+    {
+        [[unlikely]] if(Header.Magic != SerializedMagic || Header.Version != SerializedVersion || Header.ItemSize != sizeof(ItemT)
+            || Header.ItemAlignment != ItemAlignment || Header.IndexBits != Traits::IndexBits || Header.IdBits != Traits::IdBits || Header.KeyOffsetSize != sizeof(KeyOffsetT) || Header.KeySize != sizeof(ItemKey) || Header.GenerationSize != SerializedGenerationSize)
+        {
+            return false;
+        }
 
-private: //member variables
+        [[unlikely]] if(Header.KeyCount < 0 || Header.KeyCount > KeyCountMax || Header.ItemCount < 0 || Header.ItemCount > Header.KeyCount
+            || Header.PendingRemovalCount < 0 || Header.PendingRemovalCount > Header.ItemCount
+            || Header.RetiredKeyCount < 0 || Header.RetiredKeyCount > Header.KeyCount - Header.ItemCount + Header.PendingRemovalCount)
+        {
+            return false;
+        }
 
-    ItemKey* Keys;
-    KeyOffsetT* KeyOffsets; //offset values "owned" by the corresponding item at the same index that is used the get the key of an item
-    ItemT* Items;
+        [[unlikely]] if(Header.KeyCount != 0 && (Header.FreelistHead >= static_cast<uint64_t>(Header.KeyCount) || Header.FreelistTail >= static_cast<uint64_t>(Header.KeyCount)))
+        {
+            return false;
+        }
 
-    int64_t KeyCount; //number of keys including free keys, is the same as the number of allocated keys
+        SerializedHeader Expected = Header;
+        LayoutSerializedHeader(Expected);
 
-    uint64_t FreelistHead; //first free key offset FIFO implementation
-    uint64_t FreelistTail; //last free key offset
+        return Header.KeysOffset == Expected.KeysOffset && Header.GenerationsOffset == Expected.GenerationsOffset && Header.KeyOffsetsOffset == Expected.KeyOffsetsOffset
+            && Header.ItemsOffset == Expected.ItemsOffset && Header.TotalSize == Expected.TotalSize;
+    }
 
-    int64_t ItemCount;
-    int64_t AllocatedItemCount;
+    /**
+     * checks that the arrays of a snapshot describe a consistent map: every live key offset is in range and its key points back at it,
+     * the tombstones match the pending removals and the freelist runs from head to tail trough exactly the keys that are neither bound nor retired
+     */
+    static bool IsValidSerializedStorage(const SerializedHeader& Header, const ItemKey* NewKeys, const GenerationT* NewGenerations, const KeyOffsetT* NewKeyOffsets)
+    {
+        auto IdOf = [NewKeys, NewGenerations](uint64_t KeyIndex) -> uint64_t
+        {
+            if constexpr(Traits::SplitGenerations)
+            {
+                return NewGenerations[KeyIndex];
+            }
+            else
+            {
+                (void)NewGenerations;
+                return NewKeys[KeyIndex].ID;
+            }
+        };
 
-public:
+        std::vector<uint64_t> ClaimedKeys((Header.KeyCount + 63) / 64);
 
-    SlotMap(const SlotMap&) = delete;
-    SlotMap(SlotMap&&) = delete;
+        //marks the key as used by an item or the freelist, false if it already was
+        auto Claim = [&ClaimedKeys](uint64_t KeyIndex)
+        {
+            const uint64_t Bit = uint64_t(1) << (KeyIndex % 64);
+            const bool Unclaimed = !(ClaimedKeys[KeyIndex / 64] & Bit);
+            ClaimedKeys[KeyIndex / 64] |= Bit;
+            return Unclaimed;
+        };
 
-    SlotMap()
-        : Keys(nullptr)
-        , KeyOffsets(nullptr)
-        , Items(nullptr)
-        , KeyCount(0)
-        , FreelistHead(0)
-        , FreelistTail(0)
-        , ItemCount(0)
-        , AllocatedItemCount(0)
-    {
-    }
+        int64_t Tombstones = 0;
+        int64_t FirstFoundTombstone = Header.ItemCount;
 
-    ~SlotMap()
-    {
-        if constexpr(!std::is_trivially_destructible_v<ItemT>)
+        for(int64_t Index = 0; Index < Header.ItemCount; ++Index)
         {
-            while(ItemCount != 0)
+            const uint64_t KeyIndex = NewKeyOffsets[Index];
+
+            [[unlikely]] if(KeyIndex == TombstoneOffset)
             {
-                --ItemCount;
-                Items[ItemCount].ItemT::~ItemT();
+                FirstFoundTombstone = std::min(FirstFoundTombstone, Index);
+                Tombstones += 1;
+                continue;
+            }
+
+            [[unlikely]] if(KeyIndex >= static_cast<uint64_t>(Header.KeyCount) || NewKeys[KeyIndex].Index != static_cast<uint64_t>(Index)
+                || IdOf(KeyIndex) == 0 || IdOf(KeyIndex) >= IdMax || !Claim(KeyIndex))
+            {
+                return false;
             }
         }
 
-        if(Keys)
+        //Flush compacts from FirstTombstone on, so it may be lower than the first marked item but never higher
+        [[unlikely]] if(Tombstones != Header.PendingRemovalCount || (Tombstones != 0 && (Header.FirstTombstone < 0 || Header.FirstTombstone > FirstFoundTombstone)))
+        {
+            return false;
+        }
+
+        const int64_t FreeKeys = Header.KeyCount - (Header.ItemCount - Header.PendingRemovalCount) - Header.RetiredKeyCount;
+        uint64_t KeyIndex = Header.FreelistHead;
+
+        //the link of the tail is never read, it may point anywhere
+        for(int64_t Linked = 1; Linked <= FreeKeys; ++Linked)
         {
-            free(Keys);
+            [[unlikely]] if(!Claim(KeyIndex) || IdOf(KeyIndex) == 0 || IdOf(KeyIndex) >= IdMax || (Linked == FreeKeys) != (KeyIndex == Header.FreelistTail))
+            {
+                return false;
+            }
+
+            KeyIndex = NewKeys[KeyIndex].Index;
+
+            [[unlikely]] if(Linked != FreeKeys && KeyIndex >= static_cast<uint64_t>(Header.KeyCount))
+            {
+                return false;
+            }
         }
 
-        if(Items)
+        //the remaining keys are retired and have to stay out of the freelist when it is rebuilt
+        for(int64_t Index = 0; Index < Header.KeyCount; ++Index)
         {
-            free(KeyOffsets);
-            free(Items);
+            [[unlikely]] if(!(ClaimedKeys[Index / 64] & (uint64_t(1) << (Index % 64))) && IdOf(Index) != IdMax)
+            {
+                return false;
+            }
         }
+
+        return true;
     }
 
-    bool IsValidHandle(KeyHandle Handle) const
+    //frees the current arrays and takes over the given ones with the state described by Header
+    void ReplaceStorage(const SerializedHeader& Header, ItemKey* NewKeys, GenerationT* NewGenerations, KeyOffsetT* NewKeyOffsets, ItemT* NewItems, int64_t ItemCapacity)
     {
-        return Handle.ID != 0 && Handle.Index < KeyCount && Handle.ID == Keys[Handle.Index].ID;
+        SLOTMAP_ASSERT(ConcurrentAddLimit == 0, "can't replace the contents during a concurrent add");
+
+        {
+            WriteScope Scope(*this);
+
+            FreeMigratedArrays(); //items are trivially copyable here, so the old ones need no destruction
+            Migration = {}; //a resize queued for the old contents does not apply to the loaded ones
+
+            if(ItemGenerations)
+            {
+                DeallocateArray(ItemGenerations, AllocatedItemCount);
+                ItemGenerations = nullptr;
+            }
+
+            if(MappedMemory)
+            {
+                UnmapFile();
+            }
+            else
+            {
+                if(Keys)
+                {
+                    ReleaseArray(Keys, KeyCount);
+                }
+
+                if(Generations)
+                {
+                    ReleaseArray(Generations, KeyCount);
+                }
+
+                if(Items)
+                {
+                    ReleaseArray(KeyOffsets, AllocatedItemCount);
+                    ReleaseArray<ItemT, ItemAlignment, ItemPaddingBytes>(Items, AllocatedItemCount);
+                }
+            }
+
+            Keys = NewKeys;
+            Generations = NewGenerations;
+            KeyOffsets = NewKeyOffsets;
+            Items = NewItems;
+
+            KeyCount = Header.KeyCount;
+            FreelistHead = Header.FreelistHead;
+            FreelistTail = Header.FreelistTail;
+            ItemCount = Header.ItemCount;
+            AllocatedItemCount = ItemCapacity;
+            PendingRemovalCount = Header.PendingRemovalCount;
+            FirstTombstone = Header.FirstTombstone;
+            RetiredKeyCount = Header.RetiredKeyCount;
+
+            Changes = {}; //recorded changes refer to the replaced contents
+
+            //cached IDs are not serialized, they are rebuilt from the keys
+            if constexpr(Traits::CacheGenerations)
+            {
+                if(ItemCapacity != 0)
+                {
+                    ItemGenerations = AllocateArray<GenerationT>(ItemCapacity);
+                }
+
+                for(int64_t Slot = 0; Slot < ItemCount; ++Slot)
+                {
+                    [[likely]] if(KeyOffsets[Slot] != TombstoneOffset)
+                    {
+                        BindSlot(Slot, KeyOffsets[Slot]);
+                    }
+                }
+            }
+        }
+
+        PublishSnapshot();
     }
 
-    template<typename... Ts>
-    KeyHandle Add(Ts... Args)
+    //copies the mapped arrays into allocated memory so they can be resized and freed like any other
+    void DetachMappedFile()
     {
-        SLOTMAP_ASSERT(ItemCount < IndexMax, "reached max index. consider increasing IndexBits");
+        ItemKey* NewKeys = KeyCount != 0 ? AllocateArray<ItemKey>(KeyCount) : nullptr;
+        GenerationT* NewGenerations = Generations ? AllocateArray<GenerationT>(KeyCount) : nullptr;
+        KeyOffsetT* NewKeyOffsets = AllocatedItemCount != 0 ? AllocateArray<KeyOffsetT>(AllocatedItemCount) : nullptr;
+        ItemT* NewItems = AllocatedItemCount != 0 ? AllocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(AllocatedItemCount) : nullptr;
 
-        [[unlikely]] if(ItemCount >= (KeyCount - Traits::MinFreeKeys)) //item count will always be <= key count
+        if(KeyCount != 0)
         {
-            ResizeKeys((KeyCount + Traits::AllocationSize) & ~(Traits::AllocationSize - 1)); //round to next multiple of Traits::AllocationSize
+            std::memcpy(NewKeys, Keys, KeyCount * sizeof(ItemKey));
         }
 
-        [[unlikely]] if(ItemCount == AllocatedItemCount)
+        if(Generations)
         {
-            ResizeItems((ItemCount + Traits::AllocationSize) & ~(Traits::AllocationSize - 1)); //round to next multiple of Traits::AllocationSize
+            std::memcpy(NewGenerations, Generations, KeyCount * sizeof(GenerationT));
         }
 
-        uint64_t KeyIndex = FreelistHead; //pick the free head key
-        ItemKey& Key = Keys[KeyIndex];
+        if(ItemCount != 0)
+        {
+            std::memcpy(NewKeyOffsets, KeyOffsets, ItemCount * sizeof(KeyOffsetT));
+            std::memcpy(NewItems, Items, ItemCount * sizeof(ItemT));
+        }
 
-        FreelistHead = Key.Index;
+        UnmapFile();
 
-        Key.Index = ItemCount;
-        ItemCount += 1;
+        Keys = NewKeys;
+        Generations = NewGenerations;
+        KeyOffsets = NewKeyOffsets;
+        Items = NewItems;
+    }
+
+    void UnmapFile()
+    {
+#if SLOTMAP_HAS_MMAP
+        munmap(MappedMemory, MappedSize);
+#endif
+        MappedMemory = nullptr;
+        MappedSize = 0;
+    }
 
-        KeyOffsets[Key.Index] = KeyIndex;
-        new(Items + Key.Index) ItemT{std::forward<Ts>(Args)...};
+    //Padding is extra bytes allocated past the last element
+    template<typename T, size_t Alignment = alignof(T), size_t Padding = 0>
+    T* AllocateArray(int64_t Count)
+    {
+        auto* Memory = static_cast<T*>(Allocator.Allocate(Count * sizeof(T) + Padding, Alignment));
+        SLOTMAP_ASSERT(Memory != nullptr, "out of memory");
+        SLOTMAP_ASSERT(reinterpret_cast<uintptr_t>(Memory) % Alignment == 0, "allocator did not respect the alignment");
+        return Memory;
+    }
 
-        return KeyHandle{.Index = KeyIndex, .ID = Key.ID};
+    template<typename T, size_t Alignment = alignof(T), size_t Padding = 0>
+    void DeallocateArray(T* Memory, int64_t Count)
+    {
+        Allocator.Deallocate(Memory, Count * sizeof(T) + Padding, Alignment);
     }
 
-    //returns false if the handle was invalid, true otherwise
-    bool Remove(KeyHandle Handle)
+    //resizes an array of trivially copyable elements, keeping the first CopyCount elements
+    template<typename T, size_t Alignment = alignof(T), size_t Padding = 0>
+    T* ReallocateArray(T* Memory, int64_t OldCount, int64_t NewCount, int64_t CopyCount)
     {
-        ItemKey* Key = GetKey(Handle);
-        if(Key == nullptr)
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        if(Memory == nullptr)
         {
-            return false;
+            return AllocateArray<T, Alignment, Padding>(NewCount);
         }
 
-        Remove(Key);
-        return true;
-    }
+        if constexpr(SlotMapReallocatingAllocator<AllocatorT> && !Traits::ConcurrentReads) //concurrent readers may still access the old memory
+        {
+            if(void* Resized = Allocator.Reallocate(Memory, OldCount * sizeof(T) + Padding, NewCount * sizeof(T) + Padding, Alignment))
+            {
+                SLOTMAP_ASSERT(reinterpret_cast<uintptr_t>(Resized) % Alignment == 0, "allocator did not respect the alignment");
+                return static_cast<T*>(Resized);
+            }
+        }
 
-    void Remove(uint64_t Index)
-    {
-        Remove(GetKey(Index));
+        T* NewMemory = AllocateArray<T, Alignment, Padding>(NewCount);
+        std::memcpy(NewMemory, Memory, CopyCount * sizeof(T));
+        ReleaseArray<T, Alignment, Padding>(Memory, OldCount);
+
+        return NewMemory;
     }
 
-    void Remove(ItemT* Item)
+    using KeyTable::KeyID;
+    using KeyTable::SetKeyID;
+    using KeyTable::IsLiveHandle;
+    using KeyTable::MakeHandle;
+    using KeyTable::BindFreeKey;
+    using KeyTable::ReleaseKey;
+    using KeyTable::RelinkFreelist;
+    using KeyTable::LinkNewKeys;
+    using KeyTable::KeyCountForAdd;
+    using KeyTable::RoundToAllocationSize;
+    using KeyTable::GrowCapacity;
+    using KeyTable::SparseCapacity;
+
+    //the ID change is reported to the stats policy, returns the new ID
+    uint64_t BumpKeyID(uint64_t KeyIndex)
     {
-        Remove(GetKey(Item));
+        const uint64_t ID = KeyTable::BumpKeyID(KeyIndex);
+        Stats.OnIdIssued(ID);
+        return ID;
     }
 
-    void Clear()
+    //handle to the item at Slot, only streams KeyOffsets and the cached IDs with Traits::CacheGenerations
+    KeyHandle SlotHandle(int64_t Slot) const
     {
-        while(ItemCount != 0)
+        if constexpr(Traits::CacheGenerations)
+        {
+            return KeyHandle{.Index = static_cast<KeyStorageT>(KeyOffsets[Slot]), .ID = static_cast<KeyStorageT>(ItemGenerations[Slot])};
+        }
+        else
         {
-            Remove(ItemCount - 1);
+            return MakeHandle(*KeyOffsetPointer(Slot));
         }
     }
 
-    KeyHandle GetHandle(int64_t Index) const
+    //every write of a live key offset goes trough these so the cached IDs stay next to their offsets
+    void BindSlot(int64_t Slot, uint64_t KeyIndex)
     {
-        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
-
-        uint64_t KeyIndex = KeyOffsets[Index];
-        uint64_t KeyID = Keys[KeyIndex].ID;
+        *KeyOffsetPointer(Slot) = static_cast<KeyOffsetT>(KeyIndex);
 
-        return KeyHandle{.Index = KeyIndex, .ID = KeyID};
+        if constexpr(Traits::CacheGenerations)
+        {
+            ItemGenerations[Slot] = static_cast<GenerationT>(KeyID(KeyIndex));
+        }
     }
 
-    KeyHandle GetHandle(ItemT* Item) const
+    void MoveSlot(int64_t To, int64_t From)
     {
-        return GetHandle(std::distance(Items, Item));
+        *KeyOffsetPointer(To) = *KeyOffsetPointer(From);
+
+        if constexpr(Traits::CacheGenerations)
+        {
+            ItemGenerations[To] = ItemGenerations[From];
+        }
     }
 
-    template<typename Self>
-    decltype(auto) operator[](this Self&& self, KeyHandle Handle)
+    //the item at a dense index, which stays in the old arrays until a migration reached it
+    ItemT* ItemPointer(int64_t Index) const
     {
-        if(auto* Key = self.GetKey(Handle))
+        if constexpr(IncrementalMigration)
         {
-            return self.Items + Key->Index;
+            [[unlikely]] if(Index >= Migration.Migrated && Index < Migration.End)
+            {
+                return Migration.Items + Index;
+            }
         }
 
-        return (decltype(self.Items))nullptr;
+        return Items + Index;
     }
 
-    template<typename Self>
-    decltype(auto) operator[](this Self&& self, int64_t Index)
+    KeyOffsetT* KeyOffsetPointer(int64_t Index) const
     {
-        SLOTMAP_ASSERT((Index >= 0) & (Index < self.ItemCount));
-        return self.Items[Index];
+        if constexpr(IncrementalMigration)
+        {
+            [[unlikely]] if(Index >= Migration.Migrated && Index < Migration.End)
+            {
+                return Migration.KeyOffsets + Index;
+            }
+        }
+
+        return KeyOffsets + Index;
     }
 
-    template<typename Self>
-    decltype(auto) begin(this Self&& self)
+    //inverse of ItemPointer
+    int64_t IndexOfItem(const ItemT* Item) const
     {
-        return self.Items;
+        if constexpr(IncrementalMigration)
+        {
+            std::less<const ItemT*> Less; //the pointer may belong to either array
+            [[unlikely]] if(Migration.Capacity != 0 && !Less(Item, Migration.Items) && Less(Item, Migration.Items + Migration.Capacity))
+            {
+                return std::distance<const ItemT*>(Migration.Items, Item);
+            }
+        }
+
+        return std::distance<const ItemT*>(Items, Item);
     }
 
-    template<typename Self>
-    decltype(auto) end(this Self&& self)
+    /**
+     * keeps the current arrays as the migration source and switches to new ones of at least Count items, ItemCount has to be > 0.
+     * the new arrays get at least ItemCount / Traits::MigrationBudget free slots, so moving the budget per add is done before they are full
+     */
+    void StartMigration(int64_t Count)
     {
-        return self.Items + self.ItemCount;
+        SLOTMAP_ASSERT(Migration.Capacity == 0, "only one old allocation is kept around");
+
+        const bool Shrinking = Count < AllocatedItemCount;
+        Count = std::max(Count, RoundToAllocationSize(ItemCount + (ItemCount + Traits::MigrationBudget - 1) / Traits::MigrationBudget));
+
+        if(Shrinking && Count >= AllocatedItemCount) //the slack would eat the savings
+        {
+            return;
+        }
+
+        KeyOffsetT* NewKeyOffsets = AllocateArray<KeyOffsetT>(Count);
+        ItemT* NewItems = AllocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Count);
+
+        const int64_t OldCapacity = AllocatedItemCount;
+
+        const int64_t FreeSlots = Count - ItemCount;
+
+        Migration = MigrationState{.Items = Items, .KeyOffsets = KeyOffsets, .Capacity = AllocatedItemCount, .Migrated = 0, .End = ItemCount,
+            .Pace = (ItemCount + FreeSlots - 1) / FreeSlots};
+
+        KeyOffsets = NewKeyOffsets;
+        Items = NewItems;
+        AllocatedItemCount = Count;
+
+        //reported up front, the bytes are moved over the following operations
+        const int64_t BytesMoved = ItemCount * static_cast<int64_t>(sizeof(ItemT) + sizeof(KeyOffsetT));
+        Stats.OnResize(SlotMapResizeEvent{SlotMapResizeTarget::Items, OldCapacity, Count, BytesMoved});
     }
 
-    int64_t Size() const
+    //moves up to Count items from the front of the old arrays
+    void MigrateItems(int64_t Count)
     {
-        return ItemCount;
+        const int64_t First = Migration.Migrated;
+        const int64_t Last = First + std::clamp<int64_t>(Migration.End - First, 0, Count);
+
+        MoveMigratedRange(First, Last);
+        Migration.Migrated = Last;
+
+        FreeMigratedArraysIfDone();
     }
 
-    int64_t SizeBytes() const
+    //moves every item at or past First that is still in the old arrays, so that range can be worked on in Items alone
+    void MigrateTail(int64_t First)
     {
-        return ItemCount * sizeof(ItemT);
-    }
+        if constexpr(IncrementalMigration)
+        {
+            [[unlikely]] if(Migration.Capacity != 0)
+            {
+                const int64_t NewEnd = std::clamp(First, Migration.Migrated, std::max(Migration.End, Migration.Migrated));
 
-private:
+                MoveMigratedRange(NewEnd, Migration.End);
+                Migration.End = NewEnd;
 
-    //key has to be a pointer to a key in Keys, no copies
-    void Remove(ItemKey* Key) __attribute_nonnull__((2))
+                FreeMigratedArraysIfDone();
+            }
+        }
+    }
+
+    //moves [First, Last) of the old arrays to the same indices of the new ones
+    void MoveMigratedRange(int64_t First, int64_t Last)
     {
-        SLOTMAP_ASSERT(Key->ID < IdMax, "reached max id. consider increasing IdBits and/or MinFreeKeys");
+        if(Last <= First)
+        {
+            return;
+        }
 
-        Key->ID += 1; //invalidate handles to this key.
-        ItemCount -= 1;
+        const size_t MoveCount = static_cast<size_t>(Last - First);
 
-        ItemKey& LastKey = Keys[KeyOffsets[ItemCount]];
+        std::memcpy(KeyOffsets + First, Migration.KeyOffsets + First, MoveCount * sizeof(KeyOffsetT));
 
-        [[unlikely]] if(Key->Index == LastKey.Index) //prevent self assignment
+        if constexpr(std::is_trivially_copyable_v<ItemT>)
         {
-            Items[Key->Index].ItemT::~ItemT();
+            std::memcpy(Items + First, Migration.Items + First, MoveCount * sizeof(ItemT));
         }
-        else //move last item and its key offset to the removed item
+        else
         {
-            KeyOffsets[Key->Index] = KeyOffsets[ItemCount];
-            Items[Key->Index] = std::move(Items[ItemCount]);
+            for(int64_t Index = First; Index < Last; ++Index)
+            {
+                new(Items + Index) ItemT(std::move(Migration.Items[Index]));
+                Migration.Items[Index].ItemT::~ItemT();
+            }
         }
+    }
 
-        LastKey.Index = Key->Index;
-
-        ItemKey& TailKey = Keys[FreelistTail]; //set old tail to point to the new tail (this key)
-        TailKey.Index = std::distance(Keys, Key);
-        FreelistTail = TailKey.Index;
-
-        [[unlikely]] if(AllocatedItemCount >= (ItemCount + Traits::AllocationSize * 2)) //test if its worth to shrink items
+    //frees the old arrays once nothing is left in them. a queued resize is not started here since callers expect every item in Items afterwards
+    void FreeMigratedArraysIfDone()
+    {
+        if(Migration.Migrated >= Migration.End)
         {
-            ResizeItems((ItemCount + Traits::AllocationSize - 1) & ~(Traits::AllocationSize - 1)); //resize items to first multiple of Traits::AllocationSize
+            FreeMigratedArrays();
         }
     }
 
-    void ResizeItems(int64_t Count)
+    //starts a resize that waited for the previous migration, only called at the end of operations that don't hold on to Items
+    void StartQueuedResize()
     {
-        SLOTMAP_ASSERT(Count >= ItemCount, "shrinking allocation below alive items is not allowed");
-
-        if(Count != AllocatedItemCount)
+        if constexpr(IncrementalMigration)
         {
-            AllocatedItemCount = Count;
-
-            KeyOffsets = static_cast<KeyOffsetT*>(realloc(KeyOffsets, AllocatedItemCount * sizeof(KeyOffsetT)));
-
-            if constexpr(std::is_trivially_copyable_v<ItemT>)
+            [[unlikely]] if(Migration.Capacity == 0 && Migration.QueuedCapacity != 0)
             {
-                Items = static_cast<ItemT*>(realloc(Items, AllocatedItemCount * sizeof(ItemT)));
+                ResizeItems(std::max(Migration.QueuedCapacity, ItemCount));
             }
-            else
-            {
-                auto* NewItems = static_cast<ItemT*>(malloc(AllocatedItemCount * sizeof(ItemT)));
-
-                for(int64_t Index = 0; Index < ItemCount; ++Index)
-                {
-                    new(NewItems + Index) ItemT{std::move(Items[Index])};
-                }
+        }
+    }
 
-                if(Items != nullptr)
-                {
-                    free(Items);
-                }
+    /**
+     * steps the migration by Traits::MigrationBudget items for each of Operations adds or removes,
+     * or more if the free slots of the new arrays would otherwise run out before the old ones are empty
+     */
+    void AdvanceMigration(int64_t Operations)
+    {
+        if constexpr(IncrementalMigration)
+        {
+            [[unlikely]] if(Migration.Capacity != 0)
+            {
+                const int64_t Remaining = Migration.End - Migration.Migrated;
+                const int64_t Allowed = Migration.Pace * (AllocatedItemCount - ItemCount);
 
-                Items = NewItems;
+                MigrateItems(std::max(Operations * Traits::MigrationBudget, Remaining - Allowed));
             }
+
+            StartQueuedResize();
         }
     }
 
-    void ResizeKeys(int64_t Count)
+    //items at and past ItemCount were destroyed, so the migration does not have to move them
+    void DropMigratedTail()
     {
-        SLOTMAP_ASSERT(Count >= KeyCount, "shrinking key allocation is not allowed");
+        if constexpr(IncrementalMigration)
+        {
+            Migration.End = std::min(Migration.End, ItemCount);
+        }
+    }
 
-        if(Count != KeyCount)
+    //releases the old arrays of a migration without moving, the items left in them have to be destroyed already. a queued resize is kept
+    void FreeMigratedArrays()
+    {
+        if constexpr(IncrementalMigration)
         {
-            int64_t OldKeyCount = KeyCount;
-            KeyCount = Count;
+            [[unlikely]] if(Migration.Capacity != 0)
+            {
+                DeallocateArray(Migration.KeyOffsets, Migration.Capacity);
+                DeallocateArray<ItemT, ItemAlignment, ItemPaddingBytes>(Migration.Items, Migration.Capacity);
+
+                Migration = MigrationState{.QueuedCapacity = Migration.QueuedCapacity};
+            }
+        }
+    }
 
-            Keys = static_cast<ItemKey*>(realloc(Keys, KeyCount * sizeof(ItemKey)));
+    //calls Function(First, Last, RunItems, RunKeyOffsets) in index order for the ranges of dense indices that lie in one array, the pointers refer to index First
+    template<typename FunctionT>
+    void ForEachItemRun(FunctionT&& Function) const
+    {
+        int64_t OldFirst = ItemCount;
+        int64_t OldLast = ItemCount;
 
-            for(int64_t idx = OldKeyCount; idx < KeyCount; ++idx) //initialize new keys
+        if constexpr(IncrementalMigration)
+        {
+            [[unlikely]] if(Migration.Capacity != 0)
             {
-                Keys[idx].Index = idx + 1; //points one off the end but that's ok because we update it before we get to that point
-                Keys[idx].ID = 1;
+                OldFirst = std::min(Migration.Migrated, ItemCount);
+                OldLast = std::clamp(Migration.End, OldFirst, ItemCount);
             }
+        }
+
+        if(OldFirst > 0)
+        {
+            Function(int64_t(0), OldFirst, static_cast<const ItemT*>(Items), static_cast<const KeyOffsetT*>(KeyOffsets));
+        }
 
-            if(FreelistTail != FreelistHead)
+        if constexpr(IncrementalMigration)
+        {
+            if(OldLast > OldFirst)
             {
-                Keys[FreelistTail].Index = OldKeyCount; //set old tail to point to the first new key
+                Function(OldFirst, OldLast, static_cast<const ItemT*>(Migration.Items + OldFirst), static_cast<const KeyOffsetT*>(Migration.KeyOffsets + OldFirst));
             }
+        }
 
-            FreelistTail = KeyCount - 1; //new tail is the last added key
+        if(ItemCount > OldLast)
+        {
+            Function(OldLast, ItemCount, static_cast<const ItemT*>(Items + OldLast), static_cast<const KeyOffsetT*>(KeyOffsets + OldLast));
         }
     }
 
@@ -344,13 +3565,14 @@ private:
     decltype(auto) GetKey(this Self&& self, int64_t ItemIndex)
     {
         SLOTMAP_ASSERT((ItemIndex >= 0) & (ItemIndex < self.ItemCount));
-        return self.Keys + self.KeyOffsets[ItemIndex];
+        SLOTMAP_ASSERT(*self.KeyOffsetPointer(ItemIndex) != TombstoneOffset, "the item was marked removed");
+        return self.Keys + *self.KeyOffsetPointer(ItemIndex);
     }
 
     template<typename Self>
     decltype(auto) GetKey(this Self&& self, ItemT* Item)
     {
-        return self.GetKey(std::distance(self.Items, Item));
+        return self.GetKey(self.IndexOfItem(Item));
     }
 };
 
@@ -0,0 +1,71 @@
+#ifndef SLOTMAPDISPATCH_HPP
+#define SLOTMAPDISPATCH_HPP
+
+#include "slotmap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * @description the default dispatch of SlotMap::ParallelForEach, kept out of slotmap.hpp so maps that never run in parallel do not pull in <thread>.
+ * runs Task(Index) for every Index in [0, TaskCount) on ThreadCount threads, the calling thread takes part.
+ * the threads are started on every call and joined before it returns, which costs tens of microseconds per call. loops that run every frame
+ * should pass the parallel-for of a thread pool instead.
+ * if a task throws, no further tasks are started and the first exception is rethrown on the calling thread once every thread is joined
+ */
+struct SlotMapThreadDispatch
+{
+    int64_t ThreadCount = 0; //0 uses one thread per hardware thread
+
+    template<typename TaskT>
+    void operator()(int64_t TaskCount, TaskT&& Task) const
+    {
+        const int64_t UsedThreads = std::min<int64_t>(TaskCount, ThreadCount > 0 ? ThreadCount : std::max(1u, std::thread::hardware_concurrency()));
+        std::atomic<int64_t> NextTask{0};
+        std::atomic<bool> Failed{false};
+        std::exception_ptr Error; //only written by the thread that set Failed, only read after the join
+
+        auto Worker = [&NextTask, &Failed, &Error, &Task, TaskCount]()
+        {
+            try
+            {
+                for(int64_t Index = NextTask.fetch_add(1, std::memory_order_relaxed); Index < TaskCount; Index = NextTask.fetch_add(1, std::memory_order_relaxed))
+                {
+                    Task(Index);
+                }
+            }
+            catch(...)
+            {
+                NextTask.store(TaskCount, std::memory_order_relaxed);
+
+                if(!Failed.exchange(true))
+                {
+                    Error = std::current_exception();
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> Threads;
+            Threads.reserve(UsedThreads > 0 ? UsedThreads - 1 : 0);
+
+            for(int64_t ThreadIndex = 1; ThreadIndex < UsedThreads; ++ThreadIndex)
+            {
+                Threads.emplace_back(Worker);
+            }
+
+            Worker();
+        } //joins the threads
+
+        [[unlikely]] if(Error)
+        {
+            std::rethrow_exception(Error);
+        }
+    }
+};
+
+#endif //SLOTMAPDISPATCH_HPP
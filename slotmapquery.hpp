@@ -0,0 +1,159 @@
+#ifndef SLOTMAPQUERY_HPP
+#define SLOTMAPQUERY_HPP
+
+#include "slotmap.hpp"
+
+#include <array>
+#include <tuple>
+
+/**
+ * @description A SlotMapQuery joins slot maps whose items were added under the same handles, for example one map per component of an entity
+ * whose adds and removes are mirrored. The maps have to share the handle type, so maps of different item types need the same TagT.
+ * The map with the fewest items drives the join: its dense items and their handles are streamed in chunks of ChunkSize, every other map
+ * resolves the whole chunk at once trough Resolve and the resolved items are prefetched while Function runs on the previous chunk.
+ * The key and item misses of a chunk overlap instead of every lookup waiting for its own, which pays off once the maps outgrow the caches
+ * and Resolve can use AVX2 or AVX-512 gathers. Small maps that fit the caches are joined about as fast with plain lookups.
+ * Function may modify the items but must not add or remove items of any joined map while the query runs.
+ */
+template<typename... MapTs>
+class SlotMapQuery
+{
+public:
+    static_assert(sizeof...(MapTs) > 0);
+
+    using KeyHandle = typename std::remove_const_t<std::tuple_element_t<0, std::tuple<MapTs...>>>::KeyHandle;
+
+    static_assert((std::is_same_v<typename std::remove_const_t<MapTs>::KeyHandle, KeyHandle> && ...), "joined maps have to share the handle type, give them the same TagT");
+
+    static constexpr int64_t ChunkSize = 64; //handles resolved per batch, matches the chunks SlotMap::Resolve validates at once
+
+private: //member variables
+
+    //item type of a map as seen by Function, const for const maps
+    template<typename MapT>
+    using ItemOf = std::remove_reference_t<decltype((*std::declval<MapT&>().Entries().begin()).Item)>;
+
+    using ChunkItems = std::tuple<std::array<ItemOf<MapTs>*, ChunkSize>...>;
+
+    std::tuple<MapTs*...> Maps;
+
+public:
+
+    explicit SlotMapQuery(MapTs&... InMaps)
+        : Maps(&InMaps...)
+    {
+    }
+
+    //number of items of the map that drives the join, an upper bound of the matches
+    int64_t DriverSize() const
+    {
+        return std::apply([](const auto*... Map) { return std::min({Map->Size()...}); }, Maps);
+    }
+
+    //calls Function(Items&...) or Function(Items&..., Handle) with the items in the order of the maps, for every handle valid in all of them
+    template<typename FunctionT>
+    void ForEach(FunctionT&& Function) const
+    {
+        JoinFromSmallest(Function, std::index_sequence_for<MapTs...>());
+    }
+
+private:
+
+    template<size_t... MapIndices>
+    size_t SmallestMap(std::index_sequence<MapIndices...>) const
+    {
+        const int64_t Sizes[] = {std::get<MapIndices>(Maps)->Size()...};
+        return std::distance(Sizes, std::min_element(Sizes, Sizes + sizeof...(MapTs)));
+    }
+
+    //instantiates the join for every possible driver and runs the one of the smallest map
+    template<typename FunctionT, size_t... MapIndices>
+    void JoinFromSmallest(FunctionT& Function, std::index_sequence<MapIndices...> Sequence) const
+    {
+        const size_t Driver = SmallestMap(Sequence);
+        ((MapIndices == Driver && (Join<MapIndices>(Function), true)) || ...);
+    }
+
+    //one batch of driver handles with the items resolved for them in every map
+    struct Chunk
+    {
+        KeyHandle Handles[ChunkSize];
+        ChunkItems Items;
+        int64_t Count = 0;
+    };
+
+    /**
+     * software pipelined: while Function runs on one chunk the items of the next are already resolved and prefetched,
+     * so the prefetches have a whole chunk of work to arrive instead of being issued right before their use
+     */
+    template<size_t Driver, typename FunctionT>
+    void Join(FunctionT& Function) const
+    {
+        Chunk Chunks[2];
+        Chunk* Filling = &Chunks[0];
+        Chunk* Ready = &Chunks[1];
+
+        //Entries skips items marked removed, so every handle of a chunk is valid in the driver
+        for(auto [Handle, Item] : std::get<Driver>(Maps)->Entries())
+        {
+            Filling->Handles[Filling->Count] = Handle;
+            std::get<Driver>(Filling->Items)[Filling->Count] = &Item;
+
+            [[unlikely]] if(++Filling->Count == ChunkSize)
+            {
+                ResolveChunk<Driver>(*Filling, std::index_sequence_for<MapTs...>());
+                RunChunk(Function, *Ready, std::index_sequence_for<MapTs...>());
+
+                std::swap(Filling, Ready);
+                Filling->Count = 0;
+            }
+        }
+
+        ResolveChunk<Driver>(*Filling, std::index_sequence_for<MapTs...>());
+        RunChunk(Function, *Ready, std::index_sequence_for<MapTs...>());
+        RunChunk(Function, *Filling, std::index_sequence_for<MapTs...>());
+    }
+
+    //looks up the keys of the whole chunk per map and prefetches the items they point to
+    template<size_t Driver, size_t... MapIndices>
+    void ResolveChunk(Chunk& Target, std::index_sequence<MapIndices...>) const
+    {
+        (ResolveMap<MapIndices, Driver>(Target.Handles, std::get<MapIndices>(Target.Items).data(), Target.Count), ...);
+    }
+
+    template<typename FunctionT, size_t... MapIndices>
+    static void RunChunk(FunctionT& Function, const Chunk& Source, std::index_sequence<MapIndices...>)
+    {
+        for(int64_t Lane = 0; Lane < Source.Count; ++Lane)
+        {
+            if(((std::get<MapIndices>(Source.Items)[Lane] != nullptr) && ...))
+            {
+                if constexpr(std::is_invocable_v<FunctionT&, ItemOf<MapTs>&..., KeyHandle>)
+                {
+                    Function(*std::get<MapIndices>(Source.Items)[Lane]..., Source.Handles[Lane]);
+                }
+                else
+                {
+                    Function(*std::get<MapIndices>(Source.Items)[Lane]...);
+                }
+            }
+        }
+    }
+
+    //the driver already provided its items, they are read in order and need no prefetch
+    template<size_t MapIndex, size_t Driver, typename ItemT>
+    void ResolveMap(const KeyHandle* Handles, ItemT** OutItems, int64_t Count) const
+    {
+        if constexpr(MapIndex != Driver)
+        {
+            std::get<MapIndex>(Maps)->Resolve(std::span<const KeyHandle>(Handles, Count), std::span<ItemT*>(OutItems, Count));
+
+            for(int64_t Lane = 0; Lane < Count; ++Lane)
+            {
+                __builtin_prefetch(OutItems[Lane]); //prefetching nullptr does not fault
+            }
+        }
+    }
+};
+
+#endif //SLOTMAPQUERY_HPP
@@ -0,0 +1,549 @@
+#ifndef SOASLOTMAP_HPP
+#define SOASLOTMAP_HPP
+
+#include "slotmap.hpp"
+
+#include <tuple>
+
+template<typename ColumnsT, typename Traits = SlotMapDefaultTraits, typename TagT = ColumnsT>
+class SoASlotMap;
+
+/**
+ * @description A SoASlotMap is a SlotMap whose items are split into columns, SoASlotMap<std::tuple<Position, Velocity>>
+ * stores every Position in one dense array and every Velocity in another.
+ * Keys, handles and the freelist work exactly like in SlotMap, removing an item swap-removes the same index in every column so
+ * all columns stay in the same order and GetColumn can be used to stream only the data a system needs.
+ */
+template<typename... ColumnTs, typename Traits, typename TagT>
+class SoASlotMap<std::tuple<ColumnTs...>, Traits, TagT> : public SlotMapKeyTable<Traits, TagT>
+{
+    using KeyTable = SlotMapKeyTable<Traits, TagT>;
+
+public:
+    static_assert(sizeof...(ColumnTs) > 0);
+
+    using typename KeyTable::KeyOffsetT;
+    using typename KeyTable::KeyStorageT;
+    using typename KeyTable::AllocatorT;
+    using typename KeyTable::ItemKey;
+    using typename KeyTable::KeyHandle;
+    using typename KeyTable::GenerationT;
+
+    template<size_t Column>
+    using ColumnT = std::tuple_element_t<Column, std::tuple<ColumnTs...>>;
+
+    static constexpr size_t ColumnCount = sizeof...(ColumnTs);
+
+    using KeyTable::IndexMax;
+    using KeyTable::IdMax;
+    using KeyTable::KeyCountMax;
+    using KeyTable::NullHandle;
+
+private: //member variables
+
+    using KeyTable::Keys;
+    using KeyTable::Generations;
+    using KeyTable::KeyCount;
+    using KeyTable::FreelistHead;
+    using KeyTable::FreelistTail;
+    using KeyTable::RetiredKeyCount;
+
+    KeyOffsetT* KeyOffsets;
+    std::tuple<ColumnTs*...> Columns; //one dense array per column, all of them AllocatedItemCount long
+
+    int64_t ItemCount;
+    int64_t AllocatedItemCount;
+
+    [[no_unique_address]] AllocatorT Allocator;
+
+public:
+
+    SoASlotMap(const SoASlotMap&) = delete;
+    SoASlotMap(SoASlotMap&&) = delete;
+
+    SoASlotMap()
+        : SoASlotMap(AllocatorT{})
+    {
+    }
+
+    explicit SoASlotMap(const AllocatorT& InAllocator)
+        : KeyOffsets(nullptr)
+        , Columns()
+        , ItemCount(0)
+        , AllocatedItemCount(0)
+        , Allocator(InAllocator)
+    {
+    }
+
+    ~SoASlotMap()
+    {
+        ForEachColumn([this]<typename T>(T*& Data)
+        {
+            if constexpr(!std::is_trivially_destructible_v<T>)
+            {
+                for(int64_t Index = 0; Index < ItemCount; ++Index)
+                {
+                    Data[Index].T::~T();
+                }
+            }
+        });
+
+        if(Keys)
+        {
+            DeallocateArray(Keys, KeyCount, alignof(ItemKey), 0);
+        }
+
+        if(Generations)
+        {
+            DeallocateArray(Generations, KeyCount, alignof(GenerationT), 0);
+        }
+
+        if(KeyOffsets)
+        {
+            DeallocateArray(KeyOffsets, AllocatedItemCount, alignof(KeyOffsetT), 0);
+            ForEachColumn([this]<typename T>(T*& Data)
+            {
+                DeallocateArray(Data, AllocatedItemCount, ColumnAlignment<T>, Traits::ItemPaddingBytes);
+            });
+        }
+    }
+
+    bool IsValidHandle(KeyHandle Handle) const
+    {
+        return IsLiveHandle(Handle);
+    }
+
+    //constructs every column in place from its corresponding value
+    template<typename... Ts> requires(sizeof...(Ts) == ColumnCount)
+    KeyHandle Emplace(Ts&&... Values)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            SLOTMAP_ASSERT(false, "reached max capacity. consider increasing IndexBits or reserving more items");
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Values)...);
+    }
+
+    //same as Emplace but returns NullHandle instead of asserting when IndexMax or a fixed capacity is reached
+    template<typename... Ts> requires(sizeof...(Ts) == ColumnCount)
+    KeyHandle TryEmplace(Ts&&... Values)
+    {
+        [[unlikely]] if(!ReserveForAdd(1))
+        {
+            return NullHandle;
+        }
+
+        return EmplaceUnchecked(std::forward<Ts>(Values)...);
+    }
+
+    template<typename... Ts> requires(sizeof...(Ts) == ColumnCount)
+    KeyHandle Add(Ts&&... Values)
+    {
+        return Emplace(std::forward<Ts>(Values)...);
+    }
+
+    //returns false if the handle was invalid, true otherwise
+    bool Remove(KeyHandle Handle)
+    {
+        if(!IsValidHandle(Handle))
+        {
+            return false;
+        }
+
+        Remove(Keys + Handle.Index);
+        return true;
+    }
+
+    void Remove(uint64_t Index)
+    {
+        SLOTMAP_ASSERT(Index < static_cast<uint64_t>(ItemCount));
+        Remove(Keys + KeyOffsets[Index]);
+    }
+
+    /**
+     * removes every item in one pass like SlotMap::Clear: invalidates the handles of all items, destroys the columns that need it and
+     * relinks the freelist trough all keys in index order. KeepCapacity keeps the item allocation for refilling
+     */
+    void Clear(bool KeepCapacity = false)
+    {
+        for(int64_t Index = 0; Index < ItemCount; ++Index)
+        {
+            RetiredKeyCount += BumpKeyID(KeyOffsets[Index]) == IdMax;
+        }
+
+        ForEachColumn([this]<typename T>(T*& Data)
+        {
+            if constexpr(!std::is_trivially_destructible_v<T>)
+            {
+                for(int64_t Index = 0; Index < ItemCount; ++Index)
+                {
+                    Data[Index].T::~T();
+                }
+            }
+        });
+
+        ItemCount = 0;
+
+        RelinkFreelist();
+
+        if(!KeepCapacity)
+        {
+            ShrinkItemsIfSparse();
+        }
+    }
+
+    KeyHandle GetHandle(int64_t Index) const
+    {
+        SLOTMAP_ASSERT((Index >= 0) & (Index < ItemCount));
+
+        return MakeHandle(KeyOffsets[Index]);
+    }
+
+    //returns the dense index shared by all columns of the item, -1 if the handle is invalid
+    int64_t IndexOf(KeyHandle Handle) const
+    {
+        if(IsValidHandle(Handle))
+        {
+            return Keys[Handle.Index].Index;
+        }
+
+        return -1;
+    }
+
+    //returns a pointer to the item's element in Column, nullptr if the handle is invalid
+    template<size_t Column, typename Self>
+    decltype(auto) Get(this Self&& self, KeyHandle Handle)
+    {
+        auto* Data = std::get<Column>(self.Columns);
+
+        if(self.IsValidHandle(Handle))
+        {
+            return self.template ConstColumn<Self>(Data + self.Keys[Handle.Index].Index);
+        }
+
+        return self.template ConstColumn<Self>(decltype(Data){nullptr});
+    }
+
+    //dense span over every item's element in Column, in the same order for all columns
+    template<size_t Column, typename Self>
+    decltype(auto) GetColumn(this Self&& self)
+    {
+        return std::span(self.template ConstColumn<Self>(std::get<Column>(self.Columns)), self.ItemCount);
+    }
+
+    //grows the allocations to fit at least ItemCapacity items and KeyCapacity keys, never shrinks
+    void Reserve(int64_t ItemCapacity, int64_t KeyCapacity)
+    {
+        SLOTMAP_ASSERT(KeyCapacity <= KeyCountMax, "reached max index. consider increasing IndexBits");
+
+        if(KeyCapacity > KeyCount)
+        {
+            ResizeKeys(KeyCapacity);
+        }
+
+        if(ItemCapacity > AllocatedItemCount)
+        {
+            ResizeItems(ItemCapacity);
+        }
+    }
+
+    //reserves enough keys for ItemCapacity items
+    void Reserve(int64_t ItemCapacity)
+    {
+        Reserve(ItemCapacity, std::min(RequiredKeyCount(ItemCapacity), KeyCountMax));
+    }
+
+    //releases unused item memory, keys are kept since their IDs have to outlive any handle
+    void ShrinkToFit()
+    {
+        ResizeItems(ItemCount);
+    }
+
+    int64_t Capacity() const
+    {
+        return AllocatedItemCount;
+    }
+
+    int64_t Size() const
+    {
+        return ItemCount;
+    }
+
+    int64_t SizeBytes() const
+    {
+        return ItemCount * (sizeof(ColumnTs) + ...);
+    }
+
+    const AllocatorT& GetAllocator() const
+    {
+        return Allocator;
+    }
+
+private:
+
+    using KeyTable::IsLiveHandle;
+    using KeyTable::MakeHandle;
+    using KeyTable::BumpKeyID;
+    using KeyTable::BindFreeKey;
+    using KeyTable::ReleaseKey;
+    using KeyTable::RelinkFreelist;
+    using KeyTable::LinkNewKeys;
+    using KeyTable::RequiredKeyCount;
+    using KeyTable::KeyCountForAdd;
+    using KeyTable::GrowCapacity;
+    using KeyTable::SparseCapacity;
+
+    template<typename T>
+    static constexpr size_t ColumnAlignment = std::max(alignof(T), Traits::ItemAlignment);
+
+    //calls Function with a reference to the data pointer of every column
+    template<typename FunctionT>
+    void ForEachColumn(FunctionT&& Function)
+    {
+        std::apply([&Function](auto*&... Data){ (Function(Data), ...); }, Columns);
+    }
+
+    //adds const to the column pointer if Self is const
+    template<typename Self, typename T>
+    static auto ConstColumn(T* Data)
+    {
+        if constexpr(std::is_const_v<std::remove_reference_t<Self>>)
+        {
+            return static_cast<const T*>(Data);
+        }
+        else
+        {
+            return Data;
+        }
+    }
+
+    template<typename T, typename... Ts>
+    static void ConstructColumn(T* Memory, Ts&&... Args)
+    {
+        if constexpr(std::is_constructible_v<T, Ts&&...>)
+        {
+            new(Memory) T(std::forward<Ts>(Args)...);
+        }
+        else
+        {
+            new(Memory) T{std::forward<Ts>(Args)...};
+        }
+    }
+
+    template<typename T>
+    static void DestroyColumn(T* Memory)
+    {
+        if constexpr(!std::is_trivially_destructible_v<T>)
+        {
+            Memory->T::~T();
+        }
+    }
+
+    //destroys the first Count columns of the item at ItemCount
+    template<size_t... Column>
+    void DestroyColumns(size_t Count, std::index_sequence<Column...>)
+    {
+        ((Column < Count ? DestroyColumn(std::get<Column>(Columns) + ItemCount) : void()), ...);
+    }
+
+    template<typename... Ts>
+    KeyHandle EmplaceUnchecked(Ts&&... Values)
+    {
+        auto Arguments = std::forward_as_tuple(std::forward<Ts>(Values)...);
+
+        //a throwing column destroys the ones constructed before it, so the map is left unchanged like with SlotMap::Emplace
+        struct ColumnRollback
+        {
+            SoASlotMap& Map;
+            size_t Constructed = 0;
+
+            ~ColumnRollback()
+            {
+                [[unlikely]] if(Constructed != ColumnCount)
+                {
+                    Map.DestroyColumns(Constructed, std::index_sequence_for<ColumnTs...>{});
+                }
+            }
+        } Rollback{*this};
+
+        [this, &Arguments, &Rollback]<size_t... Column>(std::index_sequence<Column...>)
+        {
+            ((ConstructColumn(std::get<Column>(Columns) + ItemCount, std::get<Column>(std::move(Arguments))), Rollback.Constructed += 1), ...);
+        }(std::index_sequence_for<ColumnTs...>{});
+
+        uint64_t KeyIndex = BindFreeKey(ItemCount);
+        KeyOffsets[ItemCount] = KeyIndex;
+
+        ItemCount += 1;
+
+        return MakeHandle(KeyIndex);
+    }
+
+    void Remove(ItemKey* Key) __attribute_nonnull__((2))
+    {
+        const uint64_t KeyIndex = std::distance(Keys, Key);
+        BumpKeyID(KeyIndex); //invalidate handles to this key.
+        ItemCount -= 1;
+
+        ItemKey& LastKey = Keys[KeyOffsets[ItemCount]];
+        uint64_t Hole = Key->Index;
+
+        ForEachColumn([this, Hole, &LastKey]<typename T>(T*& Data)
+        {
+            if(Hole != LastKey.Index) //move the last element of every column into the hole
+            {
+                Data[Hole] = std::move(Data[ItemCount]);
+            }
+
+            Data[ItemCount].T::~T();
+        });
+
+        KeyOffsets[Hole] = KeyOffsets[ItemCount];
+        LastKey.Index = Hole;
+
+        ReleaseKey(KeyIndex);
+
+        ShrinkItemsIfSparse();
+    }
+
+    void ShrinkItemsIfSparse()
+    {
+        ResizeItems(SparseCapacity(AllocatedItemCount, ItemCount));
+    }
+
+    bool ReserveForAdd(int64_t Count)
+    {
+        const int64_t RequiredItems = ItemCount + Count;
+        const int64_t NewKeyCount = KeyCountForAdd(RequiredItems);
+
+        [[unlikely]] if(NewKeyCount != KeyCount)
+        {
+            if(NewKeyCount < 0)
+            {
+                return false;
+            }
+
+            ResizeKeys(NewKeyCount);
+        }
+
+        [[unlikely]] if(RequiredItems > AllocatedItemCount)
+        {
+            if(Traits::GrowthPolicy == SlotMapGrowthPolicy::Fixed)
+            {
+                return false;
+            }
+
+            ResizeItems(GrowCapacity(AllocatedItemCount, RequiredItems));
+        }
+
+        return true;
+    }
+
+    void ResizeItems(int64_t Count)
+    {
+        SLOTMAP_ASSERT(Count >= ItemCount, "shrinking allocation below alive items is not allowed");
+
+        if(Count == AllocatedItemCount)
+        {
+            return;
+        }
+
+        auto* NewKeyOffsets = Count != 0 ? AllocateArray<KeyOffsetT>(Count, alignof(KeyOffsetT), 0) : nullptr;
+
+        if(KeyOffsets)
+        {
+            //Clear shrinks to 0 in one step, so the new arrays may be null with nothing to copy
+            if(ItemCount != 0)
+            {
+                std::memcpy(NewKeyOffsets, KeyOffsets, ItemCount * sizeof(KeyOffsetT));
+            }
+
+            DeallocateArray(KeyOffsets, AllocatedItemCount, alignof(KeyOffsetT), 0);
+        }
+
+        KeyOffsets = NewKeyOffsets;
+
+        ForEachColumn([this, Count]<typename T>(T*& Data)
+        {
+            T* NewData = Count != 0 ? AllocateArray<T>(Count, ColumnAlignment<T>, Traits::ItemPaddingBytes) : nullptr;
+
+            if(Data)
+            {
+                if constexpr(std::is_trivially_copyable_v<T>)
+                {
+                    if(ItemCount != 0)
+                    {
+                        std::memcpy(NewData, Data, ItemCount * sizeof(T));
+                    }
+                }
+                else
+                {
+                    for(int64_t Index = 0; Index < ItemCount; ++Index)
+                    {
+                        new(NewData + Index) T(std::move(Data[Index]));
+                        Data[Index].T::~T();
+                    }
+                }
+
+                DeallocateArray(Data, AllocatedItemCount, ColumnAlignment<T>, Traits::ItemPaddingBytes);
+            }
+
+            Data = NewData;
+        });
+
+        AllocatedItemCount = Count;
+    }
+
+    void ResizeKeys(int64_t Count)
+    {
+        SLOTMAP_ASSERT(Count >= KeyCount, "shrinking key allocation is not allowed");
+
+        if(Count != KeyCount)
+        {
+            int64_t OldKeyCount = KeyCount;
+            KeyCount = Count;
+
+            auto* NewKeys = AllocateArray<ItemKey>(KeyCount, alignof(ItemKey), 0);
+
+            if(Keys)
+            {
+                std::memcpy(NewKeys, Keys, OldKeyCount * sizeof(ItemKey));
+                DeallocateArray(Keys, OldKeyCount, alignof(ItemKey), 0);
+            }
+
+            Keys = NewKeys;
+
+            if constexpr(Traits::SplitGenerations)
+            {
+                auto* NewGenerations = AllocateArray<GenerationT>(KeyCount, alignof(GenerationT), 0);
+
+                if(Generations)
+                {
+                    std::memcpy(NewGenerations, Generations, OldKeyCount * sizeof(GenerationT));
+                    DeallocateArray(Generations, OldKeyCount, alignof(GenerationT), 0);
+                }
+
+                Generations = NewGenerations;
+            }
+
+            LinkNewKeys(OldKeyCount);
+        }
+    }
+
+    template<typename T>
+    T* AllocateArray(int64_t Count, size_t Alignment, size_t Padding)
+    {
+        auto* Memory = static_cast<T*>(Allocator.Allocate(Count * sizeof(T) + Padding, Alignment));
+        SLOTMAP_ASSERT(Memory != nullptr, "out of memory");
+        return Memory;
+    }
+
+    template<typename T>
+    void DeallocateArray(T* Memory, int64_t Count, size_t Alignment, size_t Padding)
+    {
+        Allocator.Deallocate(Memory, Count * sizeof(T) + Padding, Alignment);
+    }
+};
+
+#endif //SOASLOTMAP_HPP
@@ -0,0 +1,239 @@
+/**
+ * runs random adds and removes on InlineSlotMaps of several sizes and an std::unordered_map from handles to values and checks that both agree,
+ * that the map never holds more than N items and that Entries and AsSpan see every item once. also covers AddRange, AddN, RemoveBatch, Clear, copies
+ * and how Add and Emplace construct items
+ */
+
+#include "inlineslotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace
+{
+    template<typename ItemT, int64_t N>
+    class ModelTest : public SlotMapModelTest<ModelTest<ItemT, N>, InlineSlotMap<ItemT, N>>
+    {
+        using Base = SlotMapModelTest<ModelTest, InlineSlotMap<ItemT, N>>;
+        using MapT = InlineSlotMap<ItemT, N>;
+        using KeyHandle = typename MapT::KeyHandle;
+        using Base::Map, Base::Model, Base::Live, Base::Stale, Base::NextValue;
+
+    public:
+        using Base::Base;
+
+        void Run(int Steps)
+        {
+            Base::Run(Steps, 32);
+
+            //copies hold the same items under the same handles
+            MapT Copy = Map;
+            CheckSame(Copy);
+
+            MapT Moved = std::move(Copy);
+            CheckSame(Moved);
+        }
+
+        void Step()
+        {
+            const int64_t Operation = this->Pick(32);
+
+            if(Operation < 14 || Live.empty())
+            {
+                Add();
+            }
+            else if(Operation < 16)
+            {
+                AddRange();
+            }
+            else if(Operation < 29)
+            {
+                this->RemoveRandom();
+            }
+            else if(Operation < 31)
+            {
+                RemoveBatch();
+            }
+            else
+            {
+                Map.Clear();
+                this->ForgetAll();
+            }
+        }
+
+        void CheckAll()
+        {
+            SLOTMAP_CHECK(Map.Size() == std::ssize(Model));
+            SLOTMAP_CHECK(Map.Size() <= N);
+
+            for(const auto& [Handle, Value] : Model)
+            {
+                const ItemT* Item = Map[Handle];
+                SLOTMAP_CHECK(Item != nullptr && SlotMapTestValue(*Item) == Value);
+            }
+
+            this->CheckStale();
+
+            int64_t EntryCount = 0;
+
+            for(auto [Handle, Item] : Map.Entries())
+            {
+                SLOTMAP_CHECK(Map[Handle] == &Item && &Item == &Map[EntryCount]);
+                SLOTMAP_CHECK(Model.contains(Handle) && Model[Handle] == SlotMapTestValue(Item));
+                EntryCount += 1;
+            }
+
+            SLOTMAP_CHECK(EntryCount == Map.Size());
+
+            const MapT& ConstMap = Map;
+
+            for(auto [Handle, Item] : ConstMap.Entries())
+            {
+                SLOTMAP_CHECK(ConstMap.GetHandle(&Item) == Handle);
+            }
+
+            //the span covers the inline storage in iteration order
+            const std::span<ItemT> Span = Map.AsSpan();
+            const std::span<const ItemT> ConstSpan = ConstMap.AsSpan();
+            SLOTMAP_CHECK(std::ssize(Span) == Map.Size() && ConstSpan.data() == Span.data() && ConstSpan.size() == Span.size());
+
+            int64_t Index = 0;
+
+            for(ItemT& Item : Map)
+            {
+                SLOTMAP_CHECK(Index < std::ssize(Span) && &Item == &Span[Index]);
+                Index += 1;
+            }
+
+            SLOTMAP_CHECK(Index == std::ssize(Span));
+        }
+
+    private:
+        void Add()
+        {
+            const int Value = NextValue++;
+            const KeyHandle Handle = Map.TryEmplace(SlotMapTestItem<ItemT>(Value));
+
+            [[unlikely]] if(Handle == MapT::NullHandle)
+            {
+                //full, either N items or too few keys left off the retired ones
+                SLOTMAP_CHECK(Map.Size() == N || Map.Size() + Map.RetiredKeys() + 1 >= Map.KeyCapacity());
+                return;
+            }
+
+            this->Track(Handle, Value);
+        }
+
+        void AddRange()
+        {
+            const int64_t Room = std::min(N - Map.Size(), Map.KeyCapacity() - Map.Size() - Map.RetiredKeys() - 1);
+            const int64_t Count = Room > 0 ? this->Pick(Room + 1) : 0;
+            const int First = NextValue;
+            std::vector<KeyHandle> Handles(Count);
+
+            if(this->Pick(2) == 0)
+            {
+                Map.AddRange(Count, [First](int64_t Index) { return SlotMapTestItem<ItemT>(First + static_cast<int>(Index)); }, Handles);
+            }
+            else
+            {
+                std::vector<ItemT> Source;
+
+                for(int64_t Index = 0; Index < Count; ++Index)
+                {
+                    Source.push_back(SlotMapTestItem<ItemT>(First + static_cast<int>(Index)));
+                }
+
+                Map.AddN(Source, Handles);
+            }
+
+            for(int64_t Index = 0; Index < Count; ++Index)
+            {
+                this->Track(Handles[Index], First + static_cast<int>(Index));
+            }
+
+            NextValue += static_cast<int>(Count);
+        }
+
+        //a few live handles with a duplicate and stale handles mixed in
+        void RemoveBatch()
+        {
+            std::vector<KeyHandle> Batch;
+            int64_t Expected = 0;
+
+            for(int64_t Picks = this->Pick(8); Picks > 0 && !Live.empty(); --Picks)
+            {
+                const int64_t Position = this->Pick(std::ssize(Live));
+                Batch.push_back(Live[Position]);
+                Batch.push_back(Live[Position]);
+                this->Forget(Position);
+                Expected += 1;
+            }
+
+            if(!Stale.empty())
+            {
+                Batch.push_back(Stale[this->Pick(std::ssize(Stale))]);
+            }
+
+            Batch.push_back(MapT::NullHandle);
+
+            SLOTMAP_CHECK(Map.RemoveBatch(Batch) == Expected);
+        }
+
+        void CheckSame(const MapT& Other)
+        {
+            SLOTMAP_CHECK(Other.Size() == Map.Size());
+
+            for(const auto& [Handle, Value] : Model)
+            {
+                const ItemT* Item = Other[Handle];
+                SLOTMAP_CHECK(Item != nullptr && SlotMapTestValue(*Item) == Value);
+            }
+        }
+    };
+
+    void TestClear()
+    {
+        InlineSlotMap<std::string, 16> Map;
+        std::vector<InlineSlotMap<std::string, 16>::KeyHandle> Handles;
+
+        for(int Index = 0; Index < 16; ++Index)
+        {
+            Handles.push_back(Map.Add(std::string(32, 'a')));
+        }
+
+        SLOTMAP_CHECK(Map.TryEmplace(std::string(32, 'b')) == Map.NullHandle);
+
+        Map.Clear();
+        SLOTMAP_CHECK(Map.Size() == 0);
+
+        for(auto Handle : Handles)
+        {
+            SLOTMAP_CHECK(!Map.IsValidHandle(Handle));
+        }
+
+        //the freelist was relinked trough every key, so the map takes N items again
+        for(int Index = 0; Index < 16; ++Index)
+        {
+            SLOTMAP_CHECK(Map.TryEmplace(std::to_string(Index)) != Map.NullHandle);
+        }
+    }
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        ModelTest<int, 1>(Seed).Run(2000);
+        ModelTest<int, 24>(Seed).Run(4000);
+        ModelTest<std::string, 24>(Seed).Run(4000);
+        ModelTest<int64_t, 300>(Seed).Run(6000);
+    }
+
+    TestClear();
+    SlotMapTestConstruction<InlineSlotMap<std::vector<int>, 8>>();
+
+    return SlotMapTestResult("inlineslotmap_test");
+}
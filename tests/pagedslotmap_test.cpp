@@ -0,0 +1,277 @@
+/**
+ * runs random adds and removes on a PagedSlotMap and an std::unordered_map from handles to values and checks that both agree,
+ * that growing never moves an item and that ForEachPage and the iterators see every item once. also covers AddRange, AddN,
+ * Clear, retiring keys, a fixed capacity and how Add and Emplace construct items
+ */
+
+#include "pagedslotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    template<typename Traits>
+    class ModelTest : public SlotMapModelTest<ModelTest<Traits>, PagedSlotMap<std::string, Traits>>
+    {
+        using Base = SlotMapModelTest<ModelTest, PagedSlotMap<std::string, Traits>>;
+        using MapT = PagedSlotMap<std::string, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+        using Base::Map, Base::Model, Base::Live, Base::NextValue;
+
+    public:
+        using Base::Base;
+
+        void Step()
+        {
+            const int64_t Operation = this->Pick(32);
+
+            if(Operation < 14 || Live.empty())
+            {
+                Add();
+            }
+            else if(Operation < 16)
+            {
+                AddRange();
+            }
+            else if(Operation < 31)
+            {
+                this->RemoveRandom();
+            }
+            else
+            {
+                Map.Clear(this->Pick(2) == 0);
+                this->ForgetAll();
+            }
+        }
+
+        void CheckAll()
+        {
+            SLOTMAP_CHECK(Map.Size() == std::ssize(Model));
+            SLOTMAP_CHECK(Map.Capacity() >= Map.Size() && Map.Capacity() % MapT::PageSize == 0);
+
+            for(const auto& [Handle, Value] : Model)
+            {
+                const std::string* Item = Map[Handle];
+                SLOTMAP_CHECK(Item != nullptr && *Item == SlotMapTestItem<std::string>(Value));
+            }
+
+            this->CheckStale();
+
+            int64_t Index = 0;
+
+            for(const std::string& Item : Map)
+            {
+                SLOTMAP_CHECK(&Item == &Map[Index]);
+                SLOTMAP_CHECK(Model[Map.GetHandle(Index)] == SlotMapTestValue(Item));
+                Index += 1;
+            }
+
+            SLOTMAP_CHECK(Index == Map.Size());
+
+            int64_t PagedCount = 0;
+
+            Map.ForEachPage([this, &PagedCount](std::span<std::string> Items)
+            {
+                SLOTMAP_CHECK(std::ssize(Items) <= MapT::PageSize);
+
+                for(std::string& Item : Items)
+                {
+                    SLOTMAP_CHECK(&Item == &Map[PagedCount]);
+                    PagedCount += 1;
+                }
+            });
+
+            SLOTMAP_CHECK(PagedCount == Map.Size());
+        }
+
+    private:
+        void Add()
+        {
+            //growing only adds a page, an item that is not removed or swapped stays where it is
+            const std::string* First = Map.Size() != 0 ? &Map[int64_t(0)] : nullptr;
+
+            const int Value = NextValue++;
+            this->Track(Map.Add(SlotMapTestItem<std::string>(Value)), Value);
+
+            SLOTMAP_CHECK(First == nullptr || First == &Map[int64_t(0)]);
+        }
+
+        void AddRange()
+        {
+            const int64_t Count = this->Pick(70);
+            const int First = NextValue;
+            std::vector<KeyHandle> Handles(Count);
+
+            if(this->Pick(2) == 0)
+            {
+                Map.AddRange(Count, [First](int64_t Index) { return SlotMapTestItem<std::string>(First + static_cast<int>(Index)); }, Handles);
+            }
+            else
+            {
+                std::vector<std::string> Source;
+
+                for(int64_t Index = 0; Index < Count; ++Index)
+                {
+                    Source.push_back(SlotMapTestItem<std::string>(First + static_cast<int>(Index)));
+                }
+
+                Map.AddN(Source, Handles);
+            }
+
+            for(int64_t Index = 0; Index < Count; ++Index)
+            {
+                this->Track(Handles[Index], First + static_cast<int>(Index));
+            }
+
+            NextValue += static_cast<int>(Count);
+        }
+    };
+
+    struct SmallPageTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+    };
+
+    struct FixedTraits : SlotMapTestFixedTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+    };
+
+    void TestClear()
+    {
+        PagedSlotMap<std::string, SmallPageTraits> Map;
+        std::vector<PagedSlotMap<std::string, SmallPageTraits>::KeyHandle> Handles;
+
+        for(int Index = 0; Index < 100; ++Index)
+        {
+            Handles.push_back(Map.Add(std::string(32, 'a')));
+        }
+
+        Map.Clear(true);
+        SLOTMAP_CHECK(Map.Size() == 0 && Map.Capacity() >= 100);
+
+        for(auto Handle : Handles)
+        {
+            SLOTMAP_CHECK(!Map.IsValidHandle(Handle));
+        }
+
+        Map.Add(std::string(32, 'b'));
+        Map.Clear();
+        SLOTMAP_CHECK(Map.Size() == 0 && Map.Capacity() == 0); //pages are freed like after Remove
+
+        //the freelist was relinked trough every key, refilling does not grow the keys
+        const int64_t Keys = Map.KeyCapacity();
+
+        for(int Index = 0; Index < 100; ++Index)
+        {
+            Map.Add(std::string(32, 'c'));
+        }
+
+        SLOTMAP_CHECK(Map.KeyCapacity() == Keys);
+    }
+
+    struct ShrinkingTraits : SmallPageTraits
+    {
+        static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Geometric;
+        static constexpr double ShrinkThreshold = 0.25;
+    };
+
+    struct NonShrinkingTraits : ShrinkingTraits
+    {
+        static constexpr double ShrinkThreshold = 0.0;
+    };
+
+    struct LinearTraits : SmallPageTraits
+    {
+        static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Linear;
+    };
+
+    //removing items frees pages by the same rules SlotMap shrinks its items by
+    template<typename Traits>
+    void TestFreePages()
+    {
+        constexpr int64_t PageSize = Traits::AllocationSize;
+
+        PagedSlotMap<int, Traits> Map;
+        std::vector<typename PagedSlotMap<int, Traits>::KeyHandle> Handles;
+
+        for(int Index = 0; Index < 256; ++Index)
+        {
+            Handles.push_back(Map.Add(Index));
+        }
+
+        SLOTMAP_CHECK(Map.Capacity() == 256);
+
+        int64_t Capacity = Map.Capacity();
+
+        while(!Handles.empty())
+        {
+            SLOTMAP_CHECK(Map.Remove(Handles.back()));
+            Handles.pop_back();
+
+            const int64_t Size = Map.Size();
+
+            if constexpr(Traits::GrowthPolicy == SlotMapGrowthPolicy::Linear)
+            {
+                //at most one spare page, all of them go once a second one is empty
+                SLOTMAP_CHECK(Map.Capacity() < Size + PageSize * 2);
+                SLOTMAP_CHECK(Map.Capacity() == Capacity || Map.Capacity() == (Size + PageSize - 1) / PageSize * PageSize);
+            }
+            else if constexpr(Traits::ShrinkThreshold > 0.0)
+            {
+                //shrinks below the threshold to one growth step above the size
+                const bool Sparse = Capacity > PageSize && Size < static_cast<int64_t>(Capacity * Traits::ShrinkThreshold);
+                const int64_t Grown = static_cast<int64_t>(Size * Traits::GrowthFactor);
+                SLOTMAP_CHECK(Map.Capacity() == (Sparse ? (Grown + PageSize - 1) / PageSize * PageSize : Capacity));
+            }
+            else
+            {
+                SLOTMAP_CHECK(Map.Capacity() == 256);
+            }
+
+            Capacity = Map.Capacity();
+        }
+    }
+
+    void TestFixedCapacity()
+    {
+        PagedSlotMap<int, FixedTraits> Map;
+        SLOTMAP_CHECK(Map.TryEmplace(1) == Map.NullHandle);
+
+        Map.Reserve(20);
+        SLOTMAP_CHECK(Map.Capacity() == 32);
+
+        int64_t Added = 0;
+
+        while(Map.TryEmplace(static_cast<int>(Added)) != Map.NullHandle)
+        {
+            Added += 1;
+        }
+
+        SLOTMAP_CHECK(Added == 20 && Map.Size() == 20); //the keys run out first
+    }
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        ModelTest<SlotMapDefaultTraits>(Seed).Run(4000);
+        ModelTest<SmallPageTraits>(Seed).Run(4000);
+        ModelTest<SlotMapTestRetiringTraits>(Seed).Run(4000);
+        ModelTest<SlotMapTestSplitRetiringTraits>(Seed).Run(4000);
+    }
+
+    TestClear();
+    SlotMapTestRetiredKeys<PagedSlotMap<int, SlotMapTestRetiringTraits>>([](auto& Map, auto Handle) { return *Map[Handle]; });
+    SlotMapTestRetiredKeys<PagedSlotMap<int, SlotMapTestSplitRetiringTraits>>([](auto& Map, auto Handle) { return *Map[Handle]; });
+    TestFreePages<ShrinkingTraits>();
+    TestFreePages<NonShrinkingTraits>();
+    TestFreePages<LinearTraits>();
+    TestFixedCapacity();
+    SlotMapTestConstruction<PagedSlotMap<std::vector<int>>>();
+
+    return SlotMapTestResult("pagedslotmap_test");
+}
@@ -0,0 +1,260 @@
+/**
+ * attaches values to the items of a SlotMap trough SecondaryMaps of both layouts and checks them against an std::unordered_map from key index
+ * to the handle and value added last: replacing values, values of removed items that must not match the next item of their key, RemoveStale,
+ * a throwing replacement, Clear and moves. the dense layout also has to keep its handles, AsSpan and iteration in the same order
+ */
+
+#include "secondarymap.hpp"
+#include "slotmap_test.hpp"
+
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using PrimaryT = SlotMap<int>;
+    using HandleT = PrimaryT::KeyHandle;
+
+    //throws when made from a negative number so a replacement can fail
+    struct Value
+    {
+        std::string Text;
+
+        explicit Value(int Number)
+            : Text(SlotMapTestItem<std::string>(Number))
+        {
+            [[unlikely]] if(Number < 0)
+            {
+                throw std::runtime_error("value");
+            }
+        }
+    };
+
+    template<typename SideT>
+    class ModelTest : public SlotMapModelTest<ModelTest<SideT>, PrimaryT>
+    {
+        using Base = SlotMapModelTest<ModelTest, PrimaryT>;
+        using Base::Map, Base::Live, Base::Stale, Base::NextValue, Base::Pick;
+
+    public:
+        using Base::Base;
+
+        void Step()
+        {
+            const int64_t Operation = Pick(100);
+
+            if(Operation < 30 || Live.empty())
+            {
+                const int Number = NextValue++;
+                this->Track(Map.Add(Number), Number);
+            }
+            else if(Operation < 45)
+            {
+                this->RemoveRandom(); //the value of the item lingers in Side until its key is reused or RemoveStale runs
+            }
+            else if(Operation < 75)
+            {
+                //a live handle or a stale one, both replace the value of an earlier handle to the key
+                const HandleT Handle = Stale.empty() || Pick(4) != 0 ? Live[Pick(std::ssize(Live))] : Stale[Pick(std::ssize(Stale))];
+                const int Number = NextValue++;
+
+                SLOTMAP_CHECK(Side.Emplace(Handle, Number).Text == SlotMapTestItem<std::string>(Number));
+                Values[Handle.Index] = {Handle, Number};
+            }
+            else if(Operation < 80)
+            {
+                const HandleT Handle = Live[Pick(std::ssize(Live))];
+                bool Threw = false;
+
+                try
+                {
+                    Side.Emplace(Handle, -1);
+                }
+                catch(const std::runtime_error&)
+                {
+                    Threw = true;
+                }
+
+                SLOTMAP_CHECK(Threw); //and the model is unchanged, the old value of the key stays under its old handle
+            }
+            else if(Operation < 90 && !Values.empty())
+            {
+                const int64_t Skip = Pick(std::ssize(Values));
+                auto Picked = std::next(Values.begin(), Skip);
+
+                SLOTMAP_CHECK(Side.Remove(Picked->second.Handle));
+                SLOTMAP_CHECK(!Side.Remove(Picked->second.Handle));
+                Values.erase(Picked);
+            }
+            else if(Operation < 95)
+            {
+                int64_t Expected = 0;
+
+                for(auto Entry = Values.begin(); Entry != Values.end();)
+                {
+                    if(!Map.IsValidHandle(Entry->second.Handle))
+                    {
+                        Entry = Values.erase(Entry);
+                        Expected += 1;
+                    }
+                    else
+                    {
+                        ++Entry;
+                    }
+                }
+
+                SLOTMAP_CHECK(Side.RemoveStale(Map) == Expected);
+            }
+            else if(Operation < 98)
+            {
+                //the moved from map is empty and usable
+                SideT Moved(std::move(Side));
+                SLOTMAP_CHECK(Side.Size() == 0 && !Side.Contains(Live[0]));
+
+                Side = std::move(Moved);
+            }
+            else
+            {
+                Side.Clear();
+                Values.clear();
+            }
+        }
+
+        void CheckAll()
+        {
+            SLOTMAP_CHECK(Side.Size() == std::ssize(Values));
+
+            for(const auto& [Index, Added] : Values)
+            {
+                const Value* Found = Side[Added.Handle];
+                SLOTMAP_CHECK(Found != nullptr && Found->Text == SlotMapTestItem<std::string>(Added.Number));
+            }
+
+            //a handle only finds the value added with it, not the value of another handle to the same key
+            auto CheckMissing = [this](HandleT Handle)
+            {
+                auto Found = Values.find(Handle.Index);
+
+                if(Found == Values.end() || Found->second.Handle != Handle)
+                {
+                    SLOTMAP_CHECK(Side[Handle] == nullptr && !Side.Contains(Handle));
+                }
+            };
+
+            for(HandleT Handle : Live)
+            {
+                CheckMissing(Handle);
+            }
+
+            for(HandleT Handle : Stale)
+            {
+                CheckMissing(Handle);
+            }
+
+            int64_t Visited = 0;
+
+            Side.ForEach([this, &Visited](HandleT Handle, const Value& Found)
+            {
+                auto Added = Values.find(Handle.Index);
+                SLOTMAP_CHECK(Added != Values.end() && Added->second.Handle == Handle);
+                SLOTMAP_CHECK(Added != Values.end() && Found.Text == SlotMapTestItem<std::string>(Added->second.Number));
+                Visited += 1;
+            });
+
+            SLOTMAP_CHECK(Visited == Side.Size());
+
+            if constexpr(requires { Side.GetHandles(); })
+            {
+                const auto Handles = Side.GetHandles();
+                SLOTMAP_CHECK(std::ssize(Handles) == Side.Size());
+
+                for(int64_t Index = 0; Index < std::ssize(Handles); ++Index)
+                {
+                    SLOTMAP_CHECK(Side.IndexOf(Handles[Index]) == Index && &Side[Index] == Side[Handles[Index]]);
+                }
+
+                //the values as a span in the order of the handles and of iterating
+                const std::span<Value> Span = Side.AsSpan();
+                const std::span<const Value> ConstSpan = std::as_const(Side).AsSpan();
+                SLOTMAP_CHECK(std::ssize(Span) == Side.Size() && ConstSpan.data() == Span.data() && ConstSpan.size() == Span.size());
+
+                int64_t Index = 0;
+
+                for(Value& Found : Side)
+                {
+                    SLOTMAP_CHECK(Index < std::ssize(Span) && &Found == &Span[Index] && &Found == Side[Handles[Index]]);
+                    Index += 1;
+                }
+
+                SLOTMAP_CHECK(Index == std::ssize(Span));
+            }
+        }
+
+    private:
+        struct Added
+        {
+            HandleT Handle;
+            int Number;
+        };
+
+        SideT Side;
+        std::unordered_map<uint64_t, Added> Values; //by key index, a key holds at most one value
+    };
+
+    //a value added for an item does not match the next item of the same key, until it is replaced by a value for that item
+    template<typename SideT>
+    void TestReusedKey()
+    {
+        PrimaryT Primary;
+        SideT Side;
+
+        const HandleT First = Primary.Add(1);
+        Side.Emplace(First, 1);
+        SLOTMAP_CHECK(Primary.Remove(First));
+
+        HandleT Next = Primary.Add(2);
+
+        while(Next.Index != First.Index) //the freelist is FIFO, the key comes back eventually
+        {
+            Primary.Remove(Next);
+            Next = Primary.Add(2);
+        }
+
+        SLOTMAP_CHECK(Next != First);
+        SLOTMAP_CHECK(Side[Next] == nullptr && Side[First] != nullptr);
+
+        Side.Emplace(Next, 2);
+        SLOTMAP_CHECK(Side.Size() == 1);
+        SLOTMAP_CHECK(Side[First] == nullptr && Side[Next]->Text == SlotMapTestItem<std::string>(2));
+
+        Primary.Remove(Next);
+        SLOTMAP_CHECK(Side.RemoveStale(Primary) == 1 && Side.Size() == 0);
+    }
+
+    struct SmallPageTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+    };
+
+    template<SecondaryMapLayout Layout, typename Traits>
+    using SideMap = SecondaryMap<Value, HandleT, Layout, Traits>;
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        ModelTest<SideMap<SecondaryMapLayout::Sparse, SlotMapDefaultTraits>>(Seed).Run(6000);
+        ModelTest<SideMap<SecondaryMapLayout::Sparse, SmallPageTraits>>(Seed).Run(6000);
+        ModelTest<SideMap<SecondaryMapLayout::Dense, SlotMapDefaultTraits>>(Seed).Run(6000);
+        ModelTest<SideMap<SecondaryMapLayout::Dense, SmallPageTraits>>(Seed).Run(6000);
+    }
+
+    TestReusedKey<SideMap<SecondaryMapLayout::Sparse, SlotMapDefaultTraits>>();
+    TestReusedKey<SideMap<SecondaryMapLayout::Dense, SlotMapDefaultTraits>>();
+
+    return SlotMapTestResult("secondarymap_test");
+}
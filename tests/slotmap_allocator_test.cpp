@@ -0,0 +1,450 @@
+/**
+ * runs maps on a counting std::pmr::memory_resource and checks that every allocation of the map goes trough its allocator, that every block
+ * is returned with the size and alignment it was allocated with, and that the Reallocate of a custom allocator is used for trivially copyable arrays only.
+ * begin() has to keep the alignment of the items and Traits::ItemAlignment trough growing, shrinking, ShrinkToFit and Deserialize
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    //remembers every block it handed out, the default resource is replaced by a null resource during the tests so an allocator that falls back to it throws
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        struct Block
+        {
+            size_t Size;
+            size_t Alignment;
+        };
+
+        std::unordered_map<void*, Block> Blocks;
+        int64_t Allocations = 0;
+        int64_t Deallocations = 0;
+        int64_t Mismatches = 0; //deallocations of unknown blocks or with a different size or alignment
+
+        bool Owns(const void* Memory) const
+        {
+            for(const auto& [Start, Info] : Blocks)
+            {
+                if(Memory >= Start && Memory < static_cast<const char*>(Start) + Info.Size)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        size_t OutstandingBytes() const
+        {
+            size_t Bytes = 0;
+
+            for(const auto& [Start, Info] : Blocks)
+            {
+                Bytes += Info.Size;
+            }
+
+            return Bytes;
+        }
+
+    private:
+        void* do_allocate(size_t Size, size_t Alignment) override
+        {
+            void* Memory = std::pmr::new_delete_resource()->allocate(Size, Alignment);
+            Blocks.emplace(Memory, Block{Size, Alignment});
+            Allocations += 1;
+            return Memory;
+        }
+
+        void do_deallocate(void* Memory, size_t Size, size_t Alignment) override
+        {
+            const auto Entry = Blocks.find(Memory);
+
+            [[unlikely]] if(Entry == Blocks.end() || Entry->second.Size != Size || Entry->second.Alignment != Alignment)
+            {
+                Mismatches += 1;
+            }
+            else
+            {
+                Blocks.erase(Entry);
+            }
+
+            Deallocations += 1;
+            std::pmr::new_delete_resource()->deallocate(Memory, Size, Alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override
+        {
+            return this == &Other;
+        }
+    };
+
+    class ScopedNullDefaultResource
+    {
+    public:
+        ScopedNullDefaultResource()
+            : Previous(std::pmr::set_default_resource(std::pmr::null_memory_resource()))
+        {
+        }
+
+        ~ScopedNullDefaultResource()
+        {
+            std::pmr::set_default_resource(Previous);
+        }
+
+    private:
+        std::pmr::memory_resource* Previous;
+    };
+
+    struct PmrTraits : SlotMapDefaultTraits
+    {
+        using AllocatorT = SlotMapPmrAllocator;
+    };
+
+    struct PmrMigrationTraits : PmrTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+        static constexpr int64_t MigrationBudget = 2;
+    };
+
+    template<typename ItemT, typename Traits>
+    void CheckOwned(SlotMap<ItemT, Traits>& Map, const CountingResource& Resource)
+    {
+        SLOTMAP_CHECK(Resource.Mismatches == 0);
+        SLOTMAP_CHECK(Map.GetAllocator().Resource == &Resource);
+
+        if(Map.Capacity() != 0)
+        {
+            SLOTMAP_CHECK(Resource.Owns(Map.begin()));
+
+            //at least the items and their key offsets
+            SLOTMAP_CHECK(Resource.OutstandingBytes() >= size_t(Map.Capacity()) * (sizeof(ItemT) + sizeof(typename SlotMap<ItemT, Traits>::KeyOffsetT)));
+        }
+    }
+
+    template<typename ItemT, typename Traits>
+    void TestPmr()
+    {
+        using MapT = SlotMap<ItemT, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+
+        CountingResource Resource;
+
+        {
+            ScopedNullDefaultResource NullDefault;
+            MapT Map(SlotMapPmrAllocator{&Resource});
+            std::vector<KeyHandle> Handles;
+
+            for(int Index = 0; Index < 3000; ++Index)
+            {
+                Handles.push_back(Map.Add(SlotMapTestItem<ItemT>(Index)));
+            }
+
+            SLOTMAP_CHECK(Resource.Allocations > 0);
+            CheckOwned(Map, Resource);
+
+            for(int Index = 0; Index < 3000; Index += 2)
+            {
+                SLOTMAP_CHECK(Index % 4 == 0 ? Map.Remove(Handles[Index]) : Map.MarkRemoved(Handles[Index]));
+            }
+
+            Map.Flush();
+            Map.ShrinkToFit();
+            Map.CompleteMigration();
+            CheckOwned(Map, Resource);
+
+            {
+                MapT Clone = Map.Clone();
+                CheckOwned(Clone, Resource);
+                SLOTMAP_CHECK(Clone.Size() == Map.Size());
+            }
+
+            Map.Clear(true);
+            CheckOwned(Map, Resource);
+            SLOTMAP_CHECK(Map.Capacity() > 0);
+
+            const int64_t BlocksBeforeClear = std::ssize(Resource.Blocks);
+            Map.Clear();
+            Map.CompleteMigration();
+            CheckOwned(Map, Resource);
+            SLOTMAP_CHECK(Map.Capacity() == 0);
+            SLOTMAP_CHECK(std::ssize(Resource.Blocks) < BlocksBeforeClear);
+
+            //refilling after the clear reuses the resource
+            for(int Index = 0; Index < 100; ++Index)
+            {
+                Map.Add(SlotMapTestItem<ItemT>(Index));
+            }
+
+            CheckOwned(Map, Resource);
+        }
+
+        SLOTMAP_CHECK(Resource.Mismatches == 0);
+        SLOTMAP_CHECK(Resource.Blocks.empty());
+        SLOTMAP_CHECK(Resource.Allocations == Resource.Deallocations);
+    }
+
+    /**
+     * resizes in place by copying into a new block of the resource, declines every other call so the map's fallback is covered as well.
+     * calls with ItemAlignment are the item array, every other array of the map has the alignment of its elements
+     */
+    struct CountingReallocator
+    {
+        static constexpr size_t ItemAlignment = 32;
+
+        CountingResource* Resource;
+        int64_t* Reallocations;
+        int64_t* ItemReallocations;
+
+        void* Allocate(size_t Size, size_t Alignment)
+        {
+            return Resource->allocate(Size, Alignment);
+        }
+
+        void Deallocate(void* Memory, size_t Size, size_t Alignment)
+        {
+            Resource->deallocate(Memory, Size, Alignment);
+        }
+
+        void* Reallocate(void* Memory, size_t OldSize, size_t NewSize, size_t Alignment)
+        {
+            *Reallocations += 1;
+            *ItemReallocations += Alignment == ItemAlignment;
+
+            if(*Reallocations % 2 == 0)
+            {
+                return nullptr;
+            }
+
+            void* Resized = Resource->allocate(NewSize, Alignment);
+            std::memcpy(Resized, Memory, std::min(OldSize, NewSize));
+            Resource->deallocate(Memory, OldSize, Alignment);
+            return Resized;
+        }
+    };
+
+    static_assert(SlotMapReallocatingAllocator<CountingReallocator>);
+    static_assert(!SlotMapReallocatingAllocator<SlotMapPmrAllocator>);
+
+    struct ReallocatingTraits : SlotMapDefaultTraits
+    {
+        using AllocatorT = CountingReallocator;
+        static constexpr size_t ItemAlignment = CountingReallocator::ItemAlignment;
+        static constexpr int64_t AllocationSize = 64;
+    };
+
+    struct ReallocatingConcurrentTraits : ReallocatingTraits
+    {
+        static constexpr bool ConcurrentReads = true;
+    };
+
+    template<typename ItemT, typename Traits>
+    void TestReallocate(bool ExpectItems, bool ExpectAny)
+    {
+        CountingResource Resource;
+        int64_t Reallocations = 0;
+        int64_t ItemReallocations = 0;
+
+        {
+            SlotMap<ItemT, Traits> Map(CountingReallocator{&Resource, &Reallocations, &ItemReallocations});
+            std::vector<typename SlotMap<ItemT, Traits>::KeyHandle> Handles;
+
+            for(int Index = 0; Index < 1000; ++Index)
+            {
+                Handles.push_back(Map.Add(SlotMapTestItem<ItemT>(Index)));
+            }
+
+            for(int Index = 0; Index < 1000; Index += 3)
+            {
+                SLOTMAP_CHECK(Map.Remove(Handles[Index]));
+            }
+
+            Map.ShrinkToFit();
+
+            //the items are intact whether the resize went trough Reallocate or the fallback
+            for(int Index = 0; Index < 1000; ++Index)
+            {
+                const ItemT* Item = Map[Handles[Index]];
+                SLOTMAP_CHECK((Index % 3 == 0) == (Item == nullptr));
+                SLOTMAP_CHECK(Item == nullptr || SlotMapTestValue(*Item) == Index);
+            }
+
+            SLOTMAP_CHECK(reinterpret_cast<uintptr_t>(Map.begin()) % CountingReallocator::ItemAlignment == 0);
+        }
+
+        SLOTMAP_CHECK((ItemReallocations > 0) == ExpectItems);
+        SLOTMAP_CHECK((Reallocations > 0) == ExpectAny);
+        SLOTMAP_CHECK(Resource.Mismatches == 0);
+        SLOTMAP_CHECK(Resource.Blocks.empty());
+        SLOTMAP_CHECK(Resource.Allocations == Resource.Deallocations);
+    }
+
+    struct alignas(32) WideItem
+    {
+        int Value = 0;
+
+        WideItem() = default;
+
+        explicit WideItem(int InValue)
+            : Value(InValue)
+        {
+        }
+
+        explicit operator int() const
+        {
+            return Value;
+        }
+    };
+
+    //returns memory aligned to exactly the requested alignment and never more, so an array allocated with too small an alignment is misaligned every time
+    struct ExactAlignmentAllocator
+    {
+        void* Allocate(size_t Size, size_t Alignment)
+        {
+            return static_cast<char*>(std::pmr::new_delete_resource()->allocate(Size + Alignment, Alignment * 2)) + Alignment;
+        }
+
+        void Deallocate(void* Memory, size_t Size, size_t Alignment)
+        {
+            std::pmr::new_delete_resource()->deallocate(static_cast<char*>(Memory) - Alignment, Size + Alignment, Alignment * 2);
+        }
+    };
+
+    struct ExactAlignmentTraits : SlotMapDefaultTraits
+    {
+        using AllocatorT = ExactAlignmentAllocator;
+    };
+
+    //below alignof(ItemT) of WideItem, shrinks automatically
+    struct SmallAlignmentTraits : ExactAlignmentTraits
+    {
+        static constexpr size_t ItemAlignment = 8;
+        static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Geometric;
+        static constexpr double ShrinkThreshold = 0.25;
+        static constexpr int64_t AllocationSize = 16;
+    };
+
+    struct WideAlignmentTraits : SmallAlignmentTraits
+    {
+        static constexpr size_t ItemAlignment = 128;
+    };
+
+    template<typename ItemT, typename Traits>
+    void CheckAligned(SlotMap<ItemT, Traits>& Map)
+    {
+        constexpr size_t Alignment = std::max(alignof(ItemT), Traits::ItemAlignment);
+        static_assert(SlotMap<ItemT, Traits>::ItemAlignment == Alignment);
+
+        SLOTMAP_CHECK(reinterpret_cast<uintptr_t>(Map.begin()) % Alignment == 0);
+    }
+
+    template<typename ItemT, typename Traits>
+    void TestAlignment()
+    {
+        using MapT = SlotMap<ItemT, Traits>;
+
+        MapT Map;
+        std::vector<typename MapT::KeyHandle> Handles;
+        int64_t Resizes = 0;
+
+        for(int Index = 0; Index < 2000; ++Index)
+        {
+            const int64_t OldCapacity = Map.Capacity();
+            Handles.push_back(Map.Add(SlotMapTestItem<ItemT>(Index)));
+
+            if(Map.Capacity() != OldCapacity)
+            {
+                CheckAligned(Map);
+                Resizes += 1;
+            }
+        }
+
+        for(int Index = 0; Index < 1900; ++Index)
+        {
+            const int64_t OldCapacity = Map.Capacity();
+            SLOTMAP_CHECK(Map.Remove(Handles[Index]));
+
+            if(Map.Capacity() != OldCapacity)
+            {
+                CheckAligned(Map);
+                Resizes += 1;
+            }
+        }
+
+        SLOTMAP_CHECK(Resizes > 2);
+
+        Map.ShrinkToFit();
+        CheckAligned(Map);
+        SLOTMAP_CHECK(SlotMapTestValue(Map[int64_t(0)]) >= 1900);
+
+        if constexpr(std::is_trivially_copyable_v<ItemT>)
+        {
+            std::vector<char> Data;
+            Map.Serialize([&Data](const void* Bytes, size_t Size) { Data.insert(Data.end(), static_cast<const char*>(Bytes), static_cast<const char*>(Bytes) + Size); });
+
+            //into an empty map and into one that already holds items in a differently sized allocation
+            for(int Filled : {0, 700})
+            {
+                MapT Copy;
+
+                for(int Index = 0; Index < Filled; ++Index)
+                {
+                    Copy.Add(SlotMapTestItem<ItemT>(Index));
+                }
+
+                size_t Offset = 0;
+
+                SLOTMAP_CHECK(Copy.Deserialize([&Data, &Offset](void* Bytes, size_t Size)
+                {
+                    [[unlikely]] if(Size > Data.size() - Offset)
+                    {
+                        return false;
+                    }
+
+                    std::memcpy(Bytes, Data.data() + Offset, Size);
+                    Offset += Size;
+                    return true;
+                }));
+
+                SLOTMAP_CHECK(Copy.Size() == Map.Size());
+                CheckAligned(Copy);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestPmr<int, PmrTraits>();
+    TestPmr<std::string, PmrTraits>();
+    TestPmr<int, PmrMigrationTraits>();
+    TestPmr<std::string, PmrMigrationTraits>();
+
+    //trivially copyable items are resized trough Reallocate, other items are moved but their keys and key offsets still are
+    TestReallocate<int, ReallocatingTraits>(true, true);
+    TestReallocate<std::string, ReallocatingTraits>(false, true);
+
+    //concurrent readers may still use the old arrays, so they are never resized in place
+    TestReallocate<int, ReallocatingConcurrentTraits>(false, false);
+
+    TestAlignment<int, ExactAlignmentTraits>();
+    TestAlignment<int, SmallAlignmentTraits>();
+    TestAlignment<int, WideAlignmentTraits>();
+    TestAlignment<WideItem, ExactAlignmentTraits>();
+    TestAlignment<WideItem, SmallAlignmentTraits>();
+    TestAlignment<WideItem, WideAlignmentTraits>();
+    TestAlignment<std::string, SmallAlignmentTraits>();
+    TestAlignment<std::string, WideAlignmentTraits>();
+
+    return SlotMapTestResult("slotmap_allocator_test");
+}
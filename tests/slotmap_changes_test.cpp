@@ -0,0 +1,268 @@
+/**
+ * checks what CollectChanges reports: removed handles that were alive when the epoch started, added handles that are still alive and
+ * marked or modified items that were alive the whole epoch, each once. covers the single cases by hand and then random operations
+ * against a model that only remembers the live handles at the start of the epoch
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    struct TrackedTraits : SlotMapDefaultTraits
+    {
+        static constexpr bool TrackChanges = true;
+    };
+
+    struct TrackedShiftTraits : TrackedTraits
+    {
+        static constexpr SlotMapRemovalPolicy RemovalPolicy = SlotMapRemovalPolicy::Shift;
+        static constexpr bool CacheGenerations = true;
+    };
+
+    template<typename MapT>
+    struct Collected
+    {
+        using KeyHandle = typename MapT::KeyHandle;
+
+        std::vector<KeyHandle> Added;
+        std::vector<KeyHandle> Removed;
+        std::vector<KeyHandle> Modified;
+
+        explicit Collected(MapT& Map)
+        {
+            bool SawOther = false;
+
+            Map.CollectChanges([&](SlotMapChange Change, KeyHandle Handle, const auto* Item)
+            {
+                if(Change == SlotMapChange::Removed)
+                {
+                    SLOTMAP_CHECK(Item == nullptr && !SawOther); //removals come first
+                    Removed.push_back(Handle);
+                    return;
+                }
+
+                SawOther = true;
+                SLOTMAP_CHECK(Item != nullptr && Item == std::as_const(Map)[Handle]);
+                (Change == SlotMapChange::Added ? Added : Modified).push_back(Handle);
+            });
+        }
+
+        bool IsEmpty() const
+        {
+            return Added.empty() && Removed.empty() && Modified.empty();
+        }
+    };
+
+    using MapT = SlotMap<std::string, TrackedTraits>;
+    using KeyHandle = MapT::KeyHandle;
+
+    void TestSingleCases()
+    {
+        MapT Map;
+        const KeyHandle Kept = Map.Add("kept");
+        Collected<MapT> First(Map);
+        SLOTMAP_CHECK(First.Added == std::vector{Kept} && First.Removed.empty() && First.Modified.empty());
+        SLOTMAP_CHECK(Collected<MapT>(Map).IsEmpty());
+
+        //added and removed in the same epoch, nobody saw it
+        Map.Remove(Map.Add("short"));
+        SLOTMAP_CHECK(Collected<MapT>(Map).IsEmpty());
+
+        //MarkDirty reports the item once, however often it is marked
+        SLOTMAP_CHECK(Map.MarkDirty(Kept) && Map.MarkDirty(Kept));
+        SLOTMAP_CHECK(Collected<MapT>(Map).Modified == std::vector{Kept});
+
+        //Modify marks as well
+        SLOTMAP_CHECK(Map.Modify(Kept, [](std::string& Item) { Item += "!"; }));
+        SLOTMAP_CHECK(Collected<MapT>(Map).Modified == std::vector{Kept});
+
+        //removed then re-added under the same key: the old handle is removed and the new one added
+        const KeyHandle Old = Map.Add("old");
+        Collected<MapT>{Map};
+
+        SLOTMAP_CHECK(Map.Remove(Old));
+        KeyHandle New = Map.Add("new");
+
+        while(New.Index != Old.Index) //the freelist is FIFO, cycle until the key comes back
+        {
+            SLOTMAP_CHECK(Map.Remove(New));
+            New = Map.Add("new");
+        }
+
+        Collected<MapT> Reused(Map);
+        SLOTMAP_CHECK(Reused.Removed == std::vector{Old} && Reused.Added == std::vector{New} && Reused.Modified.empty());
+
+        //a marked item is reported removed right away, Flush moving the others does not report them
+        const KeyHandle Marked = Map.Add("marked");
+        const KeyHandle Behind = Map.Add("behind");
+        Collected<MapT>{Map};
+
+        SLOTMAP_CHECK(Map.MarkRemoved(Marked));
+        SLOTMAP_CHECK(Map.MarkDirty(Behind));
+        Map.Flush();
+
+        Collected<MapT> Flushed(Map);
+        SLOTMAP_CHECK(Flushed.Removed == std::vector{Marked} && Flushed.Modified == std::vector{Behind} && Flushed.Added.empty());
+        SLOTMAP_CHECK(Collected<MapT>(Map).IsEmpty());
+
+        //Clear reports every live handle removed except the ones nobody saw
+        const KeyHandle Unseen = Map.Add("unseen");
+        SLOTMAP_CHECK(Map.MarkDirty(Kept));
+        Map.Clear();
+
+        Collected<MapT> Cleared(Map);
+        const std::unordered_set<KeyHandle> ClearedSet(Cleared.Removed.begin(), Cleared.Removed.end());
+
+        SLOTMAP_CHECK(ClearedSet == (std::unordered_set<KeyHandle>{Kept, New, Behind}));
+        SLOTMAP_CHECK(std::ssize(Cleared.Removed) == 3 && !ClearedSet.contains(Unseen));
+        SLOTMAP_CHECK(Cleared.Added.empty() && Cleared.Modified.empty());
+    }
+
+    //random operations, after every CollectChanges the model knows exactly what had to be reported
+    template<typename Traits>
+    class ModelTest : public SlotMapModelTest<ModelTest<Traits>, SlotMap<std::string, Traits>>
+    {
+        using MapT = SlotMap<std::string, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+        using Base = SlotMapModelTest<ModelTest, MapT>;
+        using Base::Map, Base::Model, Base::Live, Base::NextValue, Base::Pick, Base::Forget;
+
+    public:
+        using Base::Base;
+
+        void Step()
+        {
+            const int64_t Operation = Pick(100);
+
+            if(Operation < 35 || Live.empty())
+            {
+                const int Value = NextValue++;
+                this->Track(Map.Add(SlotMapTestItem<std::string>(Value)), Value);
+            }
+            else if(Operation < 50)
+            {
+                this->RemoveRandom();
+            }
+            else if(Operation < 58)
+            {
+                const int64_t Position = Pick(std::ssize(Live));
+                SLOTMAP_CHECK(Map.MarkRemoved(Live[Position]));
+                Forget(Position);
+            }
+            else if(Operation < 62)
+            {
+                Map.Flush();
+            }
+            else if(Operation < 75)
+            {
+                const KeyHandle Handle = Live[Pick(std::ssize(Live))];
+                SLOTMAP_CHECK(Map.MarkDirty(Handle));
+                Dirty.insert(Handle);
+            }
+            else if(Operation < 85)
+            {
+                const KeyHandle Handle = Live[Pick(std::ssize(Live))];
+                const int Value = NextValue++;
+
+                SLOTMAP_CHECK(Map.Modify(Handle, [Value](std::string& Item) { Item = SlotMapTestItem<std::string>(Value); }));
+                Model[Handle] = Value;
+                Dirty.insert(Handle);
+            }
+            else if(Operation < 87)
+            {
+                Map.Clear(Pick(2) == 0);
+                this->ForgetAll();
+            }
+            else
+            {
+                Collect();
+            }
+        }
+
+        void CheckAll()
+        {
+            for(const auto& [Handle, Value] : Model)
+            {
+                const std::string* Item = Map[Handle];
+                SLOTMAP_CHECK(Item != nullptr && SlotMapTestValue(*Item) == Value);
+            }
+
+            this->CheckStale();
+        }
+
+    private:
+        std::unordered_set<KeyHandle> EpochStart; //live handles when the epoch started
+        std::unordered_set<KeyHandle> Dirty;
+
+        void Collect()
+        {
+            Collected<MapT> Changes(Map);
+
+            std::unordered_set<KeyHandle> Current;
+
+            for(const auto& [Handle, Value] : Model)
+            {
+                Current.insert(Handle);
+            }
+
+            std::vector<KeyHandle> Added;
+            std::vector<KeyHandle> Removed;
+            std::vector<KeyHandle> Modified;
+
+            for(KeyHandle Handle : Current)
+            {
+                if(!EpochStart.contains(Handle))
+                {
+                    Added.push_back(Handle);
+                }
+                else if(Dirty.contains(Handle))
+                {
+                    Modified.push_back(Handle);
+                }
+            }
+
+            for(KeyHandle Handle : EpochStart)
+            {
+                if(!Current.contains(Handle))
+                {
+                    Removed.push_back(Handle);
+                }
+            }
+
+            CheckSame(Changes.Added, Added);
+            CheckSame(Changes.Removed, Removed);
+            CheckSame(Changes.Modified, Modified);
+
+            EpochStart = std::move(Current);
+            Dirty.clear();
+        }
+
+        //same handles, each reported once
+        static void CheckSame(std::vector<KeyHandle> Reported, std::vector<KeyHandle> Expected)
+        {
+            std::sort(Reported.begin(), Reported.end());
+            std::sort(Expected.begin(), Expected.end());
+            SLOTMAP_CHECK(Reported == Expected);
+        }
+    };
+}
+
+int main()
+{
+    TestSingleCases();
+
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        ModelTest<TrackedTraits>(Seed).Run(8000);
+        ModelTest<TrackedShiftTraits>(Seed).Run(8000);
+    }
+
+    return SlotMapTestResult("slotmap_changes_test");
+}
@@ -0,0 +1,221 @@
+/**
+ * fills a SlotMap from several producer threads trough ClaimConcurrentBlock and ConcurrentEmplace while some constructors throw and
+ * some blocks are dropped half filled, then checks that EndConcurrentAdd publishes exactly the constructed items under the handles
+ * the producers got and that the keys of every unused slot went back to the freelist
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Item
+    {
+        std::string Text; //long enough to live on the heap so a lost or doubled destructor shows up under the sanitizers
+        int Producer;
+        int Value;
+
+        Item(int InProducer, int InValue, bool Throw)
+            : Text(std::string(24, '#') + std::to_string(InValue))
+            , Producer(InProducer)
+            , Value(InValue)
+        {
+            [[unlikely]] if(Throw)
+            {
+                throw std::runtime_error("item");
+            }
+        }
+    };
+
+    struct Produced
+    {
+        SlotMap<Item>::KeyHandle Handle;
+        int Value;
+    };
+
+    template<typename Traits>
+    void TestProducers(uint32_t Seed, int64_t MaxCount)
+    {
+        using MapT = SlotMap<Item, Traits>;
+
+        MapT Map;
+        std::vector<typename MapT::KeyHandle> Existing;
+
+        for(int Index = 0; Index < 300; ++Index)
+        {
+            Existing.push_back(Map.Emplace(-1, Index, false));
+        }
+
+        for(int Index = 0; Index < 300; Index += 3)
+        {
+            SLOTMAP_CHECK(Map.Remove(Existing[Index]));
+        }
+
+        const int64_t SizeBefore = Map.Size();
+
+        constexpr int ProducerCount = 4;
+        std::vector<std::vector<Produced>> Handles(ProducerCount);
+
+        Map.BeginConcurrentAdd(MaxCount);
+        const int64_t FreeKeysBefore = Map.FreeKeys() + MaxCount; //the keys of all MaxCount slots are taken until EndConcurrentAdd
+
+        std::vector<std::thread> Producers;
+
+        for(int Producer = 0; Producer < ProducerCount; ++Producer)
+        {
+            Producers.emplace_back([&Map, &Handles, Producer, Seed]
+            {
+                std::mt19937 Random(Seed * 31 + Producer);
+                int Value = Producer * 1000000;
+
+                for(;;)
+                {
+                    auto Block = Map.ClaimConcurrentBlock(1 + Random() % 40);
+
+                    if(Block.Size() == 0)
+                    {
+                        break;
+                    }
+
+                    const int64_t Stop = Random() % 4 == 0 ? static_cast<int64_t>(Random() % Block.Size()) : Block.Size(); //drop some blocks early
+
+                    try
+                    {
+                        while(Block.Remaining() > Block.Size() - Stop)
+                        {
+                            const bool Throw = Random() % 16 == 0;
+                            const auto Handle = Block.Emplace(Producer, Value, Throw);
+                            Handles[Producer].push_back({Handle, Value});
+                            Value += 1;
+                        }
+                    }
+                    catch(const std::runtime_error&)
+                    {
+                        //the block is dropped with the slot whose constructor threw and every slot after it
+                    }
+                }
+
+                for(int Extra = 0; Extra < 4; ++Extra)
+                {
+                    SLOTMAP_CHECK(Map.ConcurrentEmplace(Producer, 0, false) == MapT::NullHandle);
+                }
+            });
+        }
+
+        for(std::thread& Producer : Producers)
+        {
+            Producer.join();
+        }
+
+        Map.EndConcurrentAdd();
+
+        int64_t ProducedCount = 0;
+
+        for(int Producer = 0; Producer < ProducerCount; ++Producer)
+        {
+            for(const Produced& Entry : Handles[Producer])
+            {
+                const Item* Stored = Map[Entry.Handle];
+                SLOTMAP_CHECK(Stored != nullptr && Stored->Producer == Producer && Stored->Value == Entry.Value);
+                SLOTMAP_CHECK(Stored != nullptr && Stored->Text == std::string(24, '#') + std::to_string(Entry.Value));
+            }
+
+            ProducedCount += std::ssize(Handles[Producer]);
+        }
+
+        SLOTMAP_CHECK(Map.Size() == SizeBefore + ProducedCount);
+        SLOTMAP_CHECK(Map.FreeKeys() == FreeKeysBefore - ProducedCount); //the keys of unclaimed and unfilled slots are free again
+
+        for(int Index = 0; Index < 300; ++Index)
+        {
+            SLOTMAP_CHECK(Map.IsValidHandle(Existing[Index]) == (Index % 3 != 0));
+        }
+
+        //every item is reachable trough its key exactly once
+        int64_t EntryCount = 0;
+
+        for(auto [Handle, Stored] : Map.Entries())
+        {
+            SLOTMAP_CHECK(Map[Handle] == &Stored);
+            EntryCount += 1;
+        }
+
+        SLOTMAP_CHECK(EntryCount == Map.Size());
+
+        //the freelist still works after the returned keys
+        std::vector<typename MapT::KeyHandle> Added;
+
+        for(int Index = 0; Index < 2000; ++Index)
+        {
+            Added.push_back(Map.Emplace(-2, Index, false));
+        }
+
+        for(int Index = 0; Index < 2000; ++Index)
+        {
+            SLOTMAP_CHECK(Map[Added[Index]] != nullptr && Map[Added[Index]]->Value == Index);
+        }
+    }
+
+    //a block dropped without a single Emplace leaves nothing behind
+    void TestEmptyBlocks()
+    {
+        SlotMap<Item> Map;
+        Map.Emplace(0, 0, false);
+
+        Map.BeginConcurrentAdd(64);
+        const int64_t FreeKeysBefore = Map.FreeKeys() + 64;
+
+        {
+            auto Dropped = Map.ClaimConcurrentBlock(10);
+            SLOTMAP_CHECK(Dropped.Size() == 10);
+        }
+
+        auto Filled = Map.ClaimConcurrentBlock(5);
+
+        while(Filled.Remaining() != 0)
+        {
+            Filled.Emplace(1, 1, false);
+        }
+
+        Map.EndConcurrentAdd();
+
+        SLOTMAP_CHECK(Map.Size() == 6);
+        SLOTMAP_CHECK(Map.FreeKeys() == FreeKeysBefore - 5);
+
+        for(const Item& Stored : Map)
+        {
+            SLOTMAP_CHECK(Stored.Text.size() > 24);
+        }
+    }
+
+    struct CachedTraits : SlotMapDefaultTraits
+    {
+        static constexpr bool CacheGenerations = true;
+    };
+
+    struct TrackedTraits : SlotMapDefaultTraits
+    {
+        static constexpr bool TrackChanges = true;
+    };
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 4; ++Seed)
+    {
+        TestProducers<SlotMapDefaultTraits>(Seed, 4000);
+        TestProducers<SlotMapDefaultTraits>(Seed, 60);
+        TestProducers<CachedTraits>(Seed, 4000);
+        TestProducers<TrackedTraits>(Seed, 4000);
+    }
+
+    TestEmptyBlocks();
+
+    return SlotMapTestResult("slotmap_concurrent_add_test");
+}
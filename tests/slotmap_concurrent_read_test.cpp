@@ -0,0 +1,207 @@
+/**
+ * runs reader threads trough ConcurrentRead and ConcurrentIsValidHandle while the writer adds, removes, resizes and rewrites items trough Modify.
+ * every item repeats one number in all of its words, so a copy the writer was halfway trough shows up as mixed words
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    //Words[0] is the handle the item was added under, every other word holds the same version
+    struct Item
+    {
+        uint64_t Words[8];
+    };
+
+    struct ReadTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16; //small steps so resizes happen often
+        static constexpr bool ConcurrentReads = true;
+    };
+
+    template<typename Traits>
+    void TestReaders(uint32_t Seed)
+    {
+        using MapT = SlotMap<Item, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+
+        MapT Map;
+
+        auto MakeItem = [](KeyHandle Handle, uint64_t Version)
+        {
+            Item Made;
+            Made.Words[0] = Handle.ToBits();
+            std::fill(Made.Words + 1, Made.Words + 8, Version);
+            return Made;
+        };
+
+        //the first item of a handle has to be added with the bits of the handle it will get
+        auto AddItem = [&Map, &MakeItem]()
+        {
+            const KeyHandle Handle = Map.Add(Item{});
+            Map.Modify(Handle, [&](Item& Added) { Added = MakeItem(Handle, 0); });
+            return Handle;
+        };
+
+        //Pinned handles stay valid and Dead ones invalid for the whole test, Churn slots are swapped by the writer while readers look.
+        //the first HotCount pinned items are rewritten most of the time and read half of the time, so rewrites and reads overlap
+        constexpr size_t HotCount = 4;
+        std::vector<KeyHandle> Pinned;
+        std::vector<KeyHandle> Dead;
+
+        for(int Index = 0; Index < 200; ++Index)
+        {
+            Pinned.push_back(AddItem());
+            Dead.push_back(AddItem());
+        }
+
+        for(KeyHandle Handle : Dead)
+        {
+            Map.Remove(Handle);
+        }
+
+        constexpr int ChurnCount = 256;
+        std::vector<std::atomic<uint64_t>> Churn(ChurnCount);
+
+        for(std::atomic<uint64_t>& Slot : Churn)
+        {
+            Slot.store(AddItem().ToBits(), std::memory_order_relaxed);
+        }
+
+        std::atomic<bool> Done{false};
+        std::atomic<int64_t> ReadCount{0};
+
+        auto CheckCopy = [](const Item& Copy, KeyHandle Handle)
+        {
+            SLOTMAP_CHECK(Copy.Words[0] == Handle.ToBits());
+
+            for(int Word = 2; Word < 8; ++Word)
+            {
+                SLOTMAP_CHECK(Copy.Words[Word] == Copy.Words[1]);
+            }
+        };
+
+        auto Reader = [&](uint32_t ReaderSeed)
+        {
+            std::mt19937 Random(ReaderSeed);
+            int64_t Reads = 0;
+
+            while(!Done.load(std::memory_order_relaxed) || Reads < 1000)
+            {
+                Item Copy;
+
+                const KeyHandle PinnedHandle = Pinned[Random() % (Random() % 2 == 0 ? HotCount : Pinned.size())];
+                SLOTMAP_CHECK(Map.ConcurrentIsValidHandle(PinnedHandle));
+                SLOTMAP_CHECK(Map.ConcurrentRead(PinnedHandle, Copy));
+                CheckCopy(Copy, PinnedHandle);
+
+                const KeyHandle DeadHandle = Dead[Random() % Dead.size()];
+                SLOTMAP_CHECK(!Map.ConcurrentIsValidHandle(DeadHandle));
+                SLOTMAP_CHECK(!Map.ConcurrentRead(DeadHandle, Copy));
+
+                //may have been removed since it was loaded, but a copy that is returned belongs to it
+                const KeyHandle ChurnHandle = KeyHandle::FromBits(Churn[Random() % ChurnCount].load(std::memory_order_relaxed));
+
+                if(Map.ConcurrentRead(ChurnHandle, Copy))
+                {
+                    CheckCopy(Copy, ChurnHandle);
+                }
+
+                SLOTMAP_CHECK(!Map.ConcurrentRead(MapT::NullHandle, Copy));
+                Reads += 1;
+            }
+
+            ReadCount.fetch_add(Reads, std::memory_order_relaxed);
+        };
+
+        std::vector<std::thread> Readers;
+
+        for(uint32_t Index = 0; Index < 3; ++Index)
+        {
+            Readers.emplace_back(Reader, Seed * 17 + Index);
+        }
+
+        std::mt19937 Random(Seed);
+
+        for(int Step = 0; Step < 20000; ++Step)
+        {
+            const uint32_t Operation = Random() % 16;
+
+            if(Operation < 8) //replace a churn item, adding may grow the arrays
+            {
+                std::atomic<uint64_t>& Slot = Churn[Random() % ChurnCount];
+                const KeyHandle Old = KeyHandle::FromBits(Slot.load(std::memory_order_relaxed));
+
+                Slot.store(AddItem().ToBits(), std::memory_order_relaxed);
+                SLOTMAP_CHECK(Map.Remove(Old));
+            }
+            else if(Operation < 14) //rewrite every word of an item, readers must see the old or the new version
+            {
+                const uint32_t Target = Random() % 4;
+                const KeyHandle Handle = Target == 0 ? KeyHandle::FromBits(Churn[Random() % ChurnCount].load(std::memory_order_relaxed)) : Target == 1 ? Pinned[Random() % Pinned.size()] : Pinned[Random() % HotCount];
+                const uint64_t Version = Step;
+
+                SLOTMAP_CHECK(Map.Modify(Handle, [Version](Item& Rewritten)
+                {
+                    for(int Word = 1; Word < 8; ++Word)
+                    {
+                        //a slow update, so a reader that is not held off by the write section copies a half written item
+                        std::atomic_ref(Rewritten.Words[Word]).store(Version, std::memory_order_relaxed);
+
+                        for(int Spin = 0; Spin < 64; ++Spin)
+                        {
+                            std::atomic_signal_fence(std::memory_order_seq_cst);
+                        }
+                    }
+                }));
+            }
+            else if(Operation < 15)
+            {
+                Map.Reserve(Map.Capacity() + 64); //a resize retires the arrays readers may still be copying from
+            }
+            else
+            {
+                Map.ShrinkToFit();
+            }
+        }
+
+        Done.store(true, std::memory_order_relaxed);
+
+        for(std::thread& Thread : Readers)
+        {
+            Thread.join();
+        }
+
+        SLOTMAP_CHECK(ReadCount.load() >= 3000);
+
+        for(KeyHandle Handle : Pinned)
+        {
+            SLOTMAP_CHECK(Map[Handle] != nullptr && Map[Handle]->Words[0] == Handle.ToBits());
+        }
+    }
+
+    struct SplitReadTraits : ReadTraits
+    {
+        using KeyStorageT = uint32_t;
+        static constexpr int64_t IndexBits = 20;
+        static constexpr int64_t IdBits = 12;
+        static constexpr bool SplitGenerations = true;
+    };
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        TestReaders<ReadTraits>(Seed);
+        TestReaders<SplitReadTraits>(Seed);
+    }
+
+    return SlotMapTestResult("slotmap_concurrent_read_test");
+}
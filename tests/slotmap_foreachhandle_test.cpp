@@ -0,0 +1,136 @@
+/**
+ * feeds ForEachHandle spans of valid, stale, null and out of range handles with duplicates, shorter and longer than the prefetch distance,
+ * and checks that exactly the valid handles are visited, in the order of the span and with their own items
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    template<typename ItemT, typename Traits>
+    void TestForEachHandle(uint32_t Seed)
+    {
+        using MapT = SlotMap<ItemT, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+
+        std::mt19937 Random(Seed);
+
+        MapT Map;
+        std::vector<KeyHandle> Valid;
+        std::vector<KeyHandle> Stale;
+
+        for(int Index = 0; Index < 2000; ++Index)
+        {
+            Valid.push_back(Map.Add(SlotMapTestItem<ItemT>(Index)));
+        }
+
+        for(int Index = 0; Index < 600; ++Index)
+        {
+            const size_t Position = Random() % Valid.size();
+            SLOTMAP_CHECK(Random() % 2 == 0 ? Map.Remove(Valid[Position]) : Map.MarkRemoved(Valid[Position]));
+
+            Stale.push_back(Valid[Position]);
+            Valid[Position] = Valid.back();
+            Valid.pop_back();
+        }
+
+        //an index past every key, it must not even be prefetched from
+        const KeyHandle OutOfRange = KeyHandle{.Index = static_cast<typename Traits::KeyStorageT>(Map.KeyCapacity() + 5), .ID = 1};
+
+        for(int64_t Length : {0, 1, 7, 8, 9, 40, 1000})
+        {
+            std::vector<KeyHandle> Handles;
+            std::vector<KeyHandle> Expected;
+
+            for(int64_t Index = 0; Index < Length; ++Index)
+            {
+                const uint32_t Kind = Random() % 8;
+
+                if(Kind < 4) //valid, sometimes twice in a row
+                {
+                    const KeyHandle Handle = Valid[Random() % Valid.size()];
+                    const int Repeat = Kind == 0 ? 2 : 1;
+
+                    for(int Copy = 0; Copy < Repeat; ++Copy)
+                    {
+                        Handles.push_back(Handle);
+                        Expected.push_back(Handle);
+                    }
+                }
+                else if(Kind < 6)
+                {
+                    Handles.push_back(Stale[Random() % Stale.size()]);
+                }
+                else if(Kind < 7)
+                {
+                    Handles.push_back(MapT::NullHandle);
+                }
+                else
+                {
+                    Handles.push_back(OutOfRange);
+                }
+            }
+
+            //with the handle the order can be checked directly
+            size_t Visited = 0;
+
+            Map.ForEachHandle(Handles, [&](ItemT& Item, KeyHandle Handle)
+            {
+                SLOTMAP_CHECK(Visited < Expected.size() && Handle == Expected[Visited]);
+                SLOTMAP_CHECK(&Item == Map[Handle]);
+                Visited += 1;
+            });
+
+            SLOTMAP_CHECK(Visited == Expected.size());
+
+            //without the handle on a const map, the items come in the same order
+            std::vector<const ItemT*> Items;
+            std::as_const(Map).ForEachHandle(Handles, [&Items](const ItemT& Item) { Items.push_back(&Item); });
+
+            SLOTMAP_CHECK(Items.size() == Expected.size());
+
+            for(size_t Index = 0; Index < Items.size() && Index < Expected.size(); ++Index)
+            {
+                SLOTMAP_CHECK(Items[Index] == std::as_const(Map)[Expected[Index]]);
+            }
+        }
+    }
+
+    struct NoPrefetchTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t PrefetchDistance = 0;
+    };
+
+    struct FarPrefetchTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t PrefetchDistance = 64;
+    };
+
+    struct SplitGenerationTraits : SlotMapDefaultTraits
+    {
+        using KeyStorageT = uint32_t;
+        static constexpr int64_t IndexBits = 20;
+        static constexpr int64_t IdBits = 12;
+        static constexpr bool SplitGenerations = true;
+        static constexpr int64_t PrefetchDistance = 8;
+    };
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        TestForEachHandle<int, SlotMapDefaultTraits>(Seed);
+        TestForEachHandle<std::string, SlotMapDefaultTraits>(Seed);
+        TestForEachHandle<int, NoPrefetchTraits>(Seed);
+        TestForEachHandle<int, FarPrefetchTraits>(Seed);
+        TestForEachHandle<std::string, SplitGenerationTraits>(Seed);
+    }
+
+    return SlotMapTestResult("slotmap_foreachhandle_test");
+}
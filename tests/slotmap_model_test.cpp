@@ -0,0 +1,588 @@
+/**
+ * runs the same random operations on a SlotMap and on an std::unordered_map from handles to values for every trait configuration
+ * and checks after each step that both agree: live handles find their value, removed handles stay invalid, ValidateMask matches IsValidHandle
+ * and iteration sees every live item once.
+ * also covers an AddRange generator that throws, how Add and Emplace construct items, how handles compare and hash,
+ * the resize callback of the stats and AsSpan
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <algorithm>
+#include <compare>
+#include <concepts>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    template<typename ItemT, typename Traits>
+    class ModelTest : public SlotMapModelTest<ModelTest<ItemT, Traits>, SlotMap<ItemT, Traits>>
+    {
+        using Base = SlotMapModelTest<ModelTest, SlotMap<ItemT, Traits>>;
+        using MapT = SlotMap<ItemT, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+        using Base::Map, Base::Model, Base::Live, Base::Stale, Base::NextValue, Base::Pick, Base::Forget;
+
+    public:
+        using Base::Base;
+
+        void Step()
+        {
+            const int64_t Operation = Pick(100);
+
+            if(Operation < 40 || Live.empty())
+            {
+                const int Value = NextValue++;
+                this->Track(Map.Add(SlotMapTestItem<ItemT>(Value)), Value);
+            }
+            else if(Operation < 55)
+            {
+                this->RemoveRandom();
+            }
+            else if(Operation < 62)
+            {
+                const int64_t Position = Pick(std::ssize(Live));
+                SLOTMAP_CHECK(Map.MarkRemoved(Live[Position]));
+                Forget(Position);
+            }
+            else if(Operation < 65)
+            {
+                Map.Flush();
+                SLOTMAP_CHECK(Map.PendingRemovals() == 0);
+            }
+            else if(Operation < 78) //overwrite a value trough its handle
+            {
+                const KeyHandle Handle = Live[Pick(std::ssize(Live))];
+                ItemT* Item = Map[Handle];
+
+                SLOTMAP_CHECK(Item != nullptr && SlotMapTestValue(*Item) == Model[Handle]);
+
+                if(Item)
+                {
+                    const int Value = NextValue++;
+                    *Item = SlotMapTestItem<ItemT>(Value);
+                    Model[Handle] = Value;
+                }
+            }
+            else if(Operation < 82 && !Stale.empty())
+            {
+                const KeyHandle Handle = Stale[Pick(std::ssize(Stale))];
+                SLOTMAP_CHECK(!Map.Remove(Handle));
+                SLOTMAP_CHECK(!Map.MarkRemoved(Handle));
+            }
+            else if(Operation < 85) //live, stale and duplicate handles in one batch
+            {
+                std::vector<KeyHandle> Batch;
+                std::unordered_map<KeyHandle, int> Removed;
+
+                for(int64_t Count = Pick(8); Count > 0 && !Live.empty(); --Count)
+                {
+                    const int64_t Position = Pick(std::ssize(Live));
+                    Batch.push_back(Live[Position]);
+                    Batch.push_back(Live[Position]);
+                    Removed.emplace(Live[Position], 0);
+                    Forget(Position);
+                }
+
+                if(!Stale.empty())
+                {
+                    Batch.push_back(Stale[Pick(std::ssize(Stale))]);
+                }
+
+                SLOTMAP_CHECK(Map.RemoveBatch(Batch) == std::ssize(Removed));
+            }
+            else if(Operation < 88)
+            {
+                const int64_t Count = Pick(40);
+                std::vector<KeyHandle> Handles(Count);
+
+                const int First = NextValue;
+                Map.AddRange(Count, [First](int64_t Index) { return SlotMapTestItem<ItemT>(First + static_cast<int>(Index)); }, Handles);
+                NextValue += static_cast<int>(Count);
+
+                for(int64_t Index = 0; Index < Count; ++Index)
+                {
+                    this->Track(Handles[Index], First + static_cast<int>(Index));
+                }
+            }
+            else if(Operation < 91)
+            {
+                Map.Reserve(Map.Size() + Pick(200));
+            }
+            else if(Operation < 93)
+            {
+                Map.ShrinkToFit();
+            }
+            else if(Operation < 97)
+            {
+                Map.StepMigration(Pick(16));
+            }
+            else if(Operation < 98)
+            {
+                Map.Clear(Pick(2) == 0);
+
+                this->ForgetAll();
+            }
+            else if constexpr(Traits::TrackChanges)
+            {
+                Map.CollectChanges([](auto...) {});
+            }
+        }
+
+        void CheckAll()
+        {
+            SLOTMAP_CHECK(Map.Size() - Map.PendingRemovals() == std::ssize(Model));
+            SLOTMAP_CHECK(Map.Size() <= Map.Capacity());
+
+            for(const auto& [Handle, Value] : Model)
+            {
+                SLOTMAP_CHECK(Map.IsValidHandle(Handle));
+
+                const ItemT* Item = std::as_const(Map)[Handle];
+                SLOTMAP_CHECK(Item != nullptr && SlotMapTestValue(*Item) == Value);
+            }
+
+            for(KeyHandle Handle : Stale)
+            {
+                SLOTMAP_CHECK(!Map.IsValidHandle(Handle));
+                SLOTMAP_CHECK(std::as_const(Map)[Handle] == nullptr);
+            }
+
+            //Entries has to see every live item once with its own handle, migrating or not
+            int64_t EntryCount = 0;
+
+            for(auto [Handle, Item] : std::as_const(Map).Entries())
+            {
+                auto Found = Model.find(Handle);
+                SLOTMAP_CHECK(Found != Model.end() && Found->second == SlotMapTestValue(Item));
+                EntryCount += 1;
+            }
+
+            SLOTMAP_CHECK(EntryCount == std::ssize(Model));
+
+            std::vector<KeyHandle> Handles = Live;
+            Handles.insert(Handles.end(), Stale.begin(), Stale.begin() + std::min<int64_t>(std::ssize(Stale), 64));
+
+            std::vector<const ItemT*> Resolved(Handles.size());
+            SLOTMAP_CHECK(std::as_const(Map).Resolve(Handles, Resolved) == std::ssize(Live));
+
+            for(size_t Index = 0; Index < Handles.size(); ++Index)
+            {
+                SLOTMAP_CHECK((Resolved[Index] != nullptr) == (Index < Live.size()));
+            }
+
+            //live and stale handles interleaved, with a count that leaves a partial chunk for the vector paths
+            std::vector<KeyHandle> Mixed;
+
+            for(size_t Index = 0; Index < std::max(Live.size(), Stale.size()); ++Index)
+            {
+                if(Index < Live.size())
+                {
+                    Mixed.push_back(Live[Index]);
+                }
+
+                if(Index < Stale.size() && Index % 3 == 0)
+                {
+                    Mixed.push_back(Stale[Index]);
+                }
+            }
+
+            if(Mixed.size() % 8 == 0)
+            {
+                Mixed.push_back(MapT::NullHandle);
+            }
+
+            std::vector<uint64_t> Mask((Mixed.size() + 63) / 64, ~uint64_t(0)); //every word has to be overwritten
+            int64_t ValidCount = 0;
+
+            for(KeyHandle Handle : Mixed)
+            {
+                ValidCount += Map.IsValidHandle(Handle);
+            }
+
+            SLOTMAP_CHECK(std::as_const(Map).ValidateMask(Mixed, Mask) == ValidCount);
+
+            for(size_t Index = 0; Index < Mixed.size(); ++Index)
+            {
+                SLOTMAP_CHECK(((Mask[Index / 64] >> (Index % 64)) & 1) == Map.IsValidHandle(Mixed[Index]));
+            }
+        }
+    };
+
+    struct ShiftTraits : SlotMapDefaultTraits
+    {
+        static constexpr SlotMapRemovalPolicy RemovalPolicy = SlotMapRemovalPolicy::Shift;
+    };
+
+    //few ID bits so keys retire during the test
+    struct SplitGenerationTraits : SlotMapDefaultTraits
+    {
+        using KeyStorageT = uint32_t;
+        static constexpr int64_t IndexBits = 24;
+        static constexpr int64_t IdBits = 3;
+        static constexpr int64_t MinFreeKeys = 4;
+        static constexpr bool SplitGenerations = true;
+    };
+
+    struct CacheGenerationTraits : SlotMapDefaultTraits
+    {
+        static constexpr bool CacheGenerations = true;
+        static constexpr bool TrackChanges = true;
+    };
+
+    struct MigrationTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+        static constexpr int64_t MigrationBudget = 2;
+    };
+
+    struct ShiftMigrationTraits : MigrationTraits
+    {
+        static constexpr int64_t MigrationBudget = 1;
+        static constexpr SlotMapRemovalPolicy RemovalPolicy = SlotMapRemovalPolicy::Shift;
+        using StatsT = SlotMapCountingStats;
+    };
+
+    struct GeometricTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 8;
+        static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Geometric;
+        static constexpr double ShrinkThreshold = 0.25;
+        static constexpr int64_t PrefetchDistance = 0;
+    };
+
+    struct ConcurrentReadTraits : SlotMapDefaultTraits
+    {
+        static constexpr bool ConcurrentReads = true;
+        using StatsT = SlotMapCountingStats;
+    };
+
+    struct CountingMigrationTraits : MigrationTraits
+    {
+        using StatsT = SlotMapCountingStats;
+    };
+
+    //a generator throwing half way keeps the items made before, and the stats and the migration account for them like for a shorter range
+    void TestThrowingGenerator()
+    {
+        using MapT = SlotMap<std::string, CountingMigrationTraits>;
+
+        MapT Map;
+        MapT Twin;
+
+        while(!Map.IsMigrating())
+        {
+            Map.Add(SlotMapTestItem<std::string>(0));
+            Twin.Add(SlotMapTestItem<std::string>(0));
+        }
+
+        const int64_t Size = Map.Size();
+        std::vector<MapT::KeyHandle> Handles(10);
+        bool Threw = false;
+
+        try
+        {
+            Map.AddRange(10, [](int64_t Index)
+            {
+                [[unlikely]] if(Index == 6)
+                {
+                    throw std::runtime_error("generator");
+                }
+
+                return SlotMapTestItem<std::string>(static_cast<int>(Index));
+            }, Handles);
+        }
+        catch(const std::runtime_error&)
+        {
+            Threw = true;
+        }
+
+        Twin.AddRange(6, [](int64_t Index) { return SlotMapTestItem<std::string>(static_cast<int>(Index)); });
+
+        SLOTMAP_CHECK(Threw);
+        SLOTMAP_CHECK(Map.Size() == Size + 6 && Map.GetStats().PeakItemCount == Size + 6);
+
+        for(int Index = 0; Index < 6; ++Index)
+        {
+            SLOTMAP_CHECK(Map[Handles[Index]] != nullptr && SlotMapTestValue(*Map[Handles[Index]]) == Index);
+        }
+
+        //the migration moved as many items as for the six that were added
+        int64_t Steps = 0;
+        int64_t TwinSteps = 0;
+
+        while(Map.StepMigration(1))
+        {
+            Steps += 1;
+        }
+
+        while(Twin.StepMigration(1))
+        {
+            TwinSteps += 1;
+        }
+
+        SLOTMAP_CHECK(Steps == TwinSteps);
+
+        //and the map keeps working
+        const MapT::KeyHandle Next = Map.Add(SlotMapTestItem<std::string>(6));
+        SLOTMAP_CHECK(Map[Next] != nullptr && SlotMapTestValue(*Map[Next]) == 6 && Map.Size() == Size + 7);
+    }
+
+    //AsSpan covers the same items in the same order as iterating, items marked for removal included, and finishes a running migration first
+    template<typename Traits>
+    void TestAsSpan()
+    {
+        using MapT = SlotMap<std::string, Traits>;
+
+        MapT Map;
+        std::vector<typename MapT::KeyHandle> Handles;
+
+        for(int Index = 0; Index < 300; ++Index)
+        {
+            Handles.push_back(Map.Add(SlotMapTestItem<std::string>(Index)));
+        }
+
+        for(int Index = 0; Index < 300; Index += 3)
+        {
+            SLOTMAP_CHECK(Index % 2 == 0 ? Map.MarkRemoved(Handles[Index]) : Map.Remove(Handles[Index]));
+        }
+
+        auto CheckSpan = [&Map, &Handles]()
+        {
+            const std::span<std::string> Span = Map.AsSpan();
+            SLOTMAP_CHECK(!Map.IsMigrating());
+            SLOTMAP_CHECK(std::ssize(Span) == Map.Size());
+
+            int64_t Index = 0;
+            int64_t Marked = 0;
+
+            for(std::string& Item : Map)
+            {
+                SLOTMAP_CHECK(Index < std::ssize(Span) && &Item == &Span[Index]);
+                Marked += Map.IsMarkedRemoved(Index);
+                Index += 1;
+            }
+
+            SLOTMAP_CHECK(Index == std::ssize(Span) && Marked == Map.PendingRemovals());
+
+            for(int Number = 0; Number < std::ssize(Handles); ++Number)
+            {
+                const std::string* Item = Map[Handles[Number]];
+                SLOTMAP_CHECK((Number % 3 == 0) == (Item == nullptr));
+                SLOTMAP_CHECK(Item == nullptr || (Item >= Span.data() && Item < Span.data() + Span.size() && SlotMapTestValue(*Item) == Number));
+            }
+
+            if constexpr(Traits::MigrationBudget == 0)
+            {
+                const std::span<const std::string> ConstSpan = std::as_const(Map).AsSpan();
+                SLOTMAP_CHECK(ConstSpan.data() == Span.data() && ConstSpan.size() == Span.size());
+            }
+        };
+
+        SLOTMAP_CHECK(Map.PendingRemovals() > 0);
+        CheckSpan();
+
+        //a migration that started with removals still pending
+        Map.Reserve(Map.Capacity() * 4);
+        SLOTMAP_CHECK(Map.IsMigrating() == (Traits::MigrationBudget != 0));
+        CheckSpan();
+
+        Map.Flush();
+        SLOTMAP_CHECK(Map.PendingRemovals() == 0);
+        CheckSpan();
+    }
+
+    struct CountingTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+        using StatsT = SlotMapCountingStats;
+    };
+
+    //every resize reports the capacity the previous one left behind, the counters add up the events and Reset keeps the callback
+    template<typename Traits>
+    void TestResizeCallback()
+    {
+        using MapT = SlotMap<std::string, Traits>;
+
+        MapT Map;
+        int64_t Events = 0;
+        int64_t BytesMoved = 0;
+        int64_t Capacities[2] = {}; //last reported capacity of the items and of the keys
+
+        Map.GetStats().ResizeCallback = [&](const SlotMapResizeEvent& Event)
+        {
+            int64_t& Capacity = Capacities[Event.Target == SlotMapResizeTarget::Keys];
+
+            SLOTMAP_CHECK(Event.OldCapacity == Capacity && Event.NewCapacity != Event.OldCapacity);
+            SLOTMAP_CHECK(Event.BytesMoved >= 0);
+
+            Capacity = Event.NewCapacity;
+            Events += 1;
+            BytesMoved += Event.BytesMoved;
+        };
+
+        auto CheckReported = [&]()
+        {
+            SLOTMAP_CHECK(Capacities[0] == Map.Capacity() && Capacities[1] == Map.KeyCapacity());
+            SLOTMAP_CHECK(Map.GetStats().ItemResizes + Map.GetStats().KeyResizes == Events);
+            SLOTMAP_CHECK(Map.GetStats().BytesMoved == BytesMoved);
+        };
+
+        std::vector<typename MapT::KeyHandle> Handles;
+
+        for(int Index = 0; Index < 300; ++Index)
+        {
+            Handles.push_back(Map.Add(SlotMapTestItem<std::string>(Index)));
+            CheckReported();
+        }
+
+        SLOTMAP_CHECK(Map.GetStats().ItemResizes > 1 && Map.GetStats().KeyResizes > 1);
+
+        for(int Index = 0; Index < 250; ++Index)
+        {
+            SLOTMAP_CHECK(Map.Remove(Handles[Index]));
+            CheckReported();
+        }
+
+        Map.ShrinkToFit();
+        Map.CompleteMigration();
+        CheckReported();
+
+        Map.Reserve(1000);
+        CheckReported();
+
+        //Reset clears the counters but the callback keeps reporting
+        Map.GetStats().Reset();
+        SLOTMAP_CHECK(Map.GetStats().ItemResizes == 0 && Map.GetStats().KeyResizes == 0 && Map.GetStats().BytesMoved == 0);
+        SLOTMAP_CHECK(Map.GetStats().ResizeCallback != nullptr);
+
+        Events = 0;
+        BytesMoved = 0;
+
+        Map.StepMigration(INT64_MAX);
+        Map.Clear();
+        CheckReported();
+        SLOTMAP_CHECK(Events > 0 && Map.Capacity() == 0);
+
+        for(int Index = 0; Index < 40; ++Index)
+        {
+            Map.Add(SlotMapTestItem<std::string>(Index));
+        }
+
+        CheckReported();
+        SLOTMAP_CHECK(Map.GetStats().ItemResizes > 0);
+    }
+
+    struct FirstTag;
+    struct SecondTag;
+
+    struct SmallSplitGenerationTraits : SplitGenerationTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+    };
+
+    using FirstHandle = SlotMap<int, SlotMapDefaultTraits, FirstTag>::KeyHandle;
+    using SecondHandle = SlotMap<int, SlotMapDefaultTraits, SecondTag>::KeyHandle;
+
+    //the tag alone keeps two handle types with the same layout apart, the item type is the default tag
+    static_assert(!std::is_same_v<FirstHandle, SecondHandle>);
+    static_assert(!std::is_convertible_v<FirstHandle, SecondHandle> && !std::is_convertible_v<SecondHandle, FirstHandle>);
+    static_assert(!std::is_constructible_v<SecondHandle, FirstHandle> && !std::is_assignable_v<SecondHandle&, FirstHandle>);
+    static_assert(!std::equality_comparable_with<FirstHandle, SecondHandle> && !std::three_way_comparable_with<FirstHandle, SecondHandle>);
+    static_assert(!std::is_convertible_v<SlotMap<int>::KeyHandle, SlotMap<float>::KeyHandle>);
+    static_assert(std::is_same_v<SlotMap<int>::KeyHandle, SlotMap<int, ShiftTraits>::KeyHandle>);
+    static_assert(std::totally_ordered<FirstHandle> && std::three_way_comparable<FirstHandle, std::strong_ordering>);
+
+    //handles of reused keys so that IDs and indices both vary, ordering and hashing have to agree with equality on every pair
+    void TestHandleOrdering()
+    {
+        using MapT = SlotMap<int, SmallSplitGenerationTraits>;
+        using KeyHandle = MapT::KeyHandle;
+
+        MapT Map;
+        std::vector<KeyHandle> Handles;
+
+        //the FIFO freelist hands every key out again once the others had their turn
+        for(int Index = 0; Index < 600; ++Index)
+        {
+            Handles.push_back(Map.Add(Index));
+
+            if(Index >= 20)
+            {
+                SLOTMAP_CHECK(Map.Remove(Handles[Index - 20]));
+            }
+        }
+
+        SLOTMAP_CHECK(std::ranges::any_of(Handles, [](KeyHandle Handle) { return Handle.ID > 1; }));
+
+        //round trips trough the raw bits add handles equal to earlier ones
+        for(size_t Index = 0; Index < Handles.size(); Index += 7)
+        {
+            Handles.push_back(KeyHandle::FromBits(Handles[Index].ToBits()));
+        }
+
+        Handles.push_back(MapT::NullHandle);
+
+        const std::hash<KeyHandle> Hash;
+
+        for(KeyHandle Left : Handles)
+        {
+            for(KeyHandle Right : Handles)
+            {
+                const std::strong_ordering Order = Left <=> Right;
+
+                SLOTMAP_CHECK((Left == Right) == (Order == 0));
+                SLOTMAP_CHECK((Left != Right) == (Order != 0));
+                SLOTMAP_CHECK((Right <=> Left) == (0 <=> Order));
+                SLOTMAP_CHECK((Left < Right) == (Left.ToBits() < Right.ToBits()));
+                SLOTMAP_CHECK(Left.ID == Right.ID || (Left < Right) == (Left.ID < Right.ID));
+                SLOTMAP_CHECK(Left != Right || Hash(Left) == Hash(Right));
+            }
+        }
+
+        //sorted, equal handles end up next to each other so both containers count the same distinct handles
+        std::sort(Handles.begin(), Handles.end());
+        const std::unordered_set<KeyHandle> Distinct(Handles.begin(), Handles.end());
+        SLOTMAP_CHECK(std::ssize(Distinct) == std::distance(Handles.begin(), std::unique(Handles.begin(), Handles.end())));
+    }
+
+    template<typename ItemT, typename Traits>
+    void RunModel(uint32_t Seed)
+    {
+        ModelTest<ItemT, Traits>(Seed).Run(6000);
+    }
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        RunModel<int, SlotMapDefaultTraits>(Seed);
+        RunModel<std::string, SlotMapDefaultTraits>(Seed);
+        RunModel<int, ShiftTraits>(Seed);
+        RunModel<std::string, ShiftTraits>(Seed);
+        RunModel<int, SplitGenerationTraits>(Seed);
+        RunModel<int, CacheGenerationTraits>(Seed);
+        RunModel<int, MigrationTraits>(Seed);
+        RunModel<std::string, MigrationTraits>(Seed);
+        RunModel<std::string, ShiftMigrationTraits>(Seed);
+        RunModel<int, GeometricTraits>(Seed);
+        RunModel<int, ConcurrentReadTraits>(Seed);
+    }
+
+    TestThrowingGenerator();
+    TestHandleOrdering();
+    TestResizeCallback<CountingTraits>();
+    TestResizeCallback<CountingMigrationTraits>();
+    TestAsSpan<SlotMapDefaultTraits>();
+    TestAsSpan<ShiftTraits>();
+    TestAsSpan<MigrationTraits>();
+    SlotMapTestConstruction<SlotMap<std::vector<int>>>();
+
+    return SlotMapTestResult("slotmap_model_test");
+}
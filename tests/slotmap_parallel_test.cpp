@@ -0,0 +1,200 @@
+/**
+ * runs ParallelForEach with the SlotMapThreadDispatch of slotmapdispatch.hpp and with a custom dispatch over maps with pending removals
+ * and checks that every live item is visited exactly once with its own handle, and that an exception thrown by a task reaches the caller.
+ * the thread dispatch always starts a few threads so workers run even on a machine with one hardware thread
+ */
+
+#include "slotmap.hpp"
+#include "slotmapdispatch.hpp"
+#include "slotmap_test.hpp"
+
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    constexpr SlotMapThreadDispatch Threads{.ThreadCount = 4};
+
+    struct SmallGrainTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t ParallelGrain = 64;
+    };
+
+    template<typename ItemT>
+    void TestVisits(uint32_t Seed)
+    {
+        using MapT = SlotMap<ItemT, SmallGrainTraits>;
+        using KeyHandle = typename MapT::KeyHandle;
+
+        std::mt19937 Random(Seed);
+
+        MapT Map;
+        std::unordered_map<KeyHandle, int> Live;
+
+        for(int Index = 0; Index < 5000; ++Index)
+        {
+            Live.emplace(Map.Add(SlotMapTestItem<ItemT>(Index)), Index);
+        }
+
+        //a few removals stay pending, their items are still in the dense array but must not be visited
+        for(auto Entry = Live.begin(); Entry != Live.end();)
+        {
+            const uint32_t Operation = Random() % 8;
+
+            if(Operation < 2)
+            {
+                SLOTMAP_CHECK(Operation == 0 ? Map.Remove(Entry->first) : Map.MarkRemoved(Entry->first));
+                Entry = Live.erase(Entry);
+            }
+            else
+            {
+                ++Entry;
+            }
+        }
+
+        SLOTMAP_CHECK(Map.PendingRemovals() > 0);
+
+        for(int64_t Grain : {int64_t(1), int64_t(7), SmallGrainTraits::ParallelGrain, int64_t(100000)})
+        {
+            //visits are counted per key, a task owns its items so only the counters are shared
+            std::vector<std::atomic<int>> Visits(Map.KeyCapacity());
+            std::atomic<int> Mismatches{0};
+
+            Map.ParallelForEach([&](ItemT& Item, KeyHandle Handle)
+            {
+                Visits[Handle.Index].fetch_add(1, std::memory_order_relaxed);
+
+                const auto Expected = Live.find(Handle);
+                Mismatches.fetch_add(Expected == Live.end() || SlotMapTestValue(Item) != Expected->second, std::memory_order_relaxed);
+            }, Grain, Threads);
+
+            SLOTMAP_CHECK(Mismatches.load() == 0);
+
+            int64_t VisitCount = 0;
+
+            for(const std::atomic<int>& Count : Visits)
+            {
+                VisitCount += Count.load();
+            }
+
+            SLOTMAP_CHECK(VisitCount == std::ssize(Live));
+
+            for(const auto& [Handle, Value] : Live)
+            {
+                SLOTMAP_CHECK(Visits[Handle.Index].load() == 1);
+            }
+        }
+
+        //without the handle on a const map
+        std::atomic<int64_t> Sum{0};
+        int64_t ExpectedSum = 0;
+
+        for(const auto& [Handle, Value] : Live)
+        {
+            ExpectedSum += Value;
+        }
+
+        std::as_const(Map).ParallelForEach([&Sum](const ItemT& Item) { Sum.fetch_add(SlotMapTestValue(Item), std::memory_order_relaxed); }, SmallGrainTraits::ParallelGrain, Threads);
+        SLOTMAP_CHECK(Sum.load() == ExpectedSum);
+    }
+
+    //a custom dispatch gets one task per Grain items, an empty map or a single task does not dispatch at all
+    void TestCustomDispatch()
+    {
+        SlotMap<int, SmallGrainTraits> Map;
+        int64_t Dispatches = 0;
+        int64_t Tasks = 0;
+
+        auto Serial = [&Dispatches, &Tasks](int64_t TaskCount, auto&& Task)
+        {
+            Dispatches += 1;
+
+            for(int64_t Index = 0; Index < TaskCount; ++Index)
+            {
+                Task(Index);
+                Tasks += 1;
+            }
+        };
+
+        int64_t Visited = 0;
+        Map.ParallelForEach([&Visited](int&) { Visited += 1; }, 10, Serial);
+        SLOTMAP_CHECK(Visited == 0 && Dispatches == 0);
+
+        for(int Index = 0; Index < 95; ++Index)
+        {
+            Map.Add(Index);
+        }
+
+        Map.ParallelForEach([&Visited](int&) { Visited += 1; }, 100, Serial);
+        SLOTMAP_CHECK(Visited == 95 && Dispatches == 0);
+
+        Map.ParallelForEach([&Visited](int& Item) { Item += 1; Visited += 1; }, 10, Serial);
+        SLOTMAP_CHECK(Visited == 190 && Dispatches == 1 && Tasks == 10);
+        SLOTMAP_CHECK(Map[int64_t(0)] == 1 && Map[int64_t(94)] == 95);
+    }
+
+    //the exception of a task is rethrown on the caller once every thread is joined, whether the caller or a worker ran the task
+    void TestThrowingTask()
+    {
+        SlotMap<std::string, SmallGrainTraits> Map;
+
+        for(int Index = 0; Index < 4000; ++Index)
+        {
+            Map.Add(SlotMapTestItem<std::string>(Index));
+        }
+
+        for(int Thrower : {0, 1999, 3999})
+        {
+            std::atomic<int> Visited{0};
+            bool Threw = false;
+
+            try
+            {
+                Map.ParallelForEach([&Visited, Thrower](const std::string& Item)
+                {
+                    [[unlikely]] if(SlotMapTestValue(Item) == Thrower)
+                    {
+                        throw std::runtime_error("task");
+                    }
+
+                    Visited.fetch_add(1, std::memory_order_relaxed);
+                }, 16, Threads);
+            }
+            catch(const std::runtime_error&)
+            {
+                Threw = true;
+            }
+
+            SLOTMAP_CHECK(Threw);
+            SLOTMAP_CHECK(Visited.load() < Map.Size());
+        }
+
+        //the map is untouched and can run again
+        std::atomic<int64_t> Visited{0};
+        Map.ParallelForEach([&Visited](std::string&) { Visited.fetch_add(1, std::memory_order_relaxed); }, 16, Threads);
+        SLOTMAP_CHECK(Visited.load() == Map.Size());
+
+        //the default dispatch with one thread per hardware thread
+        Visited.store(0);
+        Map.ParallelForEach([&Visited](std::string&) { Visited.fetch_add(1, std::memory_order_relaxed); });
+        SLOTMAP_CHECK(Visited.load() == Map.Size());
+    }
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        TestVisits<int>(Seed);
+        TestVisits<std::string>(Seed);
+    }
+
+    TestCustomDispatch();
+    TestThrowingTask();
+
+    return SlotMapTestResult("slotmap_parallel_test");
+}
@@ -0,0 +1,458 @@
+/**
+ * serializes maps with pending removals, retired keys and running migrations, loads them back with Deserialize and MapFromFile
+ * and checks that the copy holds the same items under the same handles and keeps handing out the same handles afterwards.
+ * truncated and corrupted files have to be rejected or load into a map that stays consistent.
+ * also moves and swaps such maps, handles have to follow the arrays into whichever map holds them
+ */
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#if SLOTMAP_HAS_MMAP
+#include <unistd.h>
+#endif
+
+namespace
+{
+    using Buffer = std::vector<char>;
+
+    template<typename MapT>
+    Buffer Save(const MapT& Map)
+    {
+        Buffer Data;
+        Map.Serialize([&Data](const void* Bytes, size_t Size) { Data.insert(Data.end(), static_cast<const char*>(Bytes), static_cast<const char*>(Bytes) + Size); });
+        return Data;
+    }
+
+    template<typename MapT>
+    bool Load(MapT& Map, const Buffer& Data)
+    {
+        size_t Offset = 0;
+
+        return Map.Deserialize([&Data, &Offset](void* Bytes, size_t Size)
+        {
+            [[unlikely]] if(Size > Data.size() - Offset)
+            {
+                return false;
+            }
+
+            std::memcpy(Bytes, Data.data() + Offset, Size);
+            Offset += Size;
+            return true;
+        });
+    }
+
+    template<typename MapT>
+    void CheckSameContents(const MapT& Map, const MapT& Copy)
+    {
+        SLOTMAP_CHECK(Copy.Size() == Map.Size());
+        SLOTMAP_CHECK(Copy.PendingRemovals() == Map.PendingRemovals());
+
+        int64_t EntryCount = 0;
+
+        for(auto [Handle, Item] : Map.Entries())
+        {
+            const auto* Copied = Copy[Handle];
+            SLOTMAP_CHECK(Copied != nullptr && *Copied == Item);
+            EntryCount += 1;
+        }
+
+        for(auto [Handle, Item] : Copy.Entries())
+        {
+            SLOTMAP_CHECK(Map.IsValidHandle(Handle));
+            EntryCount -= 1;
+        }
+
+        SLOTMAP_CHECK(EntryCount == 0);
+    }
+
+    //runs the same operations on both maps, the restored one has to hand out the same handles as the original
+    template<typename MapT>
+    void CheckSameBehavior(MapT& Map, MapT& Copy, uint32_t Seed)
+    {
+        std::mt19937 Random(Seed);
+        std::vector<typename MapT::KeyHandle> Handles;
+
+        for(auto [Handle, Item] : Map.Entries())
+        {
+            Handles.push_back(Handle);
+        }
+
+        for(int Step = 0; Step < 2000; ++Step)
+        {
+            const uint32_t Operation = Random() % 4;
+
+            if(Operation < 2 || Handles.empty())
+            {
+                const auto Handle = Map.Add(Step);
+                SLOTMAP_CHECK(Copy.Add(Step) == Handle);
+                Handles.push_back(Handle);
+            }
+            else
+            {
+                const size_t Position = Random() % Handles.size();
+                SLOTMAP_CHECK(Map.Remove(Handles[Position]) == Copy.Remove(Handles[Position]));
+
+                Handles[Position] = Handles.back();
+                Handles.pop_back();
+            }
+        }
+
+        Map.Flush();
+        Copy.Flush();
+
+        CheckSameContents(Map, Copy);
+    }
+
+    template<typename MapT>
+    MapT MakeMap(uint32_t Seed, int Steps)
+    {
+        MapT Map;
+        std::mt19937 Random(Seed);
+        std::vector<typename MapT::KeyHandle> Handles;
+
+        for(int Step = 0; Step < Steps; ++Step)
+        {
+            const uint32_t Operation = Random() % 8;
+
+            if(Operation < 4 || Handles.empty())
+            {
+                Handles.push_back(Map.Add(Step));
+            }
+            else
+            {
+                const size_t Position = Random() % Handles.size();
+
+                if(Operation < 6)
+                {
+                    SLOTMAP_CHECK(Map.Remove(Handles[Position]));
+                }
+                else
+                {
+                    SLOTMAP_CHECK(Map.MarkRemoved(Handles[Position]));
+                }
+
+                Handles[Position] = Handles.back();
+                Handles.pop_back();
+            }
+        }
+
+        return Map;
+    }
+
+    template<typename MapT>
+    void TestRoundTrip(MapT& Map, uint32_t Seed)
+    {
+        const Buffer Data = Save(Map);
+
+        MapT Copy;
+        Copy.Add(-1); //loading replaces what was there
+        SLOTMAP_CHECK(Load(Copy, Data));
+
+        CheckSameContents(Map, Copy);
+        SLOTMAP_CHECK(Save(Copy) == Data);
+
+        CheckSameBehavior(Map, Copy, Seed);
+    }
+
+    template<typename Traits>
+    void TestRejected(const Buffer& Data)
+    {
+        SlotMap<int64_t, Traits> Map;
+        const auto Handle = Map.Add(7);
+
+        //Deserialize reads the padding past the last item as well, cutting into the padding or that item has to fail
+        const size_t ItemsEnd = Data.size() - Traits::ItemPaddingBytes;
+
+        for(size_t Size : {size_t(0), size_t(1), size_t(63), Data.size() / 2, ItemsEnd - 1, ItemsEnd, Data.size() - 1})
+        {
+            SLOTMAP_CHECK(!Load(Map, Buffer(Data.begin(), Data.begin() + Size)));
+        }
+
+        Buffer BadMagic = Data;
+        BadMagic[0] ^= 1;
+        SLOTMAP_CHECK(!Load(Map, BadMagic));
+
+        //a failed load leaves the map as it was
+        SLOTMAP_CHECK(Map.Size() == 1 && Map[Handle] != nullptr && *Map[Handle] == 7);
+    }
+
+    //two maps written trough one writer load back in order trough one reader, each Deserialize consumes exactly what its Serialize wrote
+    template<typename MapT>
+    void TestConsecutive(uint32_t Seed)
+    {
+        const MapT First = MakeMap<MapT>(Seed, 700);
+        const MapT Second = MakeMap<MapT>(Seed + 100, 300);
+
+        Buffer Data;
+        auto Writer = [&Data](const void* Bytes, size_t Size) { Data.insert(Data.end(), static_cast<const char*>(Bytes), static_cast<const char*>(Bytes) + Size); };
+
+        First.Serialize(Writer);
+        const size_t FirstSize = Data.size();
+        Second.Serialize(Writer);
+
+        size_t Offset = 0;
+
+        auto Reader = [&Data, &Offset](void* Bytes, size_t Size)
+        {
+            [[unlikely]] if(Size > Data.size() - Offset)
+            {
+                return false;
+            }
+
+            std::memcpy(Bytes, Data.data() + Offset, Size);
+            Offset += Size;
+            return true;
+        };
+
+        MapT FirstCopy;
+        MapT SecondCopy;
+
+        SLOTMAP_CHECK(FirstCopy.Deserialize(Reader) && Offset == FirstSize);
+        SLOTMAP_CHECK(SecondCopy.Deserialize(Reader) && Offset == Data.size());
+
+        CheckSameContents(First, FirstCopy);
+        CheckSameContents(Second, SecondCopy);
+    }
+
+    //a corrupted file may still pass the checks, then the map it loads into has to keep working
+    template<typename MapT>
+    void TestCorrupted(const Buffer& Data, uint32_t Seed)
+    {
+        std::mt19937 Random(Seed);
+
+        for(int Trial = 0; Trial < 500; ++Trial)
+        {
+            Buffer Corrupted = Data;
+
+            for(uint32_t Flips = 1 + Random() % 3; Flips > 0; --Flips)
+            {
+                Corrupted[Random() % Corrupted.size()] ^= static_cast<char>(1 << (Random() % 8));
+            }
+
+            MapT Map;
+
+            if(!Load(Map, Corrupted))
+            {
+                continue;
+            }
+
+            for(int Index = 0; Index < 100; ++Index)
+            {
+                Map.Add(Index);
+            }
+
+            Map.Flush();
+
+            std::vector<typename MapT::KeyHandle> Handles;
+
+            for(auto [Handle, Item] : Map.Entries())
+            {
+                SLOTMAP_CHECK(Map[Handle] == &Item);
+                Handles.push_back(Handle);
+            }
+
+            SLOTMAP_CHECK(std::ssize(Handles) == Map.Size());
+
+            for(size_t Index = 0; Index < Handles.size(); Index += 2)
+            {
+                SLOTMAP_CHECK(Map.Remove(Handles[Index]));
+            }
+        }
+    }
+
+    /**
+     * moves Map away and back, swaps it with another map and reuses the moved-from maps, every handle has to keep finding its item in whichever map holds it.
+     * a running migration and a file mapping move along with the arrays
+     */
+    template<typename MapT>
+    void TestMoves(MapT& Map, uint32_t Seed)
+    {
+        const MapT Reference = Map.Clone();
+        const bool WasMigrating = Map.IsMigrating();
+        const bool WasMapped = Map.IsMapped();
+
+        MapT Moved(std::move(Map));
+        SLOTMAP_CHECK(Moved.IsMigrating() == WasMigrating && Moved.IsMapped() == WasMapped);
+        SLOTMAP_CHECK(Map.Size() == 0 && !Map.IsMigrating() && !Map.IsMapped());
+        CheckSameContents(Reference, Moved);
+
+        //the moved-from map is empty and usable, its handles don't reach into the moved map
+        std::vector<typename MapT::KeyHandle> Reused;
+
+        for(int Index = 0; Index < 300; ++Index)
+        {
+            Reused.push_back(Map.Add(-Index));
+        }
+
+        for(size_t Index = 0; Index < Reused.size(); Index += 2)
+        {
+            SLOTMAP_CHECK(Map.Remove(Reused[Index]));
+        }
+
+        CheckSameContents(Reference, Moved);
+
+        const MapT ReusedReference = Map.Clone();
+
+        Moved.Swap(Map);
+        CheckSameContents(Reference, Map);
+        CheckSameContents(ReusedReference, Moved);
+        SLOTMAP_CHECK(Map.IsMigrating() == WasMigrating && Map.IsMapped() == WasMapped);
+
+        swap(Map, Moved);
+        CheckSameContents(Reference, Moved);
+        CheckSameContents(ReusedReference, Map);
+
+        //assigning over the reused map frees what it held
+        Map = std::move(Moved);
+        SLOTMAP_CHECK(Map.IsMigrating() == WasMigrating && Map.IsMapped() == WasMapped);
+        SLOTMAP_CHECK(Moved.Size() == 0);
+        CheckSameContents(Reference, Map);
+
+        Moved = MakeMap<MapT>(Seed + 200, 300);
+        SLOTMAP_CHECK(Moved.Size() > 0);
+
+        //and the map keeps handing out the same handles as before the moves
+        MapT Original = Reference.Clone();
+        CheckSameBehavior(Original, Map, Seed);
+    }
+
+#if SLOTMAP_HAS_MMAP
+    template<typename MapT>
+    void TestMapFromFile(MapT& Map, uint32_t Seed)
+    {
+        char Path[] = "/tmp/slotmap_serialize_test_XXXXXX";
+        const int File = mkstemp(Path);
+        SLOTMAP_CHECK(File >= 0);
+
+        if(File < 0)
+        {
+            return;
+        }
+
+        const Buffer Data = Save(Map);
+        SLOTMAP_CHECK(write(File, Data.data(), Data.size()) == std::ssize(Data));
+        close(File);
+
+        {
+            MapT Copy;
+            SLOTMAP_CHECK(Copy.MapFromFile(Path));
+            SLOTMAP_CHECK(Copy.IsMapped());
+
+            CheckSameContents(Map, Copy);
+
+            MapT Original = Map.Clone();
+            CheckSameBehavior(Original, Copy, Seed); //grows past the mapping which copies it out
+        }
+
+        {
+            MapT Copy;
+            SLOTMAP_CHECK(Copy.MapFromFile(Path));
+            TestMoves(Copy, Seed);
+        }
+
+        SLOTMAP_CHECK(truncate(Path, static_cast<off_t>(Data.size() / 2)) == 0);
+
+        MapT Truncated;
+        SLOTMAP_CHECK(!Truncated.MapFromFile(Path));
+        SLOTMAP_CHECK(!Truncated.IsMapped());
+
+        unlink(Path);
+    }
+#endif
+
+    template<typename Traits>
+    void RunTraits(uint32_t Seed)
+    {
+        using MapT = SlotMap<int64_t, Traits>;
+
+        MapT Empty;
+        TestRoundTrip(Empty, Seed);
+
+        MapT Map = MakeMap<MapT>(Seed, 3000);
+        TestRoundTrip(Map, Seed);
+        TestMoves(Map, Seed);
+
+        const Buffer Data = Save(MakeMap<MapT>(Seed, 600));
+        TestRejected<Traits>(Data);
+        TestCorrupted<MapT>(Data, Seed);
+        TestConsecutive<MapT>(Seed);
+
+#if SLOTMAP_HAS_MMAP
+        MapT Mapped = MakeMap<MapT>(Seed, 3000);
+        TestMapFromFile(Mapped, Seed);
+#endif
+    }
+
+    //few ID bits so keys retire and show up in the file
+    struct SplitGenerationTraits : SlotMapDefaultTraits
+    {
+        using KeyStorageT = uint32_t;
+        static constexpr int64_t IndexBits = 24;
+        static constexpr int64_t IdBits = 3;
+        static constexpr int64_t MinFreeKeys = 4;
+        static constexpr bool SplitGenerations = true;
+    };
+
+    struct ShiftTraits : SlotMapDefaultTraits
+    {
+        static constexpr SlotMapRemovalPolicy RemovalPolicy = SlotMapRemovalPolicy::Shift;
+    };
+
+    struct MigrationTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+        static constexpr int64_t MigrationBudget = 2;
+    };
+
+    //a map serialized while its items are spread over two arrays has to load like one that is not migrating
+    void TestMigrating(uint32_t Seed)
+    {
+        using MapT = SlotMap<int64_t, MigrationTraits>;
+
+        MapT Map = MakeMap<MapT>(Seed, 400);
+        Map.Reserve(Map.Capacity() * 4);
+        SLOTMAP_CHECK(Map.IsMigrating());
+
+        const Buffer Data = Save(Map);
+        SLOTMAP_CHECK(Map.IsMigrating()); //serializing reads both arrays and completes nothing
+
+        MapT Copy;
+        SLOTMAP_CHECK(Load(Copy, Data));
+        SLOTMAP_CHECK(!Copy.IsMigrating());
+
+        CheckSameContents(Map, Copy);
+        CheckSameBehavior(Map, Copy, Seed);
+
+        MapT Moving = MakeMap<MapT>(Seed, 400);
+        Moving.Reserve(Moving.Capacity() * 4);
+        SLOTMAP_CHECK(Moving.IsMigrating());
+        TestMoves(Moving, Seed);
+
+#if SLOTMAP_HAS_MMAP
+        MapT Mapped = MakeMap<MapT>(Seed, 400);
+        Mapped.Reserve(Mapped.Capacity() * 4);
+        TestMapFromFile(Mapped, Seed);
+#endif
+    }
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        RunTraits<SlotMapDefaultTraits>(Seed);
+        RunTraits<SplitGenerationTraits>(Seed);
+        RunTraits<ShiftTraits>(Seed);
+        RunTraits<MigrationTraits>(Seed);
+        TestMigrating(Seed);
+    }
+
+    return SlotMapTestResult("slotmap_serialize_test");
+}
@@ -0,0 +1,225 @@
+/**
+ * sorts and reorders SlotMaps with pending removals and running migrations, then checks the dense order and that every handle still finds
+ * its own item, for trivially copyable and heap owning items. debug builds have to reject an order that lists an index twice
+ */
+
+#include <stdexcept>
+
+//failed asserts throw so the test can check that ReorderBy rejects an order that is not a permutation
+#define SLOTMAP_ASSERT(expr, ...) ((expr) ? void() : throw std::logic_error(#expr))
+
+#include "slotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    template<typename ItemT, typename Traits>
+    void TestSort(uint32_t Seed)
+    {
+        using MapT = SlotMap<ItemT, Traits>;
+        using KeyHandle = typename MapT::KeyHandle;
+
+        std::mt19937 Random(Seed);
+
+        MapT Map;
+        std::unordered_map<KeyHandle, int> Live;
+        std::vector<KeyHandle> Stale;
+
+        for(int Index = 0; Index < 3000; ++Index)
+        {
+            const int Value = static_cast<int>(Random() % 1000); //duplicates on purpose
+            Live.emplace(Map.Add(SlotMapTestItem<ItemT>(Value)), Value);
+        }
+
+        //some removals stay pending, Sort has to flush them first
+        for(auto Entry = Live.begin(); Entry != Live.end();)
+        {
+            const uint32_t Operation = Random() % 6;
+
+            if(Operation < 2)
+            {
+                SLOTMAP_CHECK(Operation == 0 ? Map.Remove(Entry->first) : Map.MarkRemoved(Entry->first));
+                Stale.push_back(Entry->first);
+                Entry = Live.erase(Entry);
+            }
+            else
+            {
+                ++Entry;
+            }
+        }
+
+        auto CheckHandles = [&]()
+        {
+            SLOTMAP_CHECK(Map.Size() == std::ssize(Live) && Map.PendingRemovals() == 0);
+
+            for(const auto& [Handle, Value] : Live)
+            {
+                const ItemT* Item = Map[Handle];
+                SLOTMAP_CHECK(Item != nullptr && SlotMapTestValue(*Item) == Value);
+            }
+
+            for(KeyHandle Handle : Stale)
+            {
+                SLOTMAP_CHECK(!Map.IsValidHandle(Handle));
+            }
+
+            for(int64_t Index = 0; Index < Map.Size(); ++Index)
+            {
+                SLOTMAP_CHECK(Map[Map.GetHandle(Index)] == &Map[Index]);
+            }
+        };
+
+        auto ByValue = [](const ItemT& Left, const ItemT& Right)
+        {
+            return SlotMapTestValue(Left) < SlotMapTestValue(Right);
+        };
+
+        Map.Sort(ByValue);
+
+        CheckHandles();
+        SLOTMAP_CHECK(std::is_sorted(Map.begin(), Map.end(), ByValue));
+
+        //descending, so every item moves again
+        Map.Sort([&ByValue](const ItemT& Left, const ItemT& Right) { return ByValue(Right, Left); });
+
+        CheckHandles();
+        SLOTMAP_CHECK(std::is_sorted(Map.begin(), Map.end(), [&ByValue](const ItemT& Left, const ItemT& Right) { return ByValue(Right, Left); }));
+
+        //a random permutation, the item at Order[Index] has to end up at Index
+        std::vector<KeyHandle> Before;
+
+        for(int64_t Index = 0; Index < Map.Size(); ++Index)
+        {
+            Before.push_back(Map.GetHandle(Index));
+        }
+
+        std::vector<int64_t> Order(Map.Size());
+        std::iota(Order.begin(), Order.end(), int64_t(0));
+        std::shuffle(Order.begin(), Order.end(), Random);
+
+        Map.ReorderBy(Order);
+
+        CheckHandles();
+
+        for(int64_t Index = 0; Index < Map.Size(); ++Index)
+        {
+            SLOTMAP_CHECK(Map.GetHandle(Index) == Before[Order[Index]]);
+        }
+
+        //the map keeps working after reordering
+        for(int Index = 0; Index < 500; ++Index)
+        {
+            Live.emplace(Map.Add(SlotMapTestItem<ItemT>(Index)), Index);
+        }
+
+        for(int Index = 0; Index < 200; ++Index)
+        {
+            const KeyHandle Handle = Map.GetHandle(int64_t(Random() % Map.Size()));
+            SLOTMAP_CHECK(Map.Remove(Handle));
+            Live.erase(Handle);
+            Stale.push_back(Handle);
+        }
+
+        CheckHandles();
+    }
+
+#ifndef NDEBUG
+    //debug builds catch an index listed twice before the reordering loops on it
+    void TestNotPermutation()
+    {
+        for(int64_t Duplicate : {0, 17, 63})
+        {
+            SlotMap<int> Map;
+
+            for(int Index = 0; Index < 64; ++Index)
+            {
+                Map.Add(Index);
+            }
+
+            std::vector<int64_t> Order(Map.Size());
+            std::iota(Order.begin(), Order.end(), int64_t(0));
+            std::reverse(Order.begin(), Order.end());
+            Order[(Duplicate + 5) % 64] = Order[Duplicate];
+
+            bool Threw = false;
+
+            try
+            {
+                Map.ReorderBy(Order);
+            }
+            catch(const std::logic_error&)
+            {
+                Threw = true;
+            }
+
+            SLOTMAP_CHECK(Threw);
+        }
+    }
+#endif
+
+    //the default comparison sorts by the items themselves
+    void TestDefaultCompare()
+    {
+        SlotMap<int> Map;
+
+        for(int Value : {5, 3, 9, 1, 7})
+        {
+            Map.Add(Value);
+        }
+
+        Map.Sort();
+        SLOTMAP_CHECK(std::ranges::equal(Map, std::vector<int>{1, 3, 5, 7, 9}));
+
+        SlotMap<int> Empty;
+        Empty.Sort();
+        SLOTMAP_CHECK(Empty.Size() == 0);
+    }
+
+    struct CacheGenerationTraits : SlotMapDefaultTraits
+    {
+        static constexpr bool CacheGenerations = true;
+    };
+
+    struct SplitGenerationTraits : SlotMapDefaultTraits
+    {
+        using KeyStorageT = uint32_t;
+        static constexpr int64_t IndexBits = 20;
+        static constexpr int64_t IdBits = 12;
+        static constexpr bool SplitGenerations = true;
+    };
+
+    struct ShiftMigrationTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+        static constexpr int64_t MigrationBudget = 2;
+        static constexpr SlotMapRemovalPolicy RemovalPolicy = SlotMapRemovalPolicy::Shift;
+    };
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        TestSort<int, SlotMapDefaultTraits>(Seed);
+        TestSort<std::string, SlotMapDefaultTraits>(Seed);
+        TestSort<int, CacheGenerationTraits>(Seed);
+        TestSort<std::string, CacheGenerationTraits>(Seed);
+        TestSort<int, SplitGenerationTraits>(Seed);
+        TestSort<std::string, ShiftMigrationTraits>(Seed);
+    }
+
+    TestDefaultCompare();
+
+#ifndef NDEBUG
+    TestNotPermutation();
+#endif
+
+    return SlotMapTestResult("slotmap_sort_test");
+}
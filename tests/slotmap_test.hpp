@@ -0,0 +1,230 @@
+#ifndef SLOTMAP_TEST_HPP
+#define SLOTMAP_TEST_HPP
+
+#include "slotmap.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+//minimal checks shared by the tests, a failed check is reported and the test keeps going so one run shows every failure. checks may run on any thread
+inline std::atomic<int> SlotMapTestFailures = 0;
+
+#define SLOTMAP_CHECK(Condition) \
+    do \
+    { \
+        [[unlikely]] if(!(Condition)) \
+        { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition); \
+            SlotMapTestFailures += 1; \
+        } \
+    } while(0)
+
+//returns the exit code of the test
+inline int SlotMapTestResult(const char* Name)
+{
+    const int Failures = SlotMapTestFailures.load();
+    std::printf("%s: %s\n", Name, Failures == 0 ? "passed" : ("failed " + std::to_string(Failures) + " checks").c_str());
+    return Failures == 0 ? 0 : 1;
+}
+
+//the item a test stores for Value, strings are long enough to live on the heap so a lost or doubled destructor shows up under the sanitizers
+template<typename ItemT>
+ItemT SlotMapTestItem(int Value)
+{
+    if constexpr(std::is_same_v<ItemT, std::string>)
+    {
+        return std::string(24, '#') + std::to_string(Value);
+    }
+    else
+    {
+        return ItemT(Value);
+    }
+}
+
+//the Value an item made by SlotMapTestItem was made from
+template<typename ItemT>
+int SlotMapTestValue(const ItemT& Item)
+{
+    if constexpr(std::is_same_v<ItemT, std::string>)
+    {
+        return std::stoi(Item.substr(24));
+    }
+    else
+    {
+        return static_cast<int>(Item);
+    }
+}
+
+/**
+ * base of the model tests: a map and an std::unordered_map from its handles to the values they have to find.
+ * DerivedT implements Step with its own operations, keeps the model in sync trough Track and Forget and checks the map in CheckAll,
+ * Run calls both
+ */
+template<typename DerivedT, typename MapT>
+class SlotMapModelTest
+{
+public:
+    using KeyHandle = typename MapT::KeyHandle;
+
+    explicit SlotMapModelTest(uint32_t Seed)
+        : Random(Seed)
+    {
+    }
+
+    void Run(int Steps, int CheckInterval = 64)
+    {
+        DerivedT& Derived = static_cast<DerivedT&>(*this);
+
+        for(int Step = 0; Step < Steps; ++Step)
+        {
+            Derived.Step();
+
+            if(Step % CheckInterval == 0)
+            {
+                Derived.CheckAll();
+            }
+        }
+
+        Derived.CheckAll();
+    }
+
+protected:
+    MapT Map;
+    std::unordered_map<KeyHandle, int> Model;
+    std::vector<KeyHandle> Live; //the keys of Model for picking one at random
+    std::vector<KeyHandle> Stale;
+    std::mt19937 Random;
+    int NextValue = 0;
+
+    int64_t Pick(int64_t Count)
+    {
+        return std::uniform_int_distribution<int64_t>(0, Count - 1)(Random);
+    }
+
+    void Track(KeyHandle Handle, int Value)
+    {
+        SLOTMAP_CHECK(Handle != MapT::NullHandle);
+        SLOTMAP_CHECK(!Model.contains(Handle));
+
+        Model.emplace(Handle, Value);
+        Live.push_back(Handle);
+    }
+
+    //forgets the live handle at Position, it has to be invalid from now on
+    void Forget(int64_t Position)
+    {
+        Model.erase(Live[Position]);
+        Stale.push_back(Live[Position]);
+
+        Live[Position] = Live.back();
+        Live.pop_back();
+    }
+
+    //after the map was cleared
+    void ForgetAll()
+    {
+        while(!Live.empty())
+        {
+            Forget(std::ssize(Live) - 1);
+        }
+    }
+
+    //removes a random live handle, removing it again has to fail
+    void RemoveRandom()
+    {
+        const int64_t Position = Pick(std::ssize(Live));
+
+        SLOTMAP_CHECK(Map.Remove(Live[Position]));
+        SLOTMAP_CHECK(!Map.Remove(Live[Position]));
+
+        Forget(Position);
+    }
+
+    //a stale handle may only be valid again if its key got reused with the same ID, which takes a map with few ID bits
+    void CheckStale()
+    {
+        for(KeyHandle Handle : Stale)
+        {
+            SLOTMAP_CHECK(!Map.IsValidHandle(Handle) || Model.contains(Handle));
+        }
+    }
+};
+
+//few ID bits so keys retire quickly
+struct SlotMapTestRetiringTraits : SlotMapDefaultTraits
+{
+    using KeyStorageT = uint32_t;
+    static constexpr int64_t IndexBits = 24;
+    static constexpr int64_t IdBits = 3;
+    static constexpr int64_t AllocationSize = 16;
+};
+
+//the same with the IDs in their own array
+struct SlotMapTestSplitRetiringTraits : SlotMapTestRetiringTraits
+{
+    static constexpr bool SplitGenerations = true;
+};
+
+struct SlotMapTestFixedTraits : SlotMapDefaultTraits
+{
+    static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Fixed;
+};
+
+//retires keys of a map with SlotMapTestRetiringTraits, recycles them and checks that the recycled keys work. Get(Map, Handle) returns the int added for Handle
+template<typename MapT, typename GetT>
+void SlotMapTestRetiredKeys(GetT&& Get)
+{
+    MapT Map;
+
+    //the freelist is FIFO, every key gets its turn
+    for(int Round = 0; Round < 2000; ++Round)
+    {
+        Map.Remove(Map.Add(Round));
+    }
+
+    const int64_t Retired = Map.RetiredKeys();
+    SLOTMAP_CHECK(Retired > 0);
+    SLOTMAP_CHECK(Map.RecycleRetiredKeys() == Retired);
+    SLOTMAP_CHECK(Map.RetiredKeys() == 0);
+
+    std::vector<typename MapT::KeyHandle> Handles;
+
+    for(int Index = 0; Index < 100; ++Index)
+    {
+        Handles.push_back(Map.Add(Index));
+    }
+
+    for(int Index = 0; Index < 100; ++Index)
+    {
+        SLOTMAP_CHECK(Map.IsValidHandle(Handles[Index]) && Get(Map, Handles[Index]) == Index);
+    }
+}
+
+//Add constructs with braces, Emplace and TryEmplace like emplace_back. MapT holds std::vector<int>, where the two differ
+template<typename MapT>
+void SlotMapTestConstruction()
+{
+    MapT Map;
+
+    const auto Braced = Map.Add(3, 5);
+    const auto Single = Map.Add(4);
+    const auto Emplaced = Map.Emplace(3, 5);
+    const auto Tried = Map.TryEmplace(size_t(2));
+
+    std::vector<int> Source{1, 2, 3};
+    const auto Copied = Map.Add(Source);
+    const auto Moved = Map.Add(std::move(Source));
+
+    SLOTMAP_CHECK(*Map[Braced] == (std::vector<int>{3, 5}));
+    SLOTMAP_CHECK(*Map[Single] == (std::vector<int>{4}));
+    SLOTMAP_CHECK(*Map[Emplaced] == (std::vector<int>(3, 5)));
+    SLOTMAP_CHECK(*Map[Tried] == (std::vector<int>(2)));
+    SLOTMAP_CHECK(*Map[Copied] == (std::vector<int>{1, 2, 3}) && *Map[Moved] == (std::vector<int>{1, 2, 3}));
+}
+
+#endif //SLOTMAP_TEST_HPP
@@ -0,0 +1,174 @@
+/**
+ * joins slot maps that were filled under the same handles and then lost different items, some trough MarkRemoved without a Flush and one
+ * in the middle of an incremental migration, and checks that the query visits every handle valid in all maps exactly once with the items of that handle
+ */
+
+#include "slotmapquery.hpp"
+#include "slotmap_test.hpp"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    struct EntityTag;
+
+    struct MigrationTraits : SlotMapDefaultTraits
+    {
+        static constexpr int64_t AllocationSize = 16;
+        static constexpr int64_t MigrationBudget = 2;
+    };
+
+    using NumberMap = SlotMap<int64_t, SlotMapDefaultTraits, EntityTag>;
+    using TextMap = SlotMap<std::string, SlotMapDefaultTraits, EntityTag>;
+    using MigratingMap = SlotMap<int, MigrationTraits, EntityTag>;
+    using HandleT = NumberMap::KeyHandle;
+
+    //removes about Percent of the items of Map, marked items stay in the map as tombstones until a Flush that never comes
+    template<typename MapT>
+    void Thin(MapT& Map, const std::vector<HandleT>& Handles, uint32_t Percent, bool Mark, std::mt19937& Random)
+    {
+        for(HandleT Handle : Handles)
+        {
+            if(Random() % 100 < Percent)
+            {
+                SLOTMAP_CHECK(Mark ? Map.MarkRemoved(Handle) : Map.Remove(Handle));
+            }
+        }
+    }
+
+    void TestJoin(uint32_t Seed, int Count)
+    {
+        std::mt19937 Random(Seed);
+
+        NumberMap Numbers;
+        TextMap Texts;
+        MigratingMap Migrating;
+        std::vector<HandleT> Handles;
+        std::unordered_map<HandleT, int> Values;
+
+        //mirrored adds hand out the same handles in every map
+        for(int Index = 0; Index < Count; ++Index)
+        {
+            const HandleT Handle = Numbers.Add(int64_t(Index) * 7);
+            SLOTMAP_CHECK(Texts.Add(SlotMapTestItem<std::string>(Index)) == Handle);
+            SLOTMAP_CHECK(Migrating.Add(Index) == Handle);
+
+            Handles.push_back(Handle);
+            Values.emplace(Handle, Index);
+        }
+
+        Migrating.Reserve(Migrating.Size() * 4 + 64); //only allocates, the items move over during the removals
+
+        //the map with the smallest Size drives the join and tombstones count towards it, rotating how much each map loses lets every map drive for some seeds
+        const uint32_t Percents[] = {10, 40, 70};
+
+        Thin(Numbers, Handles, Percents[Seed % 3], false, Random);
+        Thin(Texts, Handles, Percents[(Seed + 1) % 3], Seed % 2 == 1, Random);
+        Thin(Migrating, Handles, Percents[(Seed + 2) % 3], Seed % 2 == 0, Random);
+
+        if(!Migrating.IsMigrating()) //the removals moved every item over, join during the next migration
+        {
+            Migrating.Reserve(Migrating.Capacity() * 2 + 64);
+        }
+
+        SLOTMAP_CHECK(Count < 1000 || Migrating.IsMigrating());
+        SLOTMAP_CHECK(Count < 1000 || Texts.PendingRemovals() + Migrating.PendingRemovals() != 0);
+
+        std::unordered_set<HandleT> Expected;
+
+        for(HandleT Handle : Handles)
+        {
+            if(Numbers.IsValidHandle(Handle) && Texts.IsValidHandle(Handle) && Migrating.IsValidHandle(Handle))
+            {
+                Expected.insert(Handle);
+            }
+        }
+
+        std::unordered_set<HandleT> Visited;
+        const MigratingMap& ConstMigrating = Migrating;
+
+        SlotMapQuery Query(Numbers, Texts, ConstMigrating);
+        SLOTMAP_CHECK(Query.DriverSize() == std::min({Numbers.Size(), Texts.Size(), Migrating.Size()}));
+
+        Query.ForEach([&](int64_t& Number, std::string& Text, const int& Value, HandleT Handle)
+        {
+            SLOTMAP_CHECK(Expected.contains(Handle));
+            SLOTMAP_CHECK(Visited.insert(Handle).second);
+
+            auto Found = Values.find(Handle);
+            SLOTMAP_CHECK(Found != Values.end() && Value == Found->second);
+            SLOTMAP_CHECK(Number == int64_t(Value) * 7 && Text == SlotMapTestItem<std::string>(Value));
+            SLOTMAP_CHECK(Numbers[Handle] == &Number && Texts[Handle] == &Text && ConstMigrating[Handle] == &Value);
+
+            Number += 1; //items are writable trough non const maps
+        });
+
+        SLOTMAP_CHECK(Visited.size() == Expected.size());
+
+        //without the handle parameter, and the writes of the first pass are seen
+        int64_t Matches = 0;
+
+        SlotMapQuery(Migrating, Numbers).ForEach([&Matches](int& Value, int64_t& Number)
+        {
+            SLOTMAP_CHECK(Number == int64_t(Value) * 7 + 1 || Number == int64_t(Value) * 7);
+            Matches += 1;
+        });
+
+        int64_t Both = 0;
+
+        for(HandleT Handle : Handles)
+        {
+            Both += Numbers.IsValidHandle(Handle) && Migrating.IsValidHandle(Handle);
+        }
+
+        SLOTMAP_CHECK(Matches == Both);
+    }
+
+    //a map joined with itself yields every item, an empty map yields nothing
+    void TestEdges()
+    {
+        NumberMap Numbers;
+        TextMap Empty;
+
+        for(int Index = 0; Index < 200; ++Index)
+        {
+            Numbers.Add(Index);
+        }
+
+        int64_t Visited = 0;
+
+        SlotMapQuery(Numbers, Numbers).ForEach([&Visited](int64_t& Left, int64_t& Right)
+        {
+            SLOTMAP_CHECK(&Left == &Right);
+            Visited += 1;
+        });
+
+        SLOTMAP_CHECK(Visited == 200);
+
+        SlotMapQuery(Numbers, Empty).ForEach([](int64_t&, std::string&)
+        {
+            SLOTMAP_CHECK(false);
+        });
+    }
+}
+
+int main()
+{
+    const int Counts[] = {0, 1, 63, 64, 65, 129, 1000, 5000};
+
+    for(uint32_t Seed = 1; Seed <= 6; ++Seed)
+    {
+        for(int Count : Counts)
+        {
+            TestJoin(Seed, Count);
+        }
+    }
+
+    TestEdges();
+
+    return SlotMapTestResult("slotmapquery_test");
+}
@@ -0,0 +1,159 @@
+/**
+ * runs random adds and removes on a SoASlotMap and an std::unordered_map from handles to values and checks that both agree and that
+ * every column stays in the same dense order. also covers retiring and recycling keys, Clear, a throwing column and a fixed capacity
+ */
+
+#include "soaslotmap.hpp"
+#include "slotmap_test.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    template<typename Traits>
+    class ModelTest : public SlotMapModelTest<ModelTest<Traits>, SoASlotMap<std::tuple<int64_t, std::string>, Traits>>
+    {
+        using Base = SlotMapModelTest<ModelTest, SoASlotMap<std::tuple<int64_t, std::string>, Traits>>;
+        using Base::Map, Base::Model, Base::Live, Base::NextValue;
+
+    public:
+        using Base::Base;
+
+        void Step()
+        {
+            const int64_t Operation = this->Pick(16);
+
+            if(Operation < 8 || Live.empty())
+            {
+                const int Value = NextValue++;
+                this->Track(Map.Add(int64_t(Value), SlotMapTestItem<std::string>(Value)), Value);
+            }
+            else if(Operation < 15)
+            {
+                this->RemoveRandom();
+            }
+            else
+            {
+                Map.Clear(this->Pick(2) == 0);
+                this->ForgetAll();
+            }
+        }
+
+        void CheckAll()
+        {
+            SLOTMAP_CHECK(Map.Size() == std::ssize(Model));
+
+            for(const auto& [Handle, Value] : Model)
+            {
+                const int64_t* Number = Map.template Get<0>(Handle);
+                const std::string* Text = Map.template Get<1>(Handle);
+
+                SLOTMAP_CHECK(Number != nullptr && *Number == Value);
+                SLOTMAP_CHECK(Text != nullptr && *Text == SlotMapTestItem<std::string>(Value));
+
+                const int64_t Index = Map.IndexOf(Handle);
+                SLOTMAP_CHECK(Index >= 0 && Map.GetHandle(Index) == Handle);
+            }
+
+            this->CheckStale();
+
+            //both columns list the items in the same dense order
+            const auto Numbers = Map.template GetColumn<0>();
+            const auto Texts = Map.template GetColumn<1>();
+            SLOTMAP_CHECK(std::ssize(Numbers) == Map.Size() && std::ssize(Texts) == Map.Size());
+
+            for(int64_t Index = 0; Index < std::ssize(Numbers); ++Index)
+            {
+                SLOTMAP_CHECK(Texts[Index] == SlotMapTestItem<std::string>(static_cast<int>(Numbers[Index])));
+                SLOTMAP_CHECK(Model[Map.GetHandle(Index)] == Numbers[Index]);
+            }
+
+            SLOTMAP_CHECK(Map.Size() + Map.RetiredKeys() < Map.KeyCapacity());
+        }
+    };
+
+    struct GeometricTraits : SlotMapDefaultTraits
+    {
+        static constexpr SlotMapGrowthPolicy GrowthPolicy = SlotMapGrowthPolicy::Geometric;
+        static constexpr double ShrinkThreshold = 0.25;
+        static constexpr int64_t AllocationSize = 16;
+    };
+
+    struct ThrowingColumn
+    {
+        int Value;
+
+        explicit ThrowingColumn(int InValue)
+            : Value(InValue)
+        {
+            [[unlikely]] if(InValue < 0)
+            {
+                throw std::runtime_error("column");
+            }
+        }
+    };
+
+    //a throwing column destroys the columns built before it and leaves the map as it was
+    void TestThrowingColumn()
+    {
+        SoASlotMap<std::tuple<std::string, ThrowingColumn>> Map;
+        const auto Handle = Map.Add(std::string(32, 'a'), 1);
+
+        bool Threw = false;
+
+        try
+        {
+            Map.Add(std::string(32, 'b'), -1);
+        }
+        catch(const std::runtime_error&)
+        {
+            Threw = true;
+        }
+
+        SLOTMAP_CHECK(Threw);
+        SLOTMAP_CHECK(Map.Size() == 1);
+
+        const auto Next = Map.Add(std::string(32, 'c'), 2);
+        SLOTMAP_CHECK(Map.IsValidHandle(Handle) && Map.IsValidHandle(Next));
+        SLOTMAP_CHECK(Map.Get<1>(Next)->Value == 2 && *Map.Get<0>(Handle) == std::string(32, 'a'));
+    }
+
+    void TestFixedCapacity()
+    {
+        SoASlotMap<std::tuple<int, float>, SlotMapTestFixedTraits> Map;
+        SLOTMAP_CHECK(Map.TryEmplace(1, 1.0f) == Map.NullHandle);
+
+        Map.Reserve(8);
+
+        int64_t Added = 0;
+
+        while(Map.TryEmplace(static_cast<int>(Added), 0.0f) != Map.NullHandle)
+        {
+            Added += 1;
+        }
+
+        SLOTMAP_CHECK(Added == 8 && Map.Size() == 8);
+
+        Map.Remove(uint64_t(0));
+        SLOTMAP_CHECK(Map.TryEmplace(9, 9.0f) != Map.NullHandle);
+    }
+}
+
+int main()
+{
+    for(uint32_t Seed = 1; Seed <= 3; ++Seed)
+    {
+        ModelTest<SlotMapDefaultTraits>(Seed).Run(6000);
+        ModelTest<SlotMapTestRetiringTraits>(Seed).Run(6000);
+        ModelTest<SlotMapTestSplitRetiringTraits>(Seed).Run(6000);
+        ModelTest<GeometricTraits>(Seed).Run(6000);
+    }
+
+    SlotMapTestRetiredKeys<SoASlotMap<std::tuple<int>, SlotMapTestRetiringTraits>>([](auto& Map, auto Handle) { return *Map.template Get<0>(Handle); });
+    SlotMapTestRetiredKeys<SoASlotMap<std::tuple<int>, SlotMapTestSplitRetiringTraits>>([](auto& Map, auto Handle) { return *Map.template Get<0>(Handle); });
+    TestThrowingColumn();
+    TestFixedCapacity();
+
+    return SlotMapTestResult("soaslotmap_test");
+}